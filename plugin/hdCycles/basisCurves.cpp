@@ -36,6 +36,8 @@
 #include <pxr/base/gf/vec2f.h>
 #include <pxr/base/gf/vec3f.h>
 #include <pxr/base/gf/vec3i.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/imaging/hd/perfLog.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 
 #ifdef USE_USD_CYCLES_SCHEMA
@@ -48,6 +50,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 // clang-format off
 TF_DEFINE_PRIVATE_TOKENS(_tokens,
     ((cyclesCurveResolution, "cycles:object:curve_resolution"))
+    (accelerations)
 );
 // clang-format on
 
@@ -72,6 +75,7 @@ HdCyclesBasisCurves::HdCyclesBasisCurves(
 {
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
     config.enable_motion_blur.eval(m_useMotionBlur, true);
+    config.motion_steps.eval(m_motionSteps, true);
 
     m_cyclesObject = _CreateObject();
     m_renderDelegate->GetCyclesRenderParam()->AddObject(m_cyclesObject);
@@ -79,17 +83,13 @@ HdCyclesBasisCurves::HdCyclesBasisCurves(
 
 HdCyclesBasisCurves::~HdCyclesBasisCurves()
 {
-    if (m_cyclesHair) {
-        m_renderDelegate->GetCyclesRenderParam()->RemoveCurve(m_cyclesHair);
-        delete m_cyclesHair;
-    }
-    if (m_cyclesMesh) {
-        m_renderDelegate->GetCyclesRenderParam()->RemoveMesh(m_cyclesMesh);
-        delete m_cyclesMesh;
+    // The render param takes ownership of removed items
+    if (m_cyclesGeometry) {
+        m_renderDelegate->GetCyclesRenderParam()->RemoveGeometry(
+            m_cyclesGeometry);
     }
     if (m_cyclesObject) {
         m_renderDelegate->GetCyclesRenderParam()->RemoveObject(m_cyclesObject);
-        delete m_cyclesObject;
     }
 }
 
@@ -133,9 +133,15 @@ HdCyclesBasisCurves::_PopulateCurveMesh(HdRenderParam* renderParam)
     bool use_old_curves;
     config.use_old_curves.eval(use_old_curves, true);
 
-    if (use_old_curves) {
+    // Ribbons without normals face the camera. Baking that into a mesh
+    // would need a new tessellation and BVH on every camera move, native
+    // ribbon curves are oriented at intersection time instead.
+    const bool cameraFacing = m_curveShape == ccl::CURVE_RIBBON
+                              && m_normals.empty();
+
+    if (use_old_curves && !cameraFacing) {
         if (m_curveShape == ccl::CURVE_RIBBON) {
-            _CreateRibbons(scene->camera);
+            _CreateRibbons();
         } else {
             _CreateTubeMesh();
         }
@@ -150,8 +156,11 @@ HdCyclesBasisCurves::_PopulateCurveMesh(HdRenderParam* renderParam)
 void
 HdCyclesBasisCurves::_PopulateMotion()
 {
-    if (m_pointSamples.count <= 1)
+    // A single point sample can still be blurred from its velocities
+    if (m_pointSamples.count <= 1) {
+        _PopulateVelocityMotion();
         return;
+    }
 
     m_cyclesGeometry->use_motion_blur = true;
 
@@ -179,6 +188,41 @@ HdCyclesBasisCurves::_PopulateMotion()
     }
 }
 
+void
+HdCyclesBasisCurves::_PopulateVelocityMotion()
+{
+    // Tessellated curves don't keep a vertex per point
+    if (!m_cyclesHair || m_cyclesHair->curve_keys.size() != m_points.size()
+        || m_velocities.size() != m_points.size()) {
+        return;
+    }
+
+    const std::vector<float> offsets = HdCyclesMotionStepOffsets(
+        m_renderDelegate->GetCyclesRenderParam()->GetCyclesScene(),
+        m_motionSteps);
+
+    m_cyclesHair->use_motion_blur = true;
+    m_cyclesHair->motion_steps    = static_cast<int>(offsets.size()) + 1;
+
+    m_cyclesHair->attributes.remove(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+    ccl::Attribute* attr_mP = m_cyclesHair->attributes.add(
+        ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+
+    ccl::float3* mP = attr_mP->data_float3();
+
+    const size_t numKeys = m_points.size();
+    for (float offset : offsets) {
+        HdCyclesExtrapolatePoints(m_points, m_velocities, m_accelerations,
+                                  offset, mP);
+
+        // Curve motion keys carry the radius in w
+        for (size_t i = 0; i < numKeys; ++i)
+            mP[i].w = m_cyclesHair->curve_radius[i];
+
+        mP += numKeys;
+    }
+}
+
 void
 HdCyclesBasisCurves::_AddColors(TfToken name, VtValue value,
                                 HdInterpolation interpolation)
@@ -188,27 +232,29 @@ HdCyclesBasisCurves::_AddColors(TfToken name, VtValue value,
     int vecSize   = 0;
     int numColors = 0;
 
-    VtFloatArray colors1f;
-    VtVec2fArray colors2f;
-    VtVec3fArray colors3f;
-    VtVec4fArray colors4f;
+    // Read through the value, mutable copies of the arrays would detach
+    // from the scene delegate on every element access
+    const float* colors1f   = nullptr;
+    const GfVec2f* colors2f = nullptr;
+    const GfVec3f* colors3f = nullptr;
+    const GfVec4f* colors4f = nullptr;
 
     if (value.IsHolding<VtArray<GfVec3f>>()) {
-        colors3f  = value.UncheckedGet<VtArray<GfVec3f>>();
+        colors3f  = value.UncheckedGet<VtArray<GfVec3f>>().cdata();
         vecSize   = 3;
-        numColors = colors3f.size();
+        numColors = value.GetArraySize();
     } else if (value.IsHolding<VtArray<GfVec4f>>()) {
-        colors4f  = value.UncheckedGet<VtArray<GfVec4f>>();
+        colors4f  = value.UncheckedGet<VtArray<GfVec4f>>().cdata();
         vecSize   = 4;
-        numColors = colors4f.size();
+        numColors = value.GetArraySize();
     } else if (value.IsHolding<VtArray<GfVec2f>>()) {
-        colors2f  = value.UncheckedGet<VtArray<GfVec2f>>();
+        colors2f  = value.UncheckedGet<VtArray<GfVec2f>>().cdata();
         vecSize   = 2;
-        numColors = colors2f.size();
+        numColors = value.GetArraySize();
     } else if (value.IsHolding<VtArray<float>>()) {
-        colors1f  = value.UncheckedGet<VtArray<float>>();
+        colors1f  = value.UncheckedGet<VtArray<float>>().cdata();
         vecSize   = 1;
-        numColors = colors1f.size();
+        numColors = value.GetArraySize();
     }
 
     if (vecSize == 0)
@@ -439,15 +485,20 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
                           HdRenderParam* renderParam, HdDirtyBits* dirtyBits,
                           TfToken const& reprSelector)
 {
+    HD_TRACE_FUNCTION();
+
     SdfPath const& id = GetId();
 
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
 
+    HdCyclesSyncTimer syncTimer(param, HdPrimTypeTokens->basisCurves);
+
     ccl::Scene* scene = param->GetCyclesScene();
 
     HdCyclesPDPIMap pdpi;
     bool generate_new_curve = false;
     bool update_curve       = false;
+    bool update_transform   = false;
 
     if (*dirtyBits & HdChangeTracker::DirtyPoints) {
         HdCyclesPopulatePrimvarDescsPerInterpolation(sceneDelegate, id, &pdpi);
@@ -462,6 +513,27 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
         }
     }
 
+    // Velocities and accelerations blur from the one point sample above
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id,
+                                        HdTokens->velocities)) {
+        VtVec3fArray velocities;
+        VtVec3fArray accelerations;
+
+        VtValue value = sceneDelegate->Get(id, HdTokens->velocities);
+        if (value.IsHolding<VtVec3fArray>())
+            velocities = value.UncheckedGet<VtVec3fArray>();
+
+        value = sceneDelegate->Get(id, _tokens->accelerations);
+        if (value.IsHolding<VtVec3fArray>())
+            accelerations = value.UncheckedGet<VtVec3fArray>();
+
+        if (velocities != m_velocities || accelerations != m_accelerations) {
+            m_velocities       = velocities;
+            m_accelerations    = accelerations;
+            generate_new_curve = generate_new_curve || !m_points.empty();
+        }
+    }
+
     if (*dirtyBits & HdChangeTracker::DirtyNormals) {
         HdCyclesPopulatePrimvarDescsPerInterpolation(sceneDelegate, id, &pdpi);
         if (HdCyclesIsPrimvarExists(HdTokens->normals, pdpi)) {
@@ -603,14 +675,25 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
     }
 
     if (generate_new_curve) {
-        if (m_cyclesGeometry) {
-            param->RemoveCurve(m_cyclesHair);
-            m_cyclesGeometry->clear();
-            delete m_cyclesGeometry;
-        }
+        // The existing hair or mesh is refilled in place, it can be in the
+        // scene already
+        scene->mutex.lock();
+
+        ccl::Geometry* previous = m_cyclesGeometry;
 
         _PopulateCurveMesh(param);
 
+        if (previous && previous != m_cyclesGeometry) {
+            // Only when switching between hair and mesh, freed by the
+            // render param once it is out of the scene
+            param->RemoveGeometry(previous);
+
+            if (previous == m_cyclesHair)
+                m_cyclesHair = nullptr;
+            if (previous == m_cyclesMesh)
+                m_cyclesMesh = nullptr;
+        }
+
         if (m_cyclesGeometry) {
             m_cyclesObject->geometry = m_cyclesGeometry;
 
@@ -618,18 +701,23 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
 
             _PopulateGenerated();
 
-            param->AddCurve(m_cyclesGeometry);
+            if (previous != m_cyclesGeometry)
+                param->AddCurve(m_cyclesGeometry);
         }
 
         if (m_useMotionBlur)
             _PopulateMotion();
+
+        scene->mutex.unlock();
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        m_transformSamples = HdCyclesSetTransform(m_cyclesObject, sceneDelegate,
-                                                  id, m_useMotionBlur);
-
-        update_curve = true;
+        update_transform = HdCyclesSampleTransform(sceneDelegate, id,
+                                                   &m_transformSamples);
+        if (update_transform) {
+            HdCyclesApplyTransform(m_cyclesObject, m_transformSamples,
+                                   m_useMotionBlur);
+        }
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
@@ -637,6 +725,12 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
 
         for (auto& primvarDescsEntry : pdpi) {
             for (auto& pv : primvarDescsEntry.second) {
+                // Consumed by _PopulateMotion
+                if (pv.name == HdTokens->velocities
+                    || pv.name == _tokens->accelerations) {
+                    continue;
+                }
+
                 if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, pv.name)) {
                     VtValue value = GetPrimvar(sceneDelegate, pv.name);
                     if (pv.role == HdPrimvarRoleTokens->textureCoordinate) {
@@ -662,12 +756,18 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
                     sceneDelegate->GetRenderIndex().GetSprim(
                         HdPrimTypeTokens->material, materialId));
 
+            ccl::Shader* shader = scene->default_surface;
             if (material && material->GetCyclesShader()) {
-                m_usedShaders.push_back(material->GetCyclesShader());
+                shader = material->GetCyclesShader();
+                shader->tag_update(scene);
+            }
 
-                material->GetCyclesShader()->tag_update(scene);
+            // Curves only use the first slot, rebind it as materials can
+            // hand out a different shared shader after an edit
+            if (m_usedShaders.empty()) {
+                m_usedShaders.push_back(shader);
             } else {
-                m_usedShaders.push_back(scene->default_surface);
+                m_usedShaders[0] = shader;
             }
 
             m_cyclesGeometry->used_shaders = m_usedShaders;
@@ -675,8 +775,9 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
         }
     }
 
-    if (generate_new_curve || update_curve) {
-        m_cyclesHair->curve_shape = m_curveShape;
+    if ((generate_new_curve || update_curve) && m_cyclesGeometry) {
+        if (m_cyclesHair)
+            m_cyclesHair->curve_shape = m_curveShape;
 
         m_cyclesObject->visibility = m_visibilityFlags;
         if (!_sharedData.visible)
@@ -684,245 +785,198 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate,
 
         m_cyclesGeometry->tag_update(scene, true);
         m_cyclesObject->tag_update(scene);
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeGeometry
+                              | HdCyclesRenderParam::SceneChangeTransform);
+
+        if (m_cyclesHair && m_cyclesGeometry == m_cyclesHair)
+            syncTimer.AddElements(m_cyclesHair->num_segments());
+        else if (m_cyclesMesh && m_cyclesGeometry == m_cyclesMesh)
+            syncTimer.AddElements(m_cyclesMesh->num_triangles());
+        param->Interrupt();
+    } else if (update_transform) {
+        // Object only, the curve BVH is refit
+        m_cyclesObject->tag_update(scene);
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeTransform);
         param->Interrupt();
     }
 
     *dirtyBits = HdChangeTracker::Clean;
 }
 
-void
-HdCyclesBasisCurves::_CreateCurves(ccl::Scene* a_scene)
+float
+HdCyclesBasisCurves::_GetCurveRadius(int a_curve, int a_point) const
 {
-    m_cyclesHair     = new ccl::Hair();
-    m_cyclesGeometry = m_cyclesHair;
-
-    // Get USD Curve Metadata
-    VtIntArray curveVertexCounts = m_topology.GetCurveVertexCounts();
-    TfToken curveType            = m_topology.GetCurveType();
-    TfToken curveBasis           = m_topology.GetCurveBasis();
-    TfToken curveWrap            = m_topology.GetCurveWrap();
-
-    int num_curves = curveVertexCounts.size();
-    int num_keys   = 0;
-
-    for (int i = 0; i < num_curves; i++) {
-        num_keys += curveVertexCounts[i];
-    }
+    if (m_widths.empty())
+        return 0.1f;
 
-    ccl::Attribute* attr_intercept = NULL;
-    ccl::Attribute* attr_random    = NULL;
+    int width_idx = a_point;
+    if (m_widthsInterpolation == HdInterpolationUniform)
+        width_idx = a_curve;
+    else if (m_widthsInterpolation == HdInterpolationConstant)
+        width_idx = 0;
 
-    attr_intercept = m_cyclesHair->attributes.add(
-        ccl::ATTR_STD_CURVE_INTERCEPT);
+    width_idx = std::min(width_idx, static_cast<int>(m_widths.size()) - 1);
 
-    attr_random = m_cyclesHair->attributes.add(ccl::ATTR_STD_CURVE_RANDOM);
+    // Hydra/USD treats widths as diameters so we halve before sending to cycles
+    return m_widths[width_idx] / 2.0f;
+}
 
-    // We have patched the Cycles API to allow shape to be set per curve
-    m_cyclesHair->curve_shape = m_curveShape;
-    m_cyclesHair->reserve_curves(num_curves, num_keys);
+bool
+HdCyclesBasisCurves::_GetCurveOffsets(std::vector<int>* a_firstPoints) const
+{
+    const VtIntArray& curveVertexCounts = m_topology.GetCurveVertexCounts();
 
-    num_curves = 0;
-    num_keys   = 0;
+    a_firstPoints->resize(curveVertexCounts.size() + 1);
 
-    int currentPointCount = 0;
+    int numPoints       = 0;
+    (*a_firstPoints)[0] = 0;
+    for (size_t i = 0; i < curveVertexCounts.size(); ++i) {
+        numPoints += std::max(curveVertexCounts[i], 0);
+        (*a_firstPoints)[i + 1] = numPoints;
+    }
 
-    // For every curve
-    for (int i = 0; i < curveVertexCounts.size(); i++) {
-        size_t num_curve_keys = 0;
+    if (numPoints > static_cast<int>(m_points.size())) {
+        TF_WARN("Curve vertex counts exceed the number of points");
+        return false;
+    }
 
-        // For every section
-        for (int j = 0; j < curveVertexCounts[i]; j++) {
-            int idx = j + currentPointCount;
+    return true;
+}
 
-            const float time = (float)j / (float)(curveVertexCounts[i] - 1);
+void
+HdCyclesBasisCurves::_CreateCurves(ccl::Scene* a_scene)
+{
+    // Reused across syncs, resizing keeps the previous allocations
+    if (!m_cyclesHair)
+        m_cyclesHair = new ccl::Hair();
+    m_cyclesGeometry = m_cyclesHair;
 
-            if (idx > m_points.size()) {
-                TF_WARN("Attempted to access invalid point. Continuing");
-                continue;
-            }
+    m_cyclesHair->attributes.clear();
 
-            ccl::float3 usd_location = vec3f_to_float3(m_points[idx]);
+    std::vector<int> firstPoints;
+    if (!_GetCurveOffsets(&firstPoints)) {
+        m_cyclesHair->resize_curves(0, 0);
+        return;
+    }
 
-            // Widths
+    const int num_curves = static_cast<int>(firstPoints.size()) - 1;
+    const int num_keys   = firstPoints.back();
 
-            // Hydra/USD treats widths as diameters so we halve before sending to cycles
-            float radius = 0.1f;
+    // We have patched the Cycles API to allow shape to be set per curve
+    m_cyclesHair->curve_shape = m_curveShape;
+    m_cyclesHair->resize_curves(num_curves, num_keys);
 
-            int width_idx = std::min(idx, (int)(m_widths.size() - 1));
+    ccl::Attribute* attr_intercept = m_cyclesHair->attributes.add(
+        ccl::ATTR_STD_CURVE_INTERCEPT);
+    ccl::Attribute* attr_random = m_cyclesHair->attributes.add(
+        ccl::ATTR_STD_CURVE_RANDOM);
 
-            if (m_widthsInterpolation == HdInterpolationUniform)
-                width_idx = std::min(i, (int)(m_widths.size() - 1));
-            else if (m_widthsInterpolation == HdInterpolationConstant)
-                width_idx = 0;
+    float* intercept = attr_intercept->data_float();
+    float* random    = attr_random->data_float();
 
-            if (m_widths.size() > 0)
-                radius = m_widths[width_idx] / 2.0f;
+    // Every curve writes its own range of keys, found from the prefix sum
+    WorkParallelForN(num_curves, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int first = firstPoints[i];
+            const int count = firstPoints[i + 1] - first;
 
-            m_cyclesHair->add_curve_key(usd_location, radius);
+            m_cyclesHair->curve_first_key[i] = first;
+            m_cyclesHair->curve_shader[i]    = 0;
 
-            // Intercept
+            random[i] = ccl::hash_uint2_to_float(static_cast<unsigned int>(i),
+                                                 0);
 
-            if (attr_intercept)
-                attr_intercept->add(time);
+            for (int j = 0; j < count; ++j) {
+                const int idx = first + j;
 
-            num_curve_keys++;
-        }
+                m_cyclesHair->curve_keys[idx] = vec3f_to_float3(m_points[idx]);
+                m_cyclesHair->curve_radius[idx] = _GetCurveRadius(i, idx);
 
-        if (attr_random != NULL) {
-            attr_random->add(ccl::hash_uint2_to_float(num_curves, 0));
+                intercept[idx] = (count > 1) ? (float)j / (float)(count - 1)
+                                             : 0.0f;
+            }
         }
-
-        m_cyclesHair->add_curve(num_keys, 0);
-        num_keys += num_curve_keys;
-        currentPointCount += curveVertexCounts[i];
-        num_curves++;
-    }
-
-    if ((m_cyclesHair->curve_keys.size() != num_keys)
-        || (m_cyclesHair->num_curves() != num_curves)) {
-        TF_WARN("Allocation failed. Clearing data");
-
-        m_cyclesHair->clear();
-    }
+    });
 }
 
 void
-HdCyclesBasisCurves::_CreateRibbons(ccl::Camera* a_camera)
+HdCyclesBasisCurves::_CreateRibbons()
 {
-    m_cyclesMesh     = new ccl::Mesh();
+    // Reused across syncs, resizing keeps the previous allocations
+    if (!m_cyclesMesh)
+        m_cyclesMesh = new ccl::Mesh();
     m_cyclesGeometry = m_cyclesMesh;
 
-    bool isCameraOriented = false;
-
-    ccl::float3 RotCam;
-    bool is_ortho;
-    if (m_normals.size() <= 0) {
-        if (a_camera != nullptr) {
-            isCameraOriented     = true;
-            ccl::Transform& ctfm = a_camera->matrix;
-            if (a_camera->type == ccl::CAMERA_ORTHOGRAPHIC) {
-                RotCam = -ccl::make_float3(ctfm.x.z, ctfm.y.z, ctfm.z.z);
-            } else {
-                ccl::Transform tfm  = m_cyclesObject->tfm;
-                ccl::Transform itfm = ccl::transform_quick_inverse(tfm);
-                RotCam              = ccl::transform_point(
-                    &itfm, ccl::make_float3(ctfm.x.w, ctfm.y.w, ctfm.z.w));
-            }
-            is_ortho = a_camera->type == ccl::CAMERA_ORTHOGRAPHIC;
-        }
-    }
+    m_cyclesMesh->attributes.clear();
 
-    // Get USD Curve Metadata
-    VtIntArray curveVertexCounts = m_topology.GetCurveVertexCounts();
-    TfToken curveType            = m_topology.GetCurveType();
-    TfToken curveBasis           = m_topology.GetCurveBasis();
-    TfToken curveWrap            = m_topology.GetCurveWrap();
-
-    int num_vertices = 0;
-    int num_tris     = 0;
-    for (int i = 0; i < curveVertexCounts.size(); i++) {
-        num_vertices += curveVertexCounts[i] * 2;
-        num_tris += ((curveVertexCounts[i] - 1) * 2);
+    std::vector<int> firstPoints;
+    if (!_GetCurveOffsets(&firstPoints)) {
+        m_cyclesMesh->resize_mesh(0, 0);
+        return;
     }
 
-    // Start Cycles Mesh population
-    int vertexindex = 0;
-
-    m_cyclesMesh->reserve_mesh(num_vertices, num_tris);
+    // A ribbon is a pair of vertices per point and a quad per segment
+    const size_t num_curves = firstPoints.size() - 1;
 
-    // For every curve
-    for (int i = 0; i < curveVertexCounts.size(); i++) {
-        ccl::float3 xbasis;
-        ccl::float3 v1;
+    std::vector<int> firstTris(num_curves + 1, 0);
+    for (size_t i = 0; i < num_curves; ++i) {
+        const int count  = firstPoints[i + 1] - firstPoints[i];
+        firstTris[i + 1] = firstTris[i] + ((count > 1) ? (count - 1) * 2 : 0);
+    }
 
-        ccl::float3 ickey_loc = vec3f_to_float3(m_points[0]);
+    m_cyclesMesh->resize_mesh(firstPoints.back() * 2, firstTris.back());
 
-        // Widths
+    WorkParallelForN(num_curves, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int first = firstPoints[i];
+            const int count = firstPoints[i + 1] - first;
 
-        // Hydra/USD treats widths as diameters so we halve before sending to cycles
-        float radius = 0.1f;
+            int tri = firstTris[i];
 
-        int width_idx = std::min(i, (int)(m_widths.size() - 1));
+            for (int j = 0; j < count; ++j) {
+                const int idx = first + j;
 
-        if (m_widthsInterpolation == HdInterpolationUniform)
-            width_idx = std::min(i, (int)(m_widths.size() - 1));
-        else if (m_widthsInterpolation == HdInterpolationConstant)
-            width_idx = 0;
+                const ccl::float3 ickey_loc = vec3f_to_float3(m_points[idx]);
 
-        if (m_widths.size() > 0)
-            radius = m_widths[width_idx] / 2.0f;
+                // Central difference, one sided at the ends
+                const ccl::float3 v1 = vec3f_to_float3(
+                    m_points[first + std::min(j + 1, count - 1)]
+                    - m_points[first + std::max(j - 1, 0)]);
 
-        v1 = vec3f_to_float3(m_points[1] - m_points[0]);
-        if (isCameraOriented) {
-            if (is_ortho)
-                xbasis = normalize(cross(RotCam, v1));
-            else
-                xbasis = ccl::normalize(ccl::cross(RotCam - ickey_loc, v1));
-        } else {
-            if (m_normals.size() > 0)
-                xbasis = ccl::normalize(vec3f_to_float3(m_normals[0]));
-            else
-                xbasis = ccl::normalize(ccl::cross(ickey_loc, v1));
-        }
-        ccl::float3 ickey_loc_shfl = ickey_loc - radius * xbasis;
-        ccl::float3 ickey_loc_shfr = ickey_loc + radius * xbasis;
-        m_cyclesMesh->add_vertex(ickey_loc_shfl);
-        m_cyclesMesh->add_vertex(ickey_loc_shfr);
-        vertexindex += 2;
-
-        // For every section
-        for (int j = 0; j < curveVertexCounts[i]; j++) {
-            int first_idx = (i * curveVertexCounts[i]);
-            int idx       = j + (i * curveVertexCounts[i]);
-
-            ickey_loc = vec3f_to_float3(m_points[idx]);
-
-            if (j == 0) {
-                // subv = 0;
-                // First curve point
-                v1 = vec3f_to_float3(m_points[idx]
-                                     - m_points[std::max(idx - 1, first_idx)]);
-            } else {
-                v1 = vec3f_to_float3(m_points[idx + 1] - m_points[idx - 1]);
-            }
+                // Camera facing ribbons are native curves, see
+                // _PopulateCurveMesh
+                ccl::float3 xbasis;
+                if (idx < m_normals.size())
+                    xbasis = vec3f_to_float3(m_normals[idx]);
+                else
+                    xbasis = ccl::cross(ickey_loc, v1);
+                xbasis = ccl::safe_normalize(xbasis);
 
-            // Widths
+                const float radius = _GetCurveRadius(i, idx);
 
-            // Hydra/USD treats widths as diameters so we halve before sending to cycles
-            float radius = 0.1f;
+                const int vertexindex = idx * 2;
 
-            int width_idx = std::min(idx, (int)(m_widths.size() - 1));
+                ccl::float3* verts = m_cyclesMesh->verts.data() + vertexindex;
+                verts[0]           = ickey_loc - radius * xbasis;
+                verts[1]           = ickey_loc + radius * xbasis;
 
-            if (m_widthsInterpolation == HdInterpolationUniform)
-                width_idx = std::min(i, (int)(m_widths.size() - 1));
-            else if (m_widthsInterpolation == HdInterpolationConstant)
-                width_idx = 0;
+                if (j == 0)
+                    continue;
 
-            if (m_widths.size() > 0)
-                radius = m_widths[width_idx] / 2.0f;
+                const int tris[6] = { vertexindex - 2, vertexindex,
+                                      vertexindex - 1, vertexindex + 1,
+                                      vertexindex - 1, vertexindex };
 
-            if (isCameraOriented) {
-                if (is_ortho)
-                    xbasis = normalize(cross(RotCam, v1));
-                else
-                    xbasis = ccl::normalize(ccl::cross(RotCam - ickey_loc, v1));
-            } else {
-                if (m_normals.size() > 0)
-                    xbasis = ccl::normalize(vec3f_to_float3(m_normals[idx]));
-                else
-                    xbasis = ccl::normalize(ccl::cross(ickey_loc, v1));
+                for (int t = 0; t < 2; ++t, ++tri) {
+                    m_cyclesMesh->triangles[tri * 3 + 0] = tris[t * 3 + 0];
+                    m_cyclesMesh->triangles[tri * 3 + 1] = tris[t * 3 + 1];
+                    m_cyclesMesh->triangles[tri * 3 + 2] = tris[t * 3 + 2];
+                    m_cyclesMesh->shader[tri]            = 0;
+                    m_cyclesMesh->smooth[tri]            = true;
+                }
             }
-            ccl::float3 ickey_loc_shfl = ickey_loc - radius * xbasis;
-            ccl::float3 ickey_loc_shfr = ickey_loc + radius * xbasis;
-            m_cyclesMesh->add_vertex(ickey_loc_shfl);
-            m_cyclesMesh->add_vertex(ickey_loc_shfr);
-            m_cyclesMesh->add_triangle(vertexindex - 2, vertexindex,
-                                       vertexindex - 1, 0, true);
-            m_cyclesMesh->add_triangle(vertexindex + 1, vertexindex - 1,
-                                       vertexindex, 0, true);
-            vertexindex += 2;
         }
-    }
+    });
 
     // TODO: Implement texcoords
 }
@@ -930,175 +984,150 @@ HdCyclesBasisCurves::_CreateRibbons(ccl::Camera* a_camera)
 void
 HdCyclesBasisCurves::_CreateTubeMesh()
 {
-    m_cyclesMesh     = new ccl::Mesh();
+    // Reused across syncs, resizing keeps the previous allocations
+    if (!m_cyclesMesh)
+        m_cyclesMesh = new ccl::Mesh();
     m_cyclesGeometry = m_cyclesMesh;
 
-    // Get USD Curve Metadata
-    VtIntArray curveVertexCounts = m_topology.GetCurveVertexCounts();
-    TfToken curveType            = m_topology.GetCurveType();
-    TfToken curveBasis           = m_topology.GetCurveBasis();
-    TfToken curveWrap            = m_topology.GetCurveWrap();
-
-    int num_vertices = 0;
-    int num_tris     = 0;
-    for (int i = 0; i < curveVertexCounts.size(); i++) {
-        num_vertices += curveVertexCounts[i] * m_curveResolution;
-        num_tris += ((curveVertexCounts[i] - 1) * 2 * m_curveResolution);
+    m_cyclesMesh->attributes.clear();
+
+    std::vector<int> firstPoints;
+    if (!_GetCurveOffsets(&firstPoints) || m_curveResolution < 2) {
+        m_cyclesMesh->resize_mesh(0, 0);
+        return;
     }
 
-    // Start Cycles Mesh population
-    int vertexindex = m_curveResolution;
-
-    m_cyclesMesh->reserve_mesh(num_vertices, num_tris);
-
-    // For every curve
-    for (int i = 0; i < curveVertexCounts.size(); i++) {
-        int subv = 1;
-
-        ccl::float3 firstxbasis = ccl::cross(ccl::make_float3(1.0f, 0.0f, 0.0f),
-                                             vec3f_to_float3(m_points[1])
-                                                 - vec3f_to_float3(m_points[0]));
-
-        if (!ccl::is_zero(firstxbasis))
-            firstxbasis = ccl::normalize(firstxbasis);
-        else
-            firstxbasis = ccl::normalize(
-                ccl::cross(ccl::make_float3(0.0f, 1.0f, 0.0f),
-                           vec3f_to_float3(m_points[1])
-                               - vec3f_to_float3(m_points[0])));
-
-        // For every section
-        for (int j = 0; j < curveVertexCounts[i]; j++) {
-            int first_idx = (i * curveVertexCounts[i]);
-            int idx       = j + (i * curveVertexCounts[i]);
-
-            ccl::float3 xbasis = firstxbasis;
-            ccl::float3 v1;
-            ccl::float3 v2;
-
-            if (j == 0) {
-                // First curve point
-                v1 = vec3f_to_float3(
-                    m_points[std::min(idx + 2, (curveVertexCounts[i]
-                                                + curveVertexCounts[i] - 1))]);
-                v2 = vec3f_to_float3(m_points[idx + 1] - m_points[idx]);
-            } else if (j == (curveVertexCounts[i] - 1)) {
-                // Last curve point
-                v1 = vec3f_to_float3(m_points[idx] - m_points[idx - 1]);
-                v2 = vec3f_to_float3(
-                    m_points[idx - 1]
-                    - m_points[std::max(idx - 2, first_idx)]);  // First key
-            } else {
-                v1 = vec3f_to_float3(m_points[idx + 1] - m_points[idx]);
-                v2 = vec3f_to_float3(m_points[idx] - m_points[idx - 1]);
-            }
+    // A tube is a ring of vertices per point and two triangles per ring
+    // vertex and segment
+    const int resolution    = m_curveResolution;
+    const size_t num_curves = firstPoints.size() - 1;
 
-            xbasis = ccl::cross(v1, v2);
+    std::vector<int> firstTris(num_curves + 1, 0);
+    for (size_t i = 0; i < num_curves; ++i) {
+        const int count  = firstPoints[i + 1] - firstPoints[i];
+        firstTris[i + 1] = firstTris[i]
+                           + ((count > 1) ? (count - 1) * 2 * resolution : 0);
+    }
 
-            if (ccl::len_squared(xbasis)
-                >= 0.05f * ccl::len_squared(v1) * ccl::len_squared(v2)) {
-                firstxbasis = ccl::normalize(xbasis);
-                break;
-            }
-        }
+    m_cyclesMesh->resize_mesh(firstPoints.back() * resolution,
+                              firstTris.back());
 
-        // For every section
-        for (int j = 0; j < curveVertexCounts[i]; j++) {
-            int first_idx = (i * curveVertexCounts[i]);
-            int idx       = j + (i * curveVertexCounts[i]);
-            ccl::float3 xbasis;
-            ccl::float3 ybasis;
-            ccl::float3 v1;
-            ccl::float3 v2;
-
-            ccl::float3 usd_location = vec3f_to_float3(m_points[idx]);
-
-            if (j == 0) {
-                // First curve point
-                v1 = vec3f_to_float3(
-                    m_points[std::min(idx + 2, (curveVertexCounts[i] - 1))]
-                    - m_points[idx + 1]);
-                v2 = vec3f_to_float3(m_points[idx + 1] - m_points[idx]);
-            } else if (j == (curveVertexCounts[i] - 1)) {
-                v1 = vec3f_to_float3(m_points[idx] - m_points[idx - 1]);
-                v2 = vec3f_to_float3(m_points[idx - 1]
-                                     - m_points[std::max(idx - 2, first_idx)]);
-            } else {
-                v1 = vec3f_to_float3(m_points[idx + 1] - m_points[idx]);
-                v1 = vec3f_to_float3(m_points[idx] - m_points[idx - 1]);
-            }
+    const float angle = M_2PI_F / (float)resolution;
 
-            // Add vertex in circle
+    WorkParallelForN(num_curves, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int first = firstPoints[i];
+            const int count = firstPoints[i + 1] - first;
 
-            // Widths
+            auto point = [&](int j) {
+                return vec3f_to_float3(
+                    m_points[first + std::max(0, std::min(j, count - 1))]);
+            };
 
-            // Hydra/USD treats widths as diameters so we halve before sending to cycles
-            float radius = 0.1f;
+            // No segment to orient a ring with, collapse it to the point
+            if (count < 2) {
+                for (int k = 0; k < resolution * count; k++)
+                    m_cyclesMesh->verts[first * resolution + k] = point(0);
+                continue;
+            }
 
-            int width_idx = std::min(idx, (int)(m_widths.size() - 1));
+            // Segment directions around a point, the frame follows their
+            // cross product and keeps the last good one on straight runs
+            auto segments = [&](int j, ccl::float3* v1, ccl::float3* v2) {
+                if (j == 0) {
+                    *v1 = point(2) - point(1);
+                    *v2 = point(1) - point(0);
+                } else if (j == count - 1) {
+                    *v1 = point(j) - point(j - 1);
+                    *v2 = point(j - 1) - point(j - 2);
+                } else {
+                    *v1 = point(j + 1) - point(j);
+                    *v2 = point(j) - point(j - 1);
+                }
+            };
 
-            if (m_widthsInterpolation == HdInterpolationUniform)
-                width_idx = std::min(i, (int)(m_widths.size() - 1));
-            else if (m_widthsInterpolation == HdInterpolationConstant)
-                width_idx = 0;
+            ccl::float3 firstxbasis = ccl::cross(
+                ccl::make_float3(1.0f, 0.0f, 0.0f), point(1) - point(0));
 
-            if (m_widths.size() > 0)
-                radius = m_widths[width_idx] / 2.0f;
+            if (!ccl::is_zero(firstxbasis))
+                firstxbasis = ccl::normalize(firstxbasis);
+            else
+                firstxbasis = ccl::normalize(
+                    ccl::cross(ccl::make_float3(0.0f, 1.0f, 0.0f),
+                               point(1) - point(0)));
 
-            float angle = M_2PI_F / (float)m_curveResolution;
+            for (int j = 0; j < count; j++) {
+                ccl::float3 v1, v2;
+                segments(j, &v1, &v2);
 
-            xbasis = ccl::cross(v1, v2);
+                const ccl::float3 xbasis = ccl::cross(v1, v2);
 
-            if (ccl::len_squared(xbasis)
-                >= 0.05f * ccl::len_squared(v1) * ccl::len_squared(v2)) {
-                xbasis      = ccl::normalize(xbasis);
-                firstxbasis = xbasis;
-            } else {
-                xbasis = firstxbasis;
+                if (ccl::len_squared(xbasis)
+                    >= 0.05f * ccl::len_squared(v1) * ccl::len_squared(v2)) {
+                    firstxbasis = ccl::normalize(xbasis);
+                    break;
+                }
             }
 
-            ybasis = ccl::normalize(ccl::cross(xbasis, v2));
+            int tri = firstTris[i];
 
-            // Add vertices
-            for (int k = 0; k < m_curveResolution; k++) {
-                ccl::float3 vertex_location = usd_location
-                                              + radius
-                                                    * (cosf(angle * k) * xbasis
-                                                       + sinf(angle * k)
-                                                             * ybasis);
+            for (int j = 0; j < count; j++) {
+                const int idx = first + j;
 
-                m_cyclesMesh->add_vertex(vertex_location);
-            }
-
-            if (j < curveVertexCounts[i] - 1) {
-                for (int k = 0; k < m_curveResolution - 1; k++) {
-                    int t1 = vertexindex - m_curveResolution + k;
-                    int t2 = vertexindex + k;
-                    int t3 = vertexindex - m_curveResolution + k + 1;
+                ccl::float3 v1, v2;
+                segments(j, &v1, &v2);
 
-                    m_cyclesMesh->add_triangle(t1, t2, t3, 0, true);
+                ccl::float3 xbasis = ccl::cross(v1, v2);
 
-                    t1 = vertexindex + k + 1;
-                    t2 = vertexindex - m_curveResolution + k + 1;
-                    t3 = vertexindex + k;
-
-                    m_cyclesMesh->add_triangle(t1, t2, t3, 0, true);
+                if (ccl::len_squared(xbasis)
+                    >= 0.05f * ccl::len_squared(v1) * ccl::len_squared(v2)) {
+                    xbasis      = ccl::normalize(xbasis);
+                    firstxbasis = xbasis;
+                } else {
+                    xbasis = firstxbasis;
                 }
-                int t1 = vertexindex - 1;
-                int t2 = vertexindex + m_curveResolution - 1;
-                int t3 = vertexindex - m_curveResolution;
 
-                m_cyclesMesh->add_triangle(t1, t2, t3, 0, true);
+                const ccl::float3 ybasis = ccl::safe_normalize(
+                    ccl::cross(xbasis, v2));
 
-                t1 = vertexindex;
-                t2 = vertexindex - m_curveResolution;
-                t3 = vertexindex + m_curveResolution - 1;
+                const ccl::float3 usd_location = point(j);
+                const float radius             = _GetCurveRadius(i, idx);
 
-                m_cyclesMesh->add_triangle(t1, t2, t3, 0, true);
+                // Add vertices in a circle
+                const int vertexindex = idx * resolution;
+                for (int k = 0; k < resolution; k++) {
+                    m_cyclesMesh->verts[vertexindex + k]
+                        = usd_location
+                          + radius
+                                * (cosf(angle * k) * xbasis
+                                   + sinf(angle * k) * ybasis);
+                }
+
+                if (j == 0)
+                    continue;
+
+                // Join to the ring of the previous point
+                const int prev = vertexindex - resolution;
+                const int cur  = vertexindex;
+
+                auto add_triangle = [&](int t1, int t2, int t3) {
+                    m_cyclesMesh->triangles[tri * 3 + 0] = t1;
+                    m_cyclesMesh->triangles[tri * 3 + 1] = t2;
+                    m_cyclesMesh->triangles[tri * 3 + 2] = t3;
+                    m_cyclesMesh->shader[tri]            = 0;
+                    m_cyclesMesh->smooth[tri]            = true;
+                    ++tri;
+                };
+
+                for (int k = 0; k < resolution - 1; k++) {
+                    add_triangle(prev + k, cur + k, prev + k + 1);
+                    add_triangle(cur + k + 1, prev + k + 1, cur + k);
+                }
+                add_triangle(cur - 1, cur + resolution - 1, prev);
+                add_triangle(cur, prev, cur + resolution - 1);
             }
-            vertexindex += m_curveResolution;
         }
-    }
+    });
 
     // TODO: Implement texcoords
 }
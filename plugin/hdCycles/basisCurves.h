@@ -141,6 +141,13 @@ protected:
 
     void _PopulateMotion();
 
+    /**
+     * @brief Populate motion keys by moving the points along their
+     * velocities and accelerations over the shutter. Only unrefined curves
+     * are supported.
+     */
+    void _PopulateVelocityMotion();
+
     /**
      * @brief Populate generated coordinates for basisCurves
      * 
@@ -158,6 +165,8 @@ protected:
     HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> m_transformSamples;
 
     HdCyclesSampledPrimvarType m_pointSamples;
+    VtVec3fArray m_velocities;
+    VtVec3fArray m_accelerations;
 
     int m_numTransformSamples;
     bool m_useMotionBlur;
@@ -191,25 +200,45 @@ private:
     void _PopulateCurveMesh(HdRenderParam* renderParam);
 
     /**
-     * @brief Manually create ribbon geometry for curves
-     * 
-     * @param a_camera Optional camera to orient towards
+     * @brief Manually create ribbon geometry for curves oriented by their
+     * normals. Curves are filled in parallel and the existing mesh is
+     * reused. Camera facing ribbons use native curves instead.
      */
-    void _CreateRibbons(ccl::Camera* a_camera = nullptr);
+    void _CreateRibbons();
 
     /**
-     * @brief Manually create tube/bevelled geometry for curves
+     * @brief Manually create tube/bevelled geometry for curves. Curves are
+     * filled in parallel and the existing mesh is reused.
      * 
      */
     void _CreateTubeMesh();
 
     /**
-     * @brief Properly populate native cycles curves with curve data
+     * @brief Properly populate native cycles curves with curve data. Curves
+     * are filled in parallel and the existing hair is reused.
      * 
      * @param a_scene Scene to add to
      */
     void _CreateCurves(ccl::Scene* a_scene);
 
+    /**
+     * @brief Radius of a curve point from the authored widths
+     *
+     * @param a_curve Index of the curve
+     * @param a_point Index of the point in m_points
+     * @return Radius, half of the USD width
+     */
+    float _GetCurveRadius(int a_curve, int a_point) const;
+
+    /**
+     * @brief Prefix sum of the curve vertex counts
+     *
+     * @param a_firstPoints Receives the first point of every curve, followed
+     * by the total point count
+     * @return false if the topology references more points than authored
+     */
+    bool _GetCurveOffsets(std::vector<int>* a_firstPoints) const;
+
     ccl::Object* m_cyclesObject;
     ccl::Mesh* m_cyclesMesh;
     ccl::Hair* m_cyclesHair;
@@ -443,6 +443,16 @@ HdCyclesCamera::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         param->Interrupt();
     }
 
+    // A fixed dicing camera only drives tessellation, applying it must not
+    // consume the update of the render camera
+    if (id == param->GetDicingCamera()) {
+        const bool needsUpdate = m_needsUpdate;
+        ApplyCameraSettings(scene->dicing_camera);
+        m_needsUpdate = needsUpdate;
+
+        param->UpdateDicingCamera();
+    }
+
     HdCamera::Sync(sceneDelegate, renderParam, dirtyBits);
 
     *dirtyBits = HdChangeTracker::Clean;
@@ -95,6 +95,12 @@ TF_DEFINE_ENV_SETTING(HD_CYCLES_USE_TILED_RENDERING, false,
 TF_DEFINE_ENV_SETTING(HD_CYCLES_UP_AXIS, "Z",
                       "Set custom up axis (Z or Y currently supported)");
 
+TF_DEFINE_ENV_SETTING(HD_CYCLES_RENDER_STATS_FILE, "",
+                      "Write render stats as JSON to this file");
+
+TF_DEFINE_ENV_SETTING(HD_CYCLES_TRACE_FILE, "",
+                      "Write a Chrome trace of the delegate to this file");
+
 // HdCycles Constructor
 HdCyclesConfig::HdCyclesConfig()
 {
@@ -113,14 +119,27 @@ HdCyclesConfig::HdCyclesConfig()
 
     up_axis = TfGetEnvSetting(HD_CYCLES_UP_AXIS);
 
+    render_stats_file = TfGetEnvSetting(HD_CYCLES_RENDER_STATS_FILE);
+    trace_file        = TfGetEnvSetting(HD_CYCLES_TRACE_FILE);
+
+    all_aov_passes = HdCyclesEnvValue<bool>("HD_CYCLES_ALL_AOV_PASSES", true);
+
     enable_motion_blur = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_MOTION_BLUR",
                                                 false);
     motion_steps       = HdCyclesEnvValue<int>("HD_CYCLES_MOTION_STEPS", 3);
+    frames_per_second
+        = HdCyclesEnvValue<float>("HD_CYCLES_FRAMES_PER_SECOND", 24.0f);
     enable_subdivision = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_SUBDIVISION",
                                                 false);
     subdivision_dicing_rate
         = HdCyclesEnvValue<float>("HD_CYCLES_SUBDIVISION_DICING_RATE", 1.0);
     max_subdivision = HdCyclesEnvValue<int>("HD_CYCLES_MAX_SUBDIVISION", 12);
+    dicing_camera = HdCyclesEnvValue<std::string>("HD_CYCLES_DICING_CAMERA",
+                                                  "");
+    dicing_camera_threshold
+        = HdCyclesEnvValue<float>("HD_CYCLES_DICING_CAMERA_THRESHOLD", 1.0f);
+    subdivision_face_budget
+        = HdCyclesEnvValue<int>("HD_CYCLES_SUBDIVISION_FACE_BUDGET", 0);
     enable_dof      = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_DOF", true);
 
     render_width   = HdCyclesEnvValue<int>("HD_CYCLES_RENDER_WIDTH", 1280);
@@ -137,6 +156,8 @@ HdCyclesConfig::HdCyclesConfig()
         = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_EXPERIMENTAL", false);
     bvh_type = HdCyclesEnvValue<std::string>("HD_CYCLES_BVH_TYPE", "DYNAMIC");
     device_name = HdCyclesEnvValue<std::string>("HD_CYCLES_DEVICE_NAME", "CPU");
+    async_kernel_loading
+        = HdCyclesEnvValue<bool>("HD_CYCLES_ASYNC_KERNEL_LOADING", true);
     shading_system = HdCyclesEnvValue<std::string>("HD_CYCLES_SHADING_SYSTEM",
                                                    "SVM");
     display_buffer_linear
@@ -144,11 +165,27 @@ HdCyclesConfig::HdCyclesConfig()
 
     max_samples = HdCyclesEnvValue<int>("HD_CYCLES_MAX_SAMPLES", 512);
 
+    interactive_denoising
+        = HdCyclesEnvValue<bool>("HD_CYCLES_INTERACTIVE_DENOISING", false);
+    denoising_start_sample
+        = HdCyclesEnvValue<int>("HD_CYCLES_DENOISING_START_SAMPLE", 16);
+    denoiser = HdCyclesEnvValue<std::string>("HD_CYCLES_DENOISER", "");
+
     num_threads      = HdCyclesEnvValue<int>("HD_CYCLES_NUM_THREADS", 0);
     pixel_size       = HdCyclesEnvValue<int>("HD_CYCLES_PIXEL_SIZE", 1);
     tile_size_x      = HdCyclesEnvValue<int>("HD_CYCLES_TILE_SIZE_X", 64);
     tile_size_y      = HdCyclesEnvValue<int>("HD_CYCLES_TILE_SIZE_Y", 64);
+    tile_output_file
+        = HdCyclesEnvValue<std::string>("HD_CYCLES_TILE_OUTPUT_FILE", "");
+    tile_output_compression = HdCyclesEnvValue<std::string>(
+        "HD_CYCLES_TILE_OUTPUT_COMPRESSION", "zip");
+    bucket_count     = HdCyclesEnvValue<int>("HD_CYCLES_BUCKET_COUNT", 1);
+    bucket_index     = HdCyclesEnvValue<int>("HD_CYCLES_BUCKET_INDEX", 0);
     start_resolution = HdCyclesEnvValue<int>("HD_CYCLES_START_RESOLUTION", 8);
+    navigation_samples
+        = HdCyclesEnvValue<int>("HD_CYCLES_NAVIGATION_SAMPLES", 1);
+    navigation_debounce
+        = HdCyclesEnvValue<float>("HD_CYCLES_NAVIGATION_DEBOUNCE", 0.25f);
     shutter_motion_position
         = HdCyclesEnvValue<int>("HD_CYCLES_SHUTTER_MOTION_POSITION", 1);
 
@@ -163,6 +200,14 @@ HdCyclesConfig::HdCyclesConfig()
     curve_subdivisions = HdCyclesEnvValue<int>("HD_CYCLES_CURVE_SUBDIVISIONS",
                                                3);
 
+    // -- Texture Settings
+
+    texture_limit = HdCyclesEnvValue<int>("HD_CYCLES_TEXTURE_LIMIT", 0);
+    ipr_texture_limit = HdCyclesEnvValue<int>("HD_CYCLES_IPR_TEXTURE_LIMIT",
+                                              0);
+    texture_cache_size = HdCyclesEnvValue<int>("HD_CYCLES_TEXTURE_CACHE_SIZE",
+                                               0);
+
     // -- Film
     exposure = HdCyclesEnvValue<float>("HD_CYCLES_EXPOSURE", 1.0);
 
@@ -180,7 +225,21 @@ HdCyclesConfig::HdCyclesConfig()
     subsurface_samples   = HdCyclesEnvValue<int>("HD_CYCLES_SUBSURFACE_SAMPLES",
                                                1);
     volume_samples       = HdCyclesEnvValue<int>("HD_CYCLES_VOLUME_SAMPLES", 1);
-    adaptive_min_samples = HdCyclesEnvValue<int>("HD_CYCLES_VOLUME_SAMPLES", 1);
+
+    adaptive_sampling = HdCyclesEnvValue<bool>("HD_CYCLES_ADAPTIVE_SAMPLING",
+                                               false);
+    adaptive_threshold
+        = HdCyclesEnvValue<float>("HD_CYCLES_ADAPTIVE_THRESHOLD", 0.0f);
+    adaptive_min_samples
+        = HdCyclesEnvValue<int>("HD_CYCLES_ADAPTIVE_MIN_SAMPLES", 0);
+    time_limit = HdCyclesEnvValue<double>("HD_CYCLES_TIME_LIMIT", 0.0);
+
+    checkpoint_file = HdCyclesEnvValue<std::string>("HD_CYCLES_CHECKPOINT_FILE",
+                                                    "");
+    checkpoint_interval
+        = HdCyclesEnvValue<double>("HD_CYCLES_CHECKPOINT_INTERVAL", 300.0);
+    geometry_cache_dir
+        = HdCyclesEnvValue<std::string>("HD_CYCLES_GEOMETRY_CACHE_DIR", "");
 }
 
 const HdCyclesConfig&
@@ -129,6 +129,28 @@ public:
      */
     std::string up_axis;
 
+    /**
+     * @brief If set, render stats are written as JSON to this file when a
+     * render completes and when the session exits
+     *
+     */
+    std::string render_stats_file;
+
+    /**
+     * @brief If set, the delegate is traced and a Chrome trace is written to
+     * this file when it is destroyed
+     *
+     */
+    std::string trace_file;
+
+    /**
+     * @brief Render a pass for every supported AOV in tiled renders, so
+     * changing the displayed AOVs doesn't restart the render. If disabled,
+     * only the bound AOVs are rendered.
+     *
+     */
+    HdCyclesEnvValue<bool> all_aov_passes;
+
     /**
      * @brief If enabled, HdCycles will populate object's motion and enable motion blur
      *
@@ -141,6 +163,13 @@ public:
      */
     HdCyclesEnvValue<int> motion_steps;
 
+    /**
+     * @brief Frames per second used to convert authored velocities and
+     * accelerations, which are per second, to the shutter, which is in frames
+     *
+     */
+    HdCyclesEnvValue<float> frames_per_second;
+
     /**
      * @brief If enabled, subdiv meshes will be subdivided
      * 
@@ -159,6 +188,29 @@ public:
      */
     HdCyclesEnvValue<int> max_subdivision;
 
+    /**
+     * @brief Path of the camera prim subdivision is diced from, empty
+     * follows the render camera. A fixed camera keeps the dice stable over
+     * a sequence.
+     *
+     */
+    HdCyclesEnvValue<std::string> dicing_camera;
+
+    /**
+     * @brief Distance in world units the dicing camera or a subdivided mesh
+     * has to move before the mesh is diced again, negative never re-dices
+     * for movement
+     *
+     */
+    HdCyclesEnvValue<float> dicing_camera_threshold;
+
+    /**
+     * @brief Upper bound of diced faces over all subdivided meshes, lowers
+     * the max subdivision level of every mesh to fit. 0 is unlimited.
+     *
+     */
+    HdCyclesEnvValue<int> subdivision_face_budget;
+
     /**
      * @brief Enable dpeth of field for cycles
      * 
@@ -224,11 +276,20 @@ public:
     HdCyclesEnvValue<std::string> bvh_type;
 
     /**
-     * @brief Name of cycles render device. (CPU, GPU, etc.)
+     * @brief Name of cycles render device. (CPU, CUDA, OPTIX, etc.)
+     * Several devices can be combined, e.g. "CUDA:*" for every CUDA
+     * device, "CUDA:0,2" for the first and third, or "CUDA:*+CPU".
      *
      */
     HdCyclesEnvValue<std::string> device_name;
 
+    /**
+     * @brief Load the render kernels on a background thread while the
+     * first scene syncs, the render starts once both are done
+     *
+     */
+    HdCyclesEnvValue<bool> async_kernel_loading;
+
     /**
      * @brief Shading system (SVM, OSL)
      * 
@@ -248,7 +309,27 @@ public:
     HdCyclesEnvValue<int> max_samples;
 
     /**
-     * @brief Number of threads to use for cycles render
+     * @brief Denoise the display of interactive (non tiled) renders
+     *
+     */
+    HdCyclesEnvValue<bool> interactive_denoising;
+
+    /**
+     * @brief First sample the interactive render is denoised at
+     *
+     */
+    HdCyclesEnvValue<int> denoising_start_sample;
+
+    /**
+     * @brief Interactive denoiser, OIDN or OPTIX. Empty picks OptiX when
+     * the device supports it, OpenImageDenoise otherwise.
+     *
+     */
+    HdCyclesEnvValue<std::string> denoiser;
+
+    /**
+     * @brief Number of threads to use for cycles render, 0 uses the thread
+     * limit of the host application
      *
      */
     HdCyclesEnvValue<int> num_threads;
@@ -271,12 +352,53 @@ public:
      */
     HdCyclesEnvValue<int> tile_size_y;
 
+    /**
+     * @brief Tiled EXR file tiled renders stream their finished tiles to,
+     * empty only writes the render buffers
+     *
+     */
+    HdCyclesEnvValue<std::string> tile_output_file;
+
+    /**
+     * @brief Compression of tile_output_file, as named by OpenImageIO
+     *
+     */
+    HdCyclesEnvValue<std::string> tile_output_compression;
+
+    /**
+     * @brief Number of worker processes a tiled frame is split across, each
+     * renders one horizontal band of tile rows
+     *
+     */
+    HdCyclesEnvValue<int> bucket_count;
+
+    /**
+     * @brief Band of the frame this process renders, from 0 to
+     * bucket_count - 1. Adding the outputs of all buckets gives the frame.
+     *
+     */
+    HdCyclesEnvValue<int> bucket_index;
+
     /**
      * @brief Start Resolution of render
      *
      */
     HdCyclesEnvValue<int> start_resolution;
 
+    /**
+     * @brief Samples rendered while the camera moves in interactive
+     * sessions, 0 disables navigation mode
+     *
+     */
+    HdCyclesEnvValue<int> navigation_samples;
+
+    /**
+     * @brief Seconds the camera has to rest before the render refines past
+     * the navigation samples
+     *
+     */
+    HdCyclesEnvValue<float> navigation_debounce;
+
     /**
      * @brief Exposure of cycles film
      *
@@ -300,6 +422,30 @@ public:
      */
     HdCyclesEnvValue<int> curve_subdivisions;
 
+    /* ===== Texture Settings ===== */
+
+    /**
+     * @brief Textures larger than this are downscaled on load in final
+     * renders, 0 loads them at full resolution
+     *
+     */
+    HdCyclesEnvValue<int> texture_limit;
+
+    /**
+     * @brief Texture size limit for interactive renders, a low limit gives a
+     * faster first pixel on texture heavy assets. 0 loads full resolution.
+     *
+     */
+    HdCyclesEnvValue<int> ipr_texture_limit;
+
+    /**
+     * @brief Memory limit in MB of the shared OpenImageIO texture cache,
+     * which streams tiles of mipmapped .tx files for OSL. 0 keeps the
+     * Cycles default. Has no effect with SVM, which loads whole images.
+     *
+     */
+    HdCyclesEnvValue<int> texture_cache_size;
+
     /* ===== Integrator Settings ===== */
 
     /**
@@ -351,11 +497,54 @@ public:
     HdCyclesEnvValue<int> volume_samples;
 
     /**
-     * @brief Number of adaptive min samples
+     * @brief Stop sampling pixels once their noise is below the adaptive
+     * threshold
+     *
+     */
+    HdCyclesEnvValue<bool> adaptive_sampling;
+
+    /**
+     * @brief Noise level pixels are considered converged at, 0 derives it
+     * from the sample count
+     *
+     */
+    HdCyclesEnvValue<float> adaptive_threshold;
+
+    /**
+     * @brief Number of adaptive min samples, 0 derives it from the sample
+     * count
      *
      */
     HdCyclesEnvValue<int> adaptive_min_samples;
 
+    /**
+     * @brief Seconds of rendering after which the render is considered done,
+     * excluding scene synchronization. 0 disables the limit.
+     *
+     */
+    HdCyclesEnvValue<double> time_limit;
+
+    /**
+     * @brief File progressive renders save their accumulated samples to.
+     * A render of the same frame resumes from it when it exists.
+     *
+     */
+    HdCyclesEnvValue<std::string> checkpoint_file;
+
+    /**
+     * @brief Seconds between two checkpoints, the last one is written when
+     * the render converges or hits the time limit
+     *
+     */
+    HdCyclesEnvValue<double> checkpoint_interval;
+
+    /**
+     * @brief Directory converted meshes are cached in across sessions,
+     * empty disables the cache
+     *
+     */
+    HdCyclesEnvValue<std::string> geometry_cache_dir;
+
 private:
     /**
      * @brief Constructor for reading the values from the environment variables.
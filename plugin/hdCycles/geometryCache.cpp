@@ -0,0 +1,376 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "geometryCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <render/attribute.h>
+#include <render/mesh.h>
+#include <util/util_version.h>
+
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/arch/systemInfo.h>
+#include <pxr/base/gf/vec2d.h>
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/vec4d.h>
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/imaging/hd/perfLog.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// An entry is this header, the prim path, the vertices, triangles, shader
+// and smooth arrays, then each attribute with its name and buffer
+struct _EntryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t float3Size;
+    uint64_t key;
+    uint32_t pathLength;
+    uint32_t numAttributes;
+    uint64_t numVerts;
+    uint64_t numTriangles;
+    int32_t motionSteps;
+    int32_t useMotionBlur;
+    float displayColor[3];
+};
+
+struct _AttributeHeader {
+    int32_t std;
+    int32_t element;
+    uint32_t flags;
+    int32_t baseType;
+    int32_t aggregate;
+    int32_t vecSemantics;
+    int32_t arrayLength;
+    uint32_t nameLength;
+    uint64_t size;
+};
+
+const char _kEntryMagic[8] = { 'H', 'D', 'C', 'Y', 'G', 'E', 'O', 'M' };
+const uint32_t _kEntryVersion = 1;
+
+// Reads from a mapped entry, failing once past its end
+class _Reader {
+public:
+    _Reader(const char* a_data, size_t a_size)
+        : m_data(a_data)
+        , m_size(a_size)
+        , m_offset(0)
+    {
+    }
+
+    bool Read(void* a_dst, size_t a_size)
+    {
+        if (a_size > m_size - m_offset)
+            return false;
+        if (a_size)
+            std::memcpy(a_dst, m_data + m_offset, a_size);
+        m_offset += a_size;
+        return true;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset;
+};
+
+template<typename T>
+bool
+_HashArray(const VtValue& a_value, uint64_t* a_hash)
+{
+    if (!a_value.IsHolding<VtArray<T>>())
+        return false;
+
+    const VtArray<T>& array = a_value.UncheckedGet<VtArray<T>>();
+    *a_hash = HdCyclesGeometryCache::Hash(array.cdata(),
+                                           array.size() * sizeof(T), *a_hash);
+    return true;
+}
+
+}  // namespace
+
+HdCyclesGeometryCache::HdCyclesGeometryCache(const std::string& a_directory)
+    : m_directory(a_directory)
+{
+    if (!TfIsDir(m_directory) && !TfMakeDirs(m_directory, -1, true)) {
+        TF_WARN("Can't create the geometry cache directory '%s'",
+                m_directory.c_str());
+    }
+}
+
+std::string
+HdCyclesGeometryCache::_GetPath(uint64_t a_key) const
+{
+    return TfStringCatPaths(m_directory,
+                            TfStringPrintf("%016llx.hdcgeo",
+                                           (unsigned long long)a_key));
+}
+
+uint64_t
+HdCyclesGeometryCache::GetConversionSeed()
+{
+    // Bump with any change to how meshes are converted, e.g. triangulation,
+    // tangents or attribute layout, entries of older builds then miss
+    static const int conversionVersion = 1;
+
+    static const uint64_t seed = [] {
+        const int versions[] = {
+            static_cast<int>(_kEntryVersion),
+            conversionVersion,
+            CYCLES_VERSION_MAJOR,
+            CYCLES_VERSION_MINOR,
+            CYCLES_VERSION_PATCH,
+            // Layout of the Cycles types written as they are in memory
+            static_cast<int>(sizeof(ccl::float3)),
+            static_cast<int>(ccl::ATTR_STD_NUM),
+        };
+        return Hash(versions, sizeof(versions), 0);
+    }();
+    return seed;
+}
+
+uint64_t
+HdCyclesGeometryCache::Hash(const void* a_data, size_t a_size,
+                            uint64_t a_seed)
+{
+    return ArchHash64(static_cast<const char*>(a_data), a_size, a_seed);
+}
+
+uint64_t
+HdCyclesGeometryCache::Hash(const VtValue& a_value, uint64_t a_seed)
+{
+    // The type keeps arrays of different types but equal bytes apart
+    const std::string typeName = a_value.GetTypeName();
+    uint64_t hash = Hash(typeName.data(), typeName.size(), a_seed);
+
+    if (_HashArray<float>(a_value, &hash) || _HashArray<double>(a_value, &hash)
+        || _HashArray<int>(a_value, &hash)
+        || _HashArray<GfVec2f>(a_value, &hash)
+        || _HashArray<GfVec3f>(a_value, &hash)
+        || _HashArray<GfVec4f>(a_value, &hash)
+        || _HashArray<GfVec2d>(a_value, &hash)
+        || _HashArray<GfVec3d>(a_value, &hash)
+        || _HashArray<GfVec4d>(a_value, &hash)) {
+        return hash;
+    }
+
+    const size_t valueHash = a_value.GetHash();
+    return Hash(&valueHash, sizeof(valueHash), hash);
+}
+
+bool
+HdCyclesGeometryCache::Load(uint64_t a_key, const SdfPath& a_id,
+                            ccl::Mesh* a_mesh,
+                            ccl::float3* a_displayColor) const
+{
+    HD_TRACE_FUNCTION();
+
+    const std::string path = _GetPath(a_key);
+    if (!TfIsFile(path))
+        return false;
+
+    std::string error;
+    ArchConstFileMapping mapping = ArchMapFileReadOnly(path, &error);
+    if (!mapping) {
+        TF_WARN("Can't map geometry cache entry '%s': %s", path.c_str(),
+                error.c_str());
+        return false;
+    }
+
+    _Reader reader(mapping.get(), ArchGetFileMappingLength(mapping));
+
+    _EntryHeader header;
+    if (!reader.Read(&header, sizeof(header))
+        || std::memcmp(header.magic, _kEntryMagic, sizeof(header.magic)) != 0
+        || header.version != _kEntryVersion
+        || header.float3Size != sizeof(ccl::float3) || header.key != a_key) {
+        return false;
+    }
+
+    // Keys include the path, this only guards against hash collisions
+    std::string primPath(header.pathLength, '\0');
+    if (!reader.Read(&primPath[0], primPath.size())
+        || primPath != a_id.GetString()) {
+        return false;
+    }
+
+    a_mesh->resize_mesh(static_cast<int>(header.numVerts),
+                        static_cast<int>(header.numTriangles));
+    a_mesh->motion_steps    = header.motionSteps;
+    a_mesh->use_motion_blur = header.useMotionBlur != 0;
+
+    bool valid = reader.Read(a_mesh->verts.data(),
+                             a_mesh->verts.size() * sizeof(ccl::float3))
+                 && reader.Read(a_mesh->triangles.data(),
+                                a_mesh->triangles.size() * sizeof(int))
+                 && reader.Read(a_mesh->shader.data(),
+                                a_mesh->shader.size() * sizeof(int))
+                 && reader.Read(a_mesh->smooth.data(),
+                                a_mesh->smooth.size() * sizeof(bool));
+
+    for (uint32_t i = 0; valid && i < header.numAttributes; ++i) {
+        _AttributeHeader attrHeader;
+        if (!reader.Read(&attrHeader, sizeof(attrHeader))) {
+            valid = false;
+            break;
+        }
+
+        std::string name(attrHeader.nameLength, '\0');
+        if (!reader.Read(&name[0], name.size())) {
+            valid = false;
+            break;
+        }
+
+        // Attributes are sized against the mesh resized above
+        const ccl::AttributeStandard standard
+            = static_cast<ccl::AttributeStandard>(attrHeader.std);
+        ccl::Attribute* attr = nullptr;
+        if (standard != ccl::ATTR_STD_NONE) {
+            attr = a_mesh->attributes.add(standard, ccl::ustring(name));
+        } else {
+            ccl::TypeDesc type(
+                static_cast<ccl::TypeDesc::BASETYPE>(attrHeader.baseType),
+                static_cast<ccl::TypeDesc::AGGREGATE>(attrHeader.aggregate),
+                static_cast<ccl::TypeDesc::VECSEMANTICS>(
+                    attrHeader.vecSemantics),
+                attrHeader.arrayLength);
+            attr = a_mesh->attributes.add(
+                ccl::ustring(name), type,
+                static_cast<ccl::AttributeElement>(attrHeader.element));
+        }
+
+        valid = attr && attr->buffer.size() == attrHeader.size
+                && reader.Read(attr->buffer.data(), attr->buffer.size());
+        if (valid)
+            attr->flags = attrHeader.flags;
+    }
+
+    if (!valid) {
+        TF_WARN("Ignoring geometry cache entry '%s', it is truncated",
+                path.c_str());
+        a_mesh->clear();
+        return false;
+    }
+
+    *a_displayColor = ccl::make_float3(header.displayColor[0],
+                                       header.displayColor[1],
+                                       header.displayColor[2]);
+    return true;
+}
+
+bool
+HdCyclesGeometryCache::Store(uint64_t a_key, const SdfPath& a_id,
+                             const ccl::Mesh* a_mesh,
+                             const ccl::float3& a_displayColor) const
+{
+    HD_TRACE_FUNCTION();
+
+    // Generated coordinates depend on the shaders, they are added on load
+    std::vector<const ccl::Attribute*> attributes;
+    for (const ccl::Attribute& attr : a_mesh->attributes.attributes) {
+        if (attr.std != ccl::ATTR_STD_GENERATED)
+            attributes.push_back(&attr);
+    }
+
+    const std::string& primPath = a_id.GetString();
+
+    _EntryHeader header;
+    std::memcpy(header.magic, _kEntryMagic, sizeof(header.magic));
+    header.version         = _kEntryVersion;
+    header.float3Size      = sizeof(ccl::float3);
+    header.key             = a_key;
+    header.pathLength      = static_cast<uint32_t>(primPath.size());
+    header.numAttributes   = static_cast<uint32_t>(attributes.size());
+    header.numVerts        = a_mesh->verts.size();
+    header.numTriangles    = a_mesh->num_triangles();
+    header.motionSteps     = a_mesh->motion_steps;
+    header.useMotionBlur   = a_mesh->use_motion_blur ? 1 : 0;
+    header.displayColor[0] = a_displayColor.x;
+    header.displayColor[1] = a_displayColor.y;
+    header.displayColor[2] = a_displayColor.z;
+
+    const std::string path    = _GetPath(a_key);
+    const std::string tmpPath = TfStringPrintf("%s.%d.tmp", path.c_str(),
+                                               ArchGetProcessId());
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(primPath.data(), primPath.size());
+        file.write(reinterpret_cast<const char*>(a_mesh->verts.data()),
+                   a_mesh->verts.size() * sizeof(ccl::float3));
+        file.write(reinterpret_cast<const char*>(a_mesh->triangles.data()),
+                   a_mesh->triangles.size() * sizeof(int));
+        file.write(reinterpret_cast<const char*>(a_mesh->shader.data()),
+                   a_mesh->shader.size() * sizeof(int));
+        file.write(reinterpret_cast<const char*>(a_mesh->smooth.data()),
+                   a_mesh->smooth.size() * sizeof(bool));
+
+        for (const ccl::Attribute* attr : attributes) {
+            const std::string name = attr->name.string();
+
+            _AttributeHeader attrHeader;
+            attrHeader.std          = static_cast<int32_t>(attr->std);
+            attrHeader.element      = static_cast<int32_t>(attr->element);
+            attrHeader.flags        = attr->flags;
+            attrHeader.baseType     = attr->type.basetype;
+            attrHeader.aggregate    = attr->type.aggregate;
+            attrHeader.vecSemantics = attr->type.vecsemantics;
+            attrHeader.arrayLength  = attr->type.arraylen;
+            attrHeader.nameLength   = static_cast<uint32_t>(name.size());
+            attrHeader.size         = attr->buffer.size();
+
+            file.write(reinterpret_cast<const char*>(&attrHeader),
+                       sizeof(attrHeader));
+            file.write(name.data(), name.size());
+            file.write(attr->buffer.data(), attr->buffer.size());
+        }
+
+        // Closed first, a failed final flush must not be moved into place
+        file.close();
+        if (!file) {
+            TF_WARN("Couldn't write geometry cache entry %s", tmpPath.c_str());
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        TF_WARN("Couldn't move geometry cache entry to %s", path.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,110 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef HD_CYCLES_GEOMETRY_CACHE_H
+#define HD_CYCLES_GEOMETRY_CACHE_H
+
+#include "api.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <util/util_types.h>
+
+#include <pxr/base/vt/value.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+
+namespace ccl {
+class Mesh;
+}  // namespace ccl
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * @brief On disk cache of converted meshes, keyed by prim path and a hash
+ * of the USD inputs the conversion read
+ *
+ * Each mesh is one file holding the Cycles arrays and attributes as they
+ * are in memory. Files are memory mapped when loaded and written next to
+ * their final name before being moved over it, so processes sharing a
+ * directory never read partial entries.
+ *
+ */
+class HdCyclesGeometryCache {
+public:
+    /**
+     * @brief Cache entries in a_directory, created when missing
+     *
+     */
+    explicit HdCyclesGeometryCache(const std::string& a_directory);
+
+    /**
+     * @brief Fill a cleared a_mesh from the entry of a_key
+     *
+     * @param a_key Hash of the inputs, see Hash
+     * @param a_id Prim the entry was stored for
+     * @param a_mesh Mesh to fill, its shaders are not cached
+     * @param a_displayColor Constant display color of the prim
+     * @return Returns true on a hit, a_mesh is left cleared otherwise
+     */
+    bool Load(uint64_t a_key, const SdfPath& a_id, ccl::Mesh* a_mesh,
+              ccl::float3* a_displayColor) const;
+
+    /**
+     * @brief Write a_mesh as the entry of a_key, safe to call from several
+     * threads for different keys
+     *
+     * @return Returns true if the entry was written
+     */
+    bool Store(uint64_t a_key, const SdfPath& a_id, const ccl::Mesh* a_mesh,
+               const ccl::float3& a_displayColor) const;
+
+    /**
+     * @brief Seed of every cache key, changes with the conversion code and
+     * the Cycles types it writes
+     *
+     */
+    static uint64_t GetConversionSeed();
+
+    /**
+     * @brief Fold a_data into the hash a_seed
+     *
+     */
+    static uint64_t Hash(const void* a_data, size_t a_size, uint64_t a_seed);
+
+    /**
+     * @brief Fold a_value into the hash a_seed. Arrays are hashed by their
+     * bytes, other values by VtValue::GetHash.
+     *
+     */
+    static uint64_t Hash(const VtValue& a_value, uint64_t a_seed);
+
+    const std::string& GetDirectory() const { return m_directory; }
+
+private:
+    std::string _GetPath(uint64_t a_key) const;
+
+    std::string m_directory;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif  // HD_CYCLES_GEOMETRY_CACHE_H
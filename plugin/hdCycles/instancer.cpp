@@ -19,10 +19,16 @@
 
 #include "instancer.h"
 
+#include "renderParam.h"
+
 #include <pxr/base/gf/matrix4f.h>
 #include <pxr/base/gf/quatd.h>
 #include <pxr/base/gf/quath.h>
 #include <pxr/base/gf/rotation.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/imaging/hd/perfLog.h>
+#include <pxr/imaging/hd/renderDelegate.h>
+#include <pxr/imaging/hd/renderIndex.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 
 PXR_NAMESPACE_OPEN_SCOPE
@@ -35,6 +41,7 @@ TF_DEFINE_PRIVATE_TOKENS(_tokens,
     (rotate)
     (scale)
     (translate)
+    (instancer)
 );
 // clang-format on
 
@@ -47,16 +54,27 @@ HdCyclesInstancer::Sync()
     const SdfPath& instancerId = GetId();
     auto& changeTracker = GetDelegate()->GetRenderIndex().GetChangeTracker();
 
-    // Use the double-checked locking pattern to check if this instancer's
-    // primvars are dirty.
+    // Use the double-checked locking pattern to check if this instancer is
+    // dirty. Transform and instance index changes only drop the cached
+    // samples, primvar changes are also pulled below.
     int dirtyBits = changeTracker.GetInstancerDirtyBits(instancerId);
-    if (!HdChangeTracker::IsAnyPrimvarDirty(dirtyBits, instancerId)) {
+    if (dirtyBits == HdChangeTracker::Clean) {
         return;
     }
 
     std::lock_guard<std::mutex> lock(m_syncMutex);
     dirtyBits = changeTracker.GetInstancerDirtyBits(instancerId);
+    if (dirtyBits == HdChangeTracker::Clean) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> cacheLock(m_sampleCacheMutex);
+        m_sampleCache.clear();
+    }
+
     if (!HdChangeTracker::IsAnyPrimvarDirty(dirtyBits, instancerId)) {
+        changeTracker.MarkInstancerClean(instancerId);
         return;
     }
 
@@ -100,6 +118,15 @@ HdCyclesInstancer::Sync()
 VtMatrix4dArray
 HdCyclesInstancer::ComputeTransforms(SdfPath const& prototypeId)
 {
+    HD_TRACE_FUNCTION();
+
+    // Includes the time of parent instancers
+    HdRenderDelegate* renderDelegate
+        = GetDelegate()->GetRenderIndex().GetRenderDelegate();
+    HdCyclesSyncTimer syncTimer(static_cast<HdCyclesRenderParam*>(
+                                    renderDelegate->GetRenderParam()),
+                                _tokens->instancer);
+
     Sync();
 
     GfMatrix4d instancerTransform = GetDelegate()->GetInstancerTransform(
@@ -107,49 +134,64 @@ HdCyclesInstancer::ComputeTransforms(SdfPath const& prototypeId)
     VtIntArray instanceIndices = GetDelegate()->GetInstanceIndices(GetId(),
                                                                    prototypeId);
 
-    VtMatrix4dArray transforms;
-    transforms.reserve(instanceIndices.size());
-    for (int idx : instanceIndices) {
-        GfMatrix4d translateMat(1);
-        GfMatrix4d rotateMat(1);
-        GfMatrix4d scaleMat(1);
-        GfMatrix4d transform(1);
+    VtMatrix4dArray transforms(instanceIndices.size());
+    GfMatrix4d* transformsData = transforms.data();
 
-        if (!m_translate.empty()) {
-            translateMat.SetTranslate(GfVec3d(m_translate.cdata()[idx]));
-        }
+    WorkParallelForN(instanceIndices.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int idx = instanceIndices.cdata()[i];
 
-        if (!m_rotate.empty()) {
-            auto& v = m_rotate.cdata()[idx];
-            rotateMat.SetRotate(GfQuatd(v[0], GfVec3d(v[1], v[2], v[3])));
-        }
+            GfMatrix4d translateMat(1);
+            GfMatrix4d rotateMat(1);
+            GfMatrix4d scaleMat(1);
+            GfMatrix4d transform(1);
 
-        if (!m_scale.empty()) {
-            scaleMat.SetScale(GfVec3d(m_scale.cdata()[idx]));
-        }
+            if (!m_translate.empty()) {
+                translateMat.SetTranslate(GfVec3d(m_translate.cdata()[idx]));
+            }
 
-        if (!m_transform.empty()) {
-            transform = m_transform.cdata()[idx];
-        }
+            if (!m_rotate.empty()) {
+                auto& v = m_rotate.cdata()[idx];
+                rotateMat.SetRotate(GfQuatd(v[0], GfVec3d(v[1], v[2], v[3])));
+            }
 
-        transforms.push_back(transform * scaleMat * rotateMat * translateMat
-                             * instancerTransform);
-    }
+            if (!m_scale.empty()) {
+                scaleMat.SetScale(GfVec3d(m_scale.cdata()[idx]));
+            }
+
+            if (!m_transform.empty()) {
+                transform = m_transform.cdata()[idx];
+            }
+
+            transformsData[i] = transform * scaleMat * rotateMat
+                                * translateMat * instancerTransform;
+        }
+    });
 
     auto parentInstancer = static_cast<HdCyclesInstancer*>(
         GetDelegate()->GetRenderIndex().GetInstancer(GetParentId()));
     if (!parentInstancer) {
+        syncTimer.AddElements(transforms.size());
         return transforms;
     }
 
-    VtMatrix4dArray wordTransform;
-    for (const GfMatrix4d& parentTransform :
-         parentInstancer->ComputeTransforms(GetId())) {
-        for (const GfMatrix4d& localTransform : transforms) {
-            wordTransform.push_back(parentTransform * localTransform);
+    const VtMatrix4dArray parentTransforms
+        = parentInstancer->ComputeTransforms(GetId());
+
+    VtMatrix4dArray wordTransform(parentTransforms.size() * transforms.size());
+    GfMatrix4d* wordTransformData = wordTransform.data();
+
+    WorkParallelForN(parentTransforms.size(), [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            const GfMatrix4d& parentTransform = parentTransforms.cdata()[j];
+            for (size_t k = 0; k < transforms.size(); ++k) {
+                wordTransformData[j * transforms.size() + k]
+                    = parentTransform * transforms.cdata()[k];
+            }
         }
-    }
+    });
 
+    syncTimer.AddElements(wordTransform.size());
     return wordTransform;
 }
 
@@ -179,10 +221,12 @@ ApplyTransform(VtValue const& allTransformsValue,
         return;
     }
 
-    for (size_t i = 0; i < instanceIndices.size(); ++i) {
-        transforms[i] = Op {}(allTransforms[instanceIndices[i]])
-                        * transforms[i];
-    }
+    WorkParallelForN(instanceIndices.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            transforms[i] = Op {}(allTransforms[instanceIndices[i]])
+                            * transforms[i];
+        }
+    });
 }
 
 // Apply interpolated transforms referenced by instanceIndices
@@ -199,12 +243,15 @@ ApplyTransform(float alpha, VtValue const& allTransformsValue0,
         return;
     }
 
-    for (size_t i = 0; i < instanceIndices.size(); ++i) {
-        auto transform
-            = HdResampleNeighbors(alpha, allTransforms0[instanceIndices[i]],
-                                  allTransforms1[instanceIndices[i]]);
-        transforms[i] = Op {}(transform)*transforms[i];
-    }
+    WorkParallelForN(instanceIndices.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto transform
+                = HdResampleNeighbors(alpha,
+                                      allTransforms0[instanceIndices[i]],
+                                      allTransforms1[instanceIndices[i]]);
+            transforms[i] = Op {}(transform)*transforms[i];
+        }
+    });
 }
 
 template<typename Op, typename T>
@@ -285,8 +332,32 @@ struct TransformOp {
 
 }  // namespace
 
-HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>
+HdCyclesInstancer::TransformSamples
 HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
+{
+    HD_TRACE_FUNCTION();
+
+    Sync();
+
+    {
+        std::lock_guard<std::mutex> lock(m_sampleCacheMutex);
+        auto it = m_sampleCache.find(prototypeId);
+        if (it != m_sampleCache.end()) {
+            return it->second;
+        }
+    }
+
+    // Computed without the lock so other prototypes aren't serialized
+    // behind this one, a concurrent duplicate computation is harmless
+    TransformSamples samples = _SampleInstanceTransforms(prototypeId);
+
+    std::lock_guard<std::mutex> lock(m_sampleCacheMutex);
+    m_sampleCache[prototypeId] = samples;
+    return samples;
+}
+
+HdCyclesInstancer::TransformSamples
+HdCyclesInstancer::_SampleInstanceTransforms(SdfPath const& prototypeId)
 {
     HdSceneDelegate* delegate  = GetDelegate();
     const SdfPath& instancerId = GetId();
@@ -437,12 +508,15 @@ HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
         // Multiply out each combination.
         VtMatrix4dArray& result = sa.values[i];
         result.resize(curParentXf.size() * curChildXf.size());
-        for (size_t j = 0; j < curParentXf.size(); ++j) {
-            for (size_t k = 0; k < curChildXf.size(); ++k) {
-                result[j * curChildXf.size() + k] = curChildXf[k]
-                                                    * curParentXf[j];
+        GfMatrix4d* resultData = result.data();
+        WorkParallelForN(curParentXf.size(), [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                for (size_t k = 0; k < curChildXf.size(); ++k) {
+                    resultData[j * curChildXf.size() + k]
+                        = curChildXf.cdata()[k] * curParentXf.cdata()[j];
+                }
             }
-        }
+        });
     }
 
     return sa;
@@ -23,6 +23,7 @@
 #include "hdcycles.h"
 
 #include <mutex>
+#include <unordered_map>
 
 #include <pxr/base/gf/matrix4d.h>
 #include <pxr/base/gf/vec3f.h>
@@ -30,6 +31,7 @@
 #include <pxr/base/vt/array.h>
 #include <pxr/imaging/hd/instancer.h>
 #include <pxr/imaging/hd/timeSampleArray.h>
+#include <pxr/usd/sdf/path.h>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -48,20 +50,38 @@ public:
     {
     }
 
+    using TransformSamples
+        = HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>;
+
     VtMatrix4dArray ComputeTransforms(SdfPath const& prototypeId);
 
-    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>
-    SampleInstanceTransforms(SdfPath const& prototypeId);
+    /**
+     * @brief Sample the world transforms of every instance of a prototype,
+     * including parent instancers. Results are cached per prototype until
+     * the instancer is dirtied, so prototypes sharing an instancer and
+     * nested instancers don't recompute them.
+     *
+     * This is thread safe.
+     *
+     * @param prototypeId Path of the prototype prim
+     * @return Instance transform samples
+     */
+    TransformSamples SampleInstanceTransforms(SdfPath const& prototypeId);
 
 private:
     void Sync();
 
+    TransformSamples _SampleInstanceTransforms(SdfPath const& prototypeId);
+
     VtMatrix4dArray m_transform;
     VtVec3fArray m_translate;
     VtVec4fArray m_rotate;
     VtVec3fArray m_scale;
 
     std::mutex m_syncMutex;
+
+    std::mutex m_sampleCacheMutex;
+    std::unordered_map<SdfPath, TransformSamples, SdfPath::Hash> m_sampleCache;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
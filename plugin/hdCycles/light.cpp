@@ -45,6 +45,8 @@ HdCyclesLight::HdCyclesLight(SdfPath const& id, TfToken const& lightType,
     , m_cyclesLight(nullptr)
     , m_hdLightType(lightType)
     , m_shaderGraphBits(ShaderGraphBits::Default)
+    , m_ownShader(nullptr)
+    , m_shaderHash(0)
     , m_renderDelegate(a_renderDelegate)
 {
     // Added to prevent fallback lights
@@ -61,16 +63,28 @@ HdCyclesLight::~HdCyclesLight()
         m_renderDelegate->GetCyclesRenderParam()->Interrupt();
     }
 
+    // The render param takes ownership of removed items
     if (m_cyclesLight) {
-        if (m_cyclesLight->shader) {
-            m_renderDelegate->GetCyclesRenderParam()->RemoveShader(m_cyclesLight->shader);
-            delete m_cyclesLight->shader;
-        }
+        _ReleaseShader(m_renderDelegate->GetCyclesRenderParam());
         m_renderDelegate->GetCyclesRenderParam()->RemoveLight(m_cyclesLight);
-        delete m_cyclesLight;
     }
 }
 
+void
+HdCyclesLight::_ReleaseShader(HdCyclesRenderParam* renderParam)
+{
+    ccl::Shader* shader = m_cyclesLight->shader;
+    if (!shader)
+        return;
+
+    // Shaders that aren't shared are removed from the scene directly
+    renderParam->ReleaseShader(shader);
+
+    m_cyclesLight->shader = nullptr;
+    m_ownShader           = nullptr;
+    m_shaderHash          = 0;
+}
+
 void
 HdCyclesLight::Finalize(HdRenderParam* renderParam)
 {
@@ -85,14 +99,16 @@ HdCyclesLight::_CreateCyclesLight(SdfPath const& id,
 
     m_cyclesLight->name = ccl::ustring(id.GetName().c_str());
 
-    ccl::Shader *shader = new ccl::Shader();
-
-    m_cyclesLight->shader = shader;
-
+    // Other lights get their shader on the first Sync
     if (m_hdLightType == HdPrimTypeTokens->domeLight) {
+        m_ownShader           = new ccl::Shader();
+        m_cyclesLight->shader = m_ownShader;
+
         m_cyclesLight->type = ccl::LIGHT_BACKGROUND;
-        shader->set_graph(_GetDefaultShaderGraph(true));
-        renderParam->SetBackgroundShader(shader);
+        m_ownShader->set_graph(_GetDefaultShaderGraph(true));
+        renderParam->SetBackgroundShader(m_ownShader);
+        renderParam->AddShader(m_ownShader);
+        m_ownShader->tag_update(scene);
     } else {
         if (m_hdLightType == HdPrimTypeTokens->diskLight) {
             m_cyclesLight->type  = ccl::LIGHT_AREA;
@@ -110,13 +126,10 @@ HdCyclesLight::_CreateCyclesLight(SdfPath const& id,
             m_cyclesLight->size = 1.0f;
         }
 
-        shader->set_graph(_GetDefaultShaderGraph());
     }
 
     renderParam->AddLight(m_cyclesLight);
 
-    renderParam->AddShader(shader);
-
     // Set defaults
     m_cyclesLight->use_diffuse      = true;
     m_cyclesLight->use_glossy       = true;
@@ -130,7 +143,6 @@ HdCyclesLight::_CreateCyclesLight(SdfPath const& id,
     m_cyclesLight->random_id
         = ccl::hash_uint2(ccl::hash_string(m_cyclesLight->name.c_str()), 0);
 
-    shader->tag_update(scene);
     m_cyclesLight->tag_update(scene);
 }
 
@@ -203,13 +215,15 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
 
+    HdCyclesSyncTimer syncTimer(param, m_hdLightType);
+
     ccl::Scene* scene = param->GetCyclesScene();
 
-    bool light_updated = false;
+    bool light_updated  = false;
+    bool shader_updated = false;
 
     if (*dirtyBits & HdLight::DirtyParams) {
         light_updated = true;
-        ccl::ShaderGraph *oldGraph = m_cyclesLight->shader->graph;
 
         // Check if we need to rebuild the graph
         ShaderGraphBits shaderGraphBits = ShaderGraphBits::Default;
@@ -240,18 +254,86 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
             }
         }
 
+        VtValue temperature;
+        if (shaderGraphBits & ShaderGraphBits::Temperature) {
+            temperature = sceneDelegate->GetLightParamValue(
+                id, HdLightTokens->colorTemperature);
+        }
+
+        const bool isBackground = m_cyclesLight->type == ccl::LIGHT_BACKGROUND;
+
+        // Dome lights and IES profiles bake the light transform into the
+        // graph and keep a shader of their own. Every other light shares its
+        // shader with the lights that have the same graph, color and
+        // intensity are applied through the light strength.
+        const bool ownShader = isBackground
+                               || (shaderGraphBits & ShaderGraphBits::IES);
+
+        bool editGraph         = false;
+        size_t shaderHash      = 0;
+        ccl::Shader* newShader = nullptr;
+
+        if (ownShader) {
+            if (!m_ownShader) {
+                _ReleaseShader(param);
+
+                m_ownShader           = new ccl::Shader();
+                m_ownShader->name     = id.GetString();
+                m_cyclesLight->shader = m_ownShader;
+                param->AddShader(m_ownShader);
+                editGraph = true;
+            }
+
+            // Ideally we would just check if it is different, however some
+            // nodes simplify & fold internally so we have to re-create the
+            // graph, so if there is any nodes used, re-create...
+            editGraph |= shaderGraphBits
+                         || shaderGraphBits != m_shaderGraphBits;
+        } else {
+            if (m_ownShader)
+                _ReleaseShader(param);
+
+            shaderHash = std::hash<std::string>()("light");
+            HdCyclesHashCombine(shaderHash, (size_t)shaderGraphBits);
+            if (temperature.IsHolding<float>()) {
+                HdCyclesHashCombine(shaderHash, std::hash<float>()(
+                    temperature.UncheckedGet<float>()));
+            }
+            if ((shaderGraphBits & ShaderGraphBits::Texture)
+                && m_hdLightType == HdPrimTypeTokens->rectLight) {
+                HdCyclesHashCombine(shaderHash, std::hash<std::string>()(
+                    textureFile.UncheckedGet<SdfAssetPath>()
+                        .GetResolvedPath()));
+            }
+
+            if (!m_cyclesLight->shader || shaderHash != m_shaderHash) {
+                ccl::Shader* shader = param->AcquireShader(
+                    shaderHash, m_cyclesLight->shader, &editGraph);
+                if (!shader) {
+                    newShader       = new ccl::Shader();
+                    newShader->name = id.GetString();
+                    shader          = newShader;
+                }
+
+                m_cyclesLight->shader = shader;
+                m_shaderHash          = shaderHash;
+            }
+        }
+
+        m_shaderGraphBits = shaderGraphBits;
+
+        // Graphs with shader graph bits are always rebuilt, so the nodes
+        // below are only added to fresh graphs. Reused shared graphs already
+        // match the parameters.
         ccl::ShaderGraph *graph = nullptr;
         ccl::ShaderNode *outNode = nullptr;
 
-        // Ideally we would just check if it is different, however some nodes
-        // simplify & fold internally so we have to re-create the graph, so if
-        // there is any nodes used, re-create...
-        if (shaderGraphBits || 
-            shaderGraphBits != m_shaderGraphBits) {
-            graph = _GetDefaultShaderGraph(m_cyclesLight->type == ccl::LIGHT_BACKGROUND);
+        if (editGraph) {
+            graph = _GetDefaultShaderGraph(isBackground);
             outNode = (ccl::ShaderNode*)graph->output()->input("Surface")->link->parent;
-            m_shaderGraphBits = shaderGraphBits;
-        } else {
+        } else if (isBackground) {
+            // The background color and strength are edited in place
+            ccl::ShaderGraph *oldGraph = m_cyclesLight->shader->graph;
             outNode = (ccl::ShaderNode*)oldGraph->output()->input("Surface")->link->parent;
         }
 
@@ -317,24 +399,15 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
         // Enable Temperature
         ccl::BlackbodyNode *blackbodyNode = nullptr;
-        if (shaderGraphBits & ShaderGraphBits::Temperature) {
-            // Get Temperature
-            VtValue temperature = sceneDelegate->GetLightParamValue(
-                id, HdLightTokens->colorTemperature);
+        if (graph && (shaderGraphBits & ShaderGraphBits::Temperature)) {
             if (temperature.IsHolding<float>()) {
-                if (graph) {
-                    blackbodyNode = new ccl::BlackbodyNode();
-                    graph->add(blackbodyNode);
+                blackbodyNode = new ccl::BlackbodyNode();
+                graph->add(blackbodyNode);
+
+                graph->connect(
+                    blackbodyNode->output("Color"),
+                    outNode->input("Color"));
 
-                    graph->connect(
-                        blackbodyNode->output("Color"),
-                        outNode->input("Color"));
-                }
-                else {
-                    blackbodyNode = (ccl::BlackbodyNode*)_FindShaderNode(
-                        oldGraph, ccl::BlackbodyNode::node_type);
-                }
-                assert(blackbodyNode != nullptr);
                 blackbodyNode->temperature = temperature.UncheckedGet<float>();
             }
         }
@@ -343,33 +416,27 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         // TODO: Perhaps usdCycles could store embedded IES into a string? ->ies can
         // be used instead of ->filename, Blender uses it to store IES profiles in
         // .blend files...
-        if (shaderGraphBits & ShaderGraphBits::IES) {
+        if (graph && (shaderGraphBits & ShaderGraphBits::IES)) {
             SdfAssetPath ap         = iesFile.UncheckedGet<SdfAssetPath>();
             std::string iesfilepath = ap.GetResolvedPath();
 
-            ccl::IESLightNode *iesNode = nullptr;
-            if (graph) {
-                ccl::TextureCoordinateNode *iesTransform = 
-                    new ccl::TextureCoordinateNode();
-                iesTransform->use_transform = true;
-                iesTransform->ob_tfm = m_cyclesLight->tfm;
-                graph->add(iesTransform);
+            ccl::TextureCoordinateNode *iesTransform = 
+                new ccl::TextureCoordinateNode();
+            iesTransform->use_transform = true;
+            iesTransform->ob_tfm = m_cyclesLight->tfm;
+            graph->add(iesTransform);
 
-                iesNode = new ccl::IESLightNode();
-                graph->add(iesNode);
+            ccl::IESLightNode *iesNode = new ccl::IESLightNode();
+            graph->add(iesNode);
 
-                graph->connect(
-                    iesTransform->output("Normal"),
-                    iesNode->input("Vector"));
+            graph->connect(
+                iesTransform->output("Normal"),
+                iesNode->input("Vector"));
+
+            graph->connect(
+                iesNode->output("Fac"),
+                outNode->input("Strength"));
 
-                graph->connect(
-                    iesNode->output("Fac"),
-                    outNode->input("Strength"));
-            } else {
-                iesNode = (ccl::IESLightNode*)_FindShaderNode(
-                    oldGraph, ccl::IESLightNode::node_type);
-            }
-            assert(iesNode != nullptr);
             iesNode->filename = iesfilepath;
         }
 
@@ -389,48 +456,42 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
             if (height.IsHolding<float>())
                 m_cyclesLight->sizev = height.UncheckedGet<float>();
 
-            if (shaderGraphBits & ShaderGraphBits::Texture) {
+            if (graph && (shaderGraphBits & ShaderGraphBits::Texture)) {
                 SdfAssetPath ap      = textureFile.UncheckedGet<SdfAssetPath>();
                 std::string filepath = ap.GetResolvedPath();
 
-                ccl::ImageTextureNode *textureNode = nullptr;
-                if (graph) {
-                    textureNode = new ccl::ImageTextureNode();
-                    graph->add(textureNode);
-                    ccl::GeometryNode *geometryNode = new ccl::GeometryNode();
-                    graph->add(geometryNode);
+                ccl::ImageTextureNode *textureNode
+                    = new ccl::ImageTextureNode();
+                graph->add(textureNode);
+                ccl::GeometryNode *geometryNode = new ccl::GeometryNode();
+                graph->add(geometryNode);
+
+                graph->connect(
+                    geometryNode->output("Parametric"),
+                    textureNode->input("Vector"));
 
+                if ((shaderGraphBits & ShaderGraphBits::Temperature) && blackbodyNode) {
+                    ccl::VectorMathNode *vecMathNode = new ccl::VectorMathNode();
+                    vecMathNode->type = ccl::NODE_VECTOR_MATH_MULTIPLY;
+                    graph->add(vecMathNode);
+
+                    graph->connect(
+                        textureNode->output("Color"),
+                        vecMathNode->input("Vector1"));
+
+                    graph->connect(
+                        blackbodyNode->output("Color"),
+                        vecMathNode->input("Vector2"));
+
+                    graph->disconnect(outNode->input("Color"));
                     graph->connect(
-                        geometryNode->output("Parametric"),
-                        textureNode->input("Vector"));
-
-                    if ((shaderGraphBits & ShaderGraphBits::Temperature) && blackbodyNode) {
-                        ccl::VectorMathNode *vecMathNode = new ccl::VectorMathNode();
-                        vecMathNode->type = ccl::NODE_VECTOR_MATH_MULTIPLY;
-                        graph->add(vecMathNode);
-
-                        graph->connect(
-                            textureNode->output("Color"),
-                            vecMathNode->input("Vector1"));
-
-                        graph->connect(
-                            blackbodyNode->output("Color"),
-                            vecMathNode->input("Vector2"));
-
-                        graph->disconnect(outNode->input("Color"));
-                        graph->connect(
-                            vecMathNode->output("Vector"),
-                            outNode->input("Color"));
-                    } else {
-                        graph->connect(
-                            textureNode->output("Color"),
-                            outNode->input("Color"));
-                    }
+                        vecMathNode->output("Vector"),
+                        outNode->input("Color"));
                 } else {
-                    textureNode = (ccl::ImageTextureNode*)_FindShaderNode(
-                        oldGraph, ccl::ImageTextureNode::node_type);
+                    graph->connect(
+                        textureNode->output("Color"),
+                        outNode->input("Color"));
                 }
-                assert(textureNode != nullptr);
                 textureNode->filename = filepath;
             }
         }
@@ -505,73 +566,81 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
             backroundNode->color = m_cyclesLight->strength;
 
             backroundNode->strength = m_finalIntensity;
+            shader_updated = true;
 
-            if (shaderGraphBits & ShaderGraphBits::Texture) {
+            if (graph && (shaderGraphBits & ShaderGraphBits::Texture)) {
                 SdfAssetPath ap      = textureFile.UncheckedGet<SdfAssetPath>();
                 std::string filepath = ap.GetResolvedPath();
 
-                ccl::EnvironmentTextureNode *backgroundTexture = nullptr;
-                if (graph) {
-                    // Add environment texture nodes
-                    ccl::TextureCoordinateNode *backgroundTransform = 
-                        new ccl::TextureCoordinateNode();
-                    backgroundTransform->use_transform = true;
-                    backgroundTransform->ob_tfm = m_cyclesLight->tfm;
-                    graph->add(backgroundTransform);
-
-                    backgroundTexture = 
-                        new ccl::EnvironmentTextureNode();
-                    if (param->GetUpAxis() == HdCyclesRenderParam::UpAxis::Y) {
-                        // Change co-ordinate mapping on environment texture to match other Hydra delegates
-                        backgroundTexture->tex_mapping.y_mapping = 
-                            ccl::TextureMapping::Z;
-                        backgroundTexture->tex_mapping.z_mapping = 
-                            ccl::TextureMapping::Y;
-                        backgroundTexture->tex_mapping.scale = 
-                            ccl::make_float3(-1.0f, 1.0f, 1.0f);
-                        backgroundTexture->tex_mapping.rotation = 
-                            ccl::make_float3(0.0f, 0.0f, M_PI * -0.5f);
-                    }
-
-                    graph->add(backgroundTexture);
+                // Add environment texture nodes
+                ccl::TextureCoordinateNode *backgroundTransform = 
+                    new ccl::TextureCoordinateNode();
+                backgroundTransform->use_transform = true;
+                backgroundTransform->ob_tfm = m_cyclesLight->tfm;
+                graph->add(backgroundTransform);
+
+                ccl::EnvironmentTextureNode *backgroundTexture = 
+                    new ccl::EnvironmentTextureNode();
+                if (param->GetUpAxis() == HdCyclesRenderParam::UpAxis::Y) {
+                    // Change co-ordinate mapping on environment texture to match other Hydra delegates
+                    backgroundTexture->tex_mapping.y_mapping = 
+                        ccl::TextureMapping::Z;
+                    backgroundTexture->tex_mapping.z_mapping = 
+                        ccl::TextureMapping::Y;
+                    backgroundTexture->tex_mapping.scale = 
+                        ccl::make_float3(-1.0f, 1.0f, 1.0f);
+                    backgroundTexture->tex_mapping.rotation = 
+                        ccl::make_float3(0.0f, 0.0f, M_PI * -0.5f);
+                }
+
+                graph->add(backgroundTexture);
+
+                graph->connect(
+                    backgroundTransform->output("Object"),
+                    backgroundTexture->input("Vector"));
+
+                if ((shaderGraphBits & ShaderGraphBits::Temperature) && blackbodyNode) {
+                    ccl::VectorMathNode *vecMathNode = new ccl::VectorMathNode();
+                    vecMathNode->type = ccl::NODE_VECTOR_MATH_MULTIPLY;
+                    graph->add(vecMathNode);
+
+                    graph->connect(
+                        backgroundTexture->output("Color"),
+                        vecMathNode->input("Vector1"));
+
+                    graph->connect(
+                        blackbodyNode->output("Color"),
+                        vecMathNode->input("Vector2"));
 
+                    graph->disconnect(outNode->input("Color"));
                     graph->connect(
-                        backgroundTransform->output("Object"),
-                        backgroundTexture->input("Vector"));
-
-                    if ((shaderGraphBits & ShaderGraphBits::Temperature) && blackbodyNode) {
-                        ccl::VectorMathNode *vecMathNode = new ccl::VectorMathNode();
-                        vecMathNode->type = ccl::NODE_VECTOR_MATH_MULTIPLY;
-                        graph->add(vecMathNode);
-
-                        graph->connect(
-                            backgroundTexture->output("Color"),
-                            vecMathNode->input("Vector1"));
-
-                        graph->connect(
-                            blackbodyNode->output("Color"),
-                            vecMathNode->input("Vector2"));
-
-                        graph->disconnect(outNode->input("Color"));
-                        graph->connect(
-                            vecMathNode->output("Vector"),
-                            outNode->input("Color"));
-                    } else {
-                        graph->connect(
-                            backgroundTexture->output("Color"),
-                            outNode->input("Color"));
-                    }
+                        vecMathNode->output("Vector"),
+                        outNode->input("Color"));
                 } else {
-                    backgroundTexture = (ccl::EnvironmentTextureNode*)_FindShaderNode(
-                        oldGraph, ccl::EnvironmentTextureNode::node_type);
+                    graph->connect(
+                        backgroundTexture->output("Color"),
+                        outNode->input("Color"));
                 }
-                assert(backgroundTexture != nullptr);
                 backgroundTexture->filename = filepath;
             }
         }
 
         if (graph) {
+            // The old graph is freed, the render thread and kernel loading
+            // read it with the scene locked
+            scene->mutex.lock();
             m_cyclesLight->shader->set_graph(graph);
+            scene->mutex.unlock();
+            shader_updated = true;
+        }
+
+        if (newShader) {
+            m_cyclesLight->shader = param->RegisterShader(shaderHash,
+                                                          newShader);
+
+            // A light with the same parameters registered its shader first
+            if (m_cyclesLight->shader != newShader)
+                delete newShader;
         }
     }
 
@@ -628,11 +697,18 @@ HdCyclesLight::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     if (*dirtyBits & HdLight::DirtyTransform) {
         light_updated = true;
         _SetTransform(HdCyclesExtractTransform(sceneDelegate, id));
+
+        // The dome transform lives in its graph
+        if (m_cyclesLight->type == ccl::LIGHT_BACKGROUND)
+            shader_updated = true;
     }
 
-    if (light_updated) {
+    if (shader_updated)
         m_cyclesLight->shader->tag_update(scene);
+
+    if (light_updated) {
         m_cyclesLight->tag_update(scene);
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeLights);
 
         param->Interrupt();
     }
@@ -151,10 +151,23 @@ private:
      */
     ccl::ShaderNode *_FindShaderNode(const ccl::ShaderGraph *graph, const ccl::NodeType *type);
 
+    /**
+     * @brief Drop the light shader, owned shaders are removed from the
+     * scene and shared ones released
+     *
+     * @param renderParam HdCycles renderParam
+     */
+    void _ReleaseShader(HdCyclesRenderParam* renderParam);
+
     const TfToken m_hdLightType;
     ccl::Light* m_cyclesLight;
     ShaderGraphBits m_shaderGraphBits;
 
+    // Dome and IES lights bake their transform into the graph and keep a
+    // shader of their own, other lights share one per parameter set
+    ccl::Shader* m_ownShader;
+    size_t m_shaderHash;
+
     bool m_normalize;
 
     HdCyclesRenderDelegate* m_renderDelegate;
@@ -24,6 +24,9 @@
 #include "renderParam.h"
 #include "utils.h"
 
+#include <functional>
+#include <unordered_map>
+
 #include <render/nodes.h>
 #include <render/object.h>
 #include <render/shader.h>
@@ -33,6 +36,9 @@
 #include <pxr/base/gf/vec3f.h>
 #include <pxr/base/tf/staticData.h>
 #include <pxr/base/tf/staticTokens.h>
+#include <pxr/imaging/hd/changeTracker.h>
+#include <pxr/imaging/hd/perfLog.h>
+#include <pxr/imaging/hd/renderIndex.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 #include <pxr/imaging/hf/diagnostic.h>
 #include <pxr/usd/sdf/types.h>
@@ -132,23 +138,16 @@ HdCyclesMaterial::HdCyclesMaterial(SdfPath const& id,
                                    HdCyclesRenderDelegate* a_renderDelegate)
     : HdMaterial(id)
     , m_shader(nullptr)
-    , m_shaderGraph(nullptr)
+    , m_networkHash(0)
     , m_renderDelegate(a_renderDelegate)
 {
-    m_shader        = new ccl::Shader();
-    m_shader->name  = id.GetString();
-    m_shaderGraph   = new ccl::ShaderGraph();
-    m_shader->graph = m_shaderGraph;
-
-    if (m_renderDelegate)
-        m_renderDelegate->GetCyclesRenderParam()->AddShader(m_shader);
 }
 
 HdCyclesMaterial::~HdCyclesMaterial()
 {
+    // The render param takes ownership of the shader with its last reference
     if (m_shader) {
-        m_renderDelegate->GetCyclesRenderParam()->RemoveShader(m_shader);
-        delete m_shader;
+        m_renderDelegate->GetCyclesRenderParam()->ReleaseShader(m_shader);
     }
 }
 
@@ -678,145 +677,253 @@ GetMaterialNetwork(TfToken const& terminal, HdSceneDelegate* delegate,
     return true;
 }
 
+/**
+ * @brief Content hash of a material network map, covers the node types,
+ * parameters, connections and terminals. Node paths are hashed by position,
+ * so copies of a network under different materials hash the same.
+ *
+ */
+static size_t
+_HashMaterialNetworkMap(HdMaterialNetworkMap const& a_networkMap)
+{
+    std::unordered_map<SdfPath, size_t, SdfPath::Hash> nodeIndices;
+    for (auto const& entry : a_networkMap.map) {
+        for (HdMaterialNode const& node : entry.second.nodes) {
+            nodeIndices.emplace(node.path, nodeIndices.size());
+        }
+    }
+
+    auto hashPath = [&nodeIndices](SdfPath const& a_path) -> size_t {
+        auto it = nodeIndices.find(a_path);
+        return (it != nodeIndices.end()) ? it->second : a_path.GetHash();
+    };
+
+    size_t hash = 0;
+    for (auto const& entry : a_networkMap.map) {
+        HdCyclesHashCombine(hash, entry.first.Hash());
+
+        for (HdMaterialNode const& node : entry.second.nodes) {
+            HdCyclesHashCombine(hash, node.identifier.Hash());
+            for (auto const& param : node.parameters) {
+                HdCyclesHashCombine(hash, param.first.Hash());
+                HdCyclesHashCombine(hash, param.second.GetHash());
+            }
+        }
+
+        for (HdMaterialRelationship const& rel : entry.second.relationships) {
+            HdCyclesHashCombine(hash, hashPath(rel.inputId));
+            HdCyclesHashCombine(hash, rel.inputName.Hash());
+            HdCyclesHashCombine(hash, hashPath(rel.outputId));
+            HdCyclesHashCombine(hash, rel.outputName.Hash());
+        }
+    }
+
+    for (SdfPath const& terminal : a_networkMap.terminals) {
+        HdCyclesHashCombine(hash, hashPath(terminal));
+    }
+
+    return hash;
+}
+
 void
 HdCyclesMaterial::Sync(HdSceneDelegate* sceneDelegate,
                        HdRenderParam* renderParam, HdDirtyBits* dirtyBits)
 {
+    HD_TRACE_FUNCTION();
+
     auto cyclesRenderParam     = static_cast<HdCyclesRenderParam*>(renderParam);
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
 
+    HdCyclesSyncTimer syncTimer(param, HdPrimTypeTokens->material);
+
     const SdfPath& id = GetId();
 
-    param->GetCyclesScene()->mutex.lock();
-    bool material_updated = false;
+    if (!(*dirtyBits & HdMaterial::DirtyResource)) {
+        *dirtyBits = Clean;
+        return;
+    }
+
+    VtValue vtMat = sceneDelegate->GetMaterialResource(id);
 
-    HdDirtyBits bits = *dirtyBits;
+    HdMaterialNetworkMap const* networkMap = nullptr;
+    if (vtMat.IsHolding<HdMaterialNetworkMap>()) {
+        networkMap = &vtMat.UncheckedGet<HdMaterialNetworkMap>();
+    }
 
+    size_t networkHash = networkMap ? _HashMaterialNetworkMap(*networkMap)
+                                    : 0;
 
-    if (*dirtyBits & HdMaterial::DirtyResource) {
-        VtValue vtMat = sceneDelegate->GetMaterialResource(id);
+#ifdef USE_USD_CYCLES_SCHEMA
+    // Shader settings are pulled into locals and applied in the commit,
+    // they are part of the hash as shared shaders must agree on them
+    ccl::DisplacementMethod displacement_method = ccl::DISPLACE_BUMP;
+    int pass_id                                 = 0;
+    bool use_mis                                = true;
+    bool use_transparent_shadow                 = true;
+    bool heterogeneous_volume                   = true;
+    float volume_step_rate                      = 1.0f;
+    ccl::VolumeInterpolation volume_interpolation_method
+        = ccl::VOLUME_INTERPOLATION_LINEAR;
+    ccl::VolumeSampling volume_sampling_method
+        = ccl::VOLUME_SAMPLING_MULTIPLE_IMPORTANCE;
 
-        if (vtMat.IsHolding<HdMaterialNetworkMap>()) {
-            if (m_shaderGraph) {
-                m_shaderGraph = new ccl::ShaderGraph();
-            }
+    if (m_shader) {
+        displacement_method         = m_shader->displacement_method;
+        pass_id                     = m_shader->pass_id;
+        use_mis                     = m_shader->use_mis;
+        use_transparent_shadow      = m_shader->use_transparent_shadow;
+        heterogeneous_volume        = m_shader->heterogeneous_volume;
+        volume_step_rate            = m_shader->volume_step_rate;
+        volume_interpolation_method = m_shader->volume_interpolation_method;
+        volume_sampling_method      = m_shader->volume_sampling_method;
+    }
+
+    TfToken displacementMethod = _HdCyclesGetParam<TfToken>(
+        sceneDelegate, id, usdCyclesTokens->cyclesMaterialDisplacement_method,
+        usdCyclesTokens->displacement_bump);
+
+    displacement_method = DISPLACEMENT_CONVERSION[displacementMethod];
 
-            auto& networkMap = vtMat.UncheckedGet<HdMaterialNetworkMap>();
+    pass_id = _HdCyclesGetParam<int>(sceneDelegate, id,
+                                     usdCyclesTokens->cyclesMaterialPass_id,
+                                     pass_id);
+
+    use_mis = _HdCyclesGetParam<bool>(sceneDelegate, id,
+                                      usdCyclesTokens->cyclesMaterialUse_mis,
+                                      use_mis);
+
+    use_transparent_shadow = _HdCyclesGetParam<bool>(
+        sceneDelegate, id,
+        usdCyclesTokens->cyclesMaterialUse_transparent_shadow,
+        use_transparent_shadow);
+
+    heterogeneous_volume = _HdCyclesGetParam<bool>(
+        sceneDelegate, id, usdCyclesTokens->cyclesMaterialHeterogeneous_volume,
+        heterogeneous_volume);
+
+    volume_step_rate = _HdCyclesGetParam<float>(
+        sceneDelegate, id, usdCyclesTokens->cyclesMaterialVolume_step_rate,
+        volume_step_rate);
+
+    TfToken volume_interpolation = _HdCyclesGetParam<TfToken>(
+        sceneDelegate, id,
+        usdCyclesTokens->cyclesMaterialVolume_interpolation_method,
+        usdCyclesTokens->volume_interpolation_linear);
+
+    volume_interpolation_method
+        = VOLUME_INTERPOLATION_CONVERSION[volume_interpolation];
+
+    TfToken volume_sampling = _HdCyclesGetParam<TfToken>(
+        sceneDelegate, id,
+        usdCyclesTokens->cyclesMaterialVolume_sampling_method,
+        usdCyclesTokens->volume_sampling_multiple_importance);
+
+    volume_sampling_method = VOLUME_SAMPLING_CONVERSION[volume_sampling];
+
+    HdCyclesHashCombine(networkHash, displacement_method);
+    HdCyclesHashCombine(networkHash, pass_id);
+    HdCyclesHashCombine(networkHash, use_mis);
+    HdCyclesHashCombine(networkHash, use_transparent_shadow);
+    HdCyclesHashCombine(networkHash, heterogeneous_volume);
+    HdCyclesHashCombine(networkHash, std::hash<float>()(volume_step_rate));
+    HdCyclesHashCombine(networkHash, volume_interpolation_method);
+    HdCyclesHashCombine(networkHash, volume_sampling_method);
+#endif
+
+    // Unchanged network, nothing to recompile
+    if (m_shader && networkHash == m_networkHash) {
+        *dirtyBits = Clean;
+        return;
+    }
+
+    // Materials with identical networks share one shader, so Cycles only
+    // compiles it once
+    bool needsBuild             = true;
+    ccl::Shader* previousShader = m_shader;
+    ccl::Shader* shader = param->AcquireShader(networkHash, m_shader,
+                                               &needsBuild);
+
+    ccl::Shader* newShader = nullptr;
+    if (!shader) {
+        newShader       = new ccl::Shader();
+        newShader->name = id.GetString();
+        shader          = newShader;
+    }
 
+    if (needsBuild) {
+        // The network is converted into a fresh graph that isn't referenced
+        // by the scene yet, so no lock is needed until it is handed over
+        ccl::ShaderGraph* graph = new ccl::ShaderGraph();
+
+        if (networkMap) {
             HdMaterialNetwork const* surface      = nullptr;
             HdMaterialNetwork const* displacement = nullptr;
             HdMaterialNetwork const* volume       = nullptr;
 
-            if (GetMaterialNetwork(HdCyclesMaterialTerminalTokens->surface,
-                                   sceneDelegate, networkMap,
-                                   *cyclesRenderParam, &surface,
-                                   m_shaderGraph)) {
-                if (m_shader && m_shaderGraph) {
-                    material_updated = true;
-                }
-            }
+            bool converted = false;
 
-            if (GetMaterialNetwork(HdCyclesMaterialTerminalTokens->displacement,
-                                   sceneDelegate, networkMap,
-                                   *cyclesRenderParam, &displacement,
-                                   m_shaderGraph)) {
-                if (m_shader && m_shaderGraph) {
-                    material_updated = true;
-                }
-            }
+            converted |= GetMaterialNetwork(
+                HdCyclesMaterialTerminalTokens->surface, sceneDelegate,
+                *networkMap, *cyclesRenderParam, &surface, graph);
 
-            if (GetMaterialNetwork(HdCyclesMaterialTerminalTokens->volume,
-                                   sceneDelegate, networkMap,
-                                   *cyclesRenderParam, &volume,
-                                   m_shaderGraph)) {
-                if (m_shader && m_shaderGraph) {
-                    material_updated = true;
-                }
-            }
+            converted |= GetMaterialNetwork(
+                HdCyclesMaterialTerminalTokens->displacement, sceneDelegate,
+                *networkMap, *cyclesRenderParam, &displacement, graph);
 
-            if (!material_updated) {
+            converted |= GetMaterialNetwork(
+                HdCyclesMaterialTerminalTokens->volume, sceneDelegate,
+                *networkMap, *cyclesRenderParam, &volume, graph);
+
+            if (!converted) {
                 TF_CODING_WARNING("Material type not supported");
             }
         }
-    }
 
-    if (*dirtyBits & HdMaterial::DirtyResource) {
-#ifdef USE_USD_CYCLES_SCHEMA
+        param->GetCyclesScene()->mutex.lock();
 
-        TfToken displacementMethod = _HdCyclesGetParam<TfToken>(
-            sceneDelegate, id,
-            usdCyclesTokens->cyclesMaterialDisplacement_method,
-            usdCyclesTokens->displacement_bump);
+#ifdef USE_USD_CYCLES_SCHEMA
+        shader->displacement_method         = displacement_method;
+        shader->pass_id                     = pass_id;
+        shader->use_mis                     = use_mis;
+        shader->use_transparent_shadow      = use_transparent_shadow;
+        shader->heterogeneous_volume        = heterogeneous_volume;
+        shader->volume_step_rate            = volume_step_rate;
+        shader->volume_interpolation_method = volume_interpolation_method;
+        shader->volume_sampling_method      = volume_sampling_method;
+#endif
 
-        if (m_shader->displacement_method
-            != DISPLACEMENT_CONVERSION[displacementMethod]) {
-            m_shader->displacement_method
-                = DISPLACEMENT_CONVERSION[displacementMethod];
-        }
+        // set_graph takes ownership and frees the previous graph
+        shader->set_graph(graph);
 
-        m_shader->pass_id
-            = _HdCyclesGetParam<int>(sceneDelegate, id,
-                                     usdCyclesTokens->cyclesMaterialPass_id,
-                                     m_shader->pass_id);
+        shader->tag_update(param->GetCyclesScene());
+        shader->tag_used(param->GetCyclesScene());
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeShaders);
 
-        m_shader->use_mis
-            = _HdCyclesGetParam<bool>(sceneDelegate, id,
-                                      usdCyclesTokens->cyclesMaterialUse_mis,
-                                      m_shader->use_mis);
-
-        m_shader->use_transparent_shadow = _HdCyclesGetParam<bool>(
-            sceneDelegate, id,
-            usdCyclesTokens->cyclesMaterialUse_transparent_shadow,
-            m_shader->use_transparent_shadow);
-
-        m_shader->heterogeneous_volume = _HdCyclesGetParam<bool>(
-            sceneDelegate, id,
-            usdCyclesTokens->cyclesMaterialHeterogeneous_volume,
-            m_shader->heterogeneous_volume);
-
-        m_shader->volume_step_rate = _HdCyclesGetParam<float>(
-            sceneDelegate, id, usdCyclesTokens->cyclesMaterialVolume_step_rate,
-            m_shader->volume_step_rate);
-
-        TfToken volume_interpolation = _HdCyclesGetParam<TfToken>(
-            sceneDelegate, id,
-            usdCyclesTokens->cyclesMaterialVolume_interpolation_method,
-            usdCyclesTokens->volume_interpolation_linear);
-
-        if (m_shader->volume_interpolation_method
-            != VOLUME_INTERPOLATION_CONVERSION[volume_interpolation]) {
-            m_shader->volume_interpolation_method
-                = VOLUME_INTERPOLATION_CONVERSION[volume_interpolation];
-        }
+        param->GetCyclesScene()->mutex.unlock();
 
-        TfToken volume_sampling = _HdCyclesGetParam<TfToken>(
-            sceneDelegate, id,
-            usdCyclesTokens->cyclesMaterialVolume_sampling_method,
-            usdCyclesTokens->volume_sampling_multiple_importance);
+        _DumpGraph(shader->graph, shader->name.c_str());
+    }
 
-        if (m_shader->volume_sampling_method
-            != VOLUME_SAMPLING_CONVERSION[volume_sampling]) {
-            m_shader->volume_sampling_method
-                = VOLUME_SAMPLING_CONVERSION[volume_sampling];
-        }
-        material_updated = true;
+    if (newShader) {
+        shader = param->RegisterShader(networkHash, newShader);
 
-#endif
+        // An identical material registered its shader first
+        if (shader != newShader)
+            delete newShader;
     }
 
-    if (material_updated) {
-        if (m_shader->graph != m_shaderGraph) {
-            m_shader->set_graph(m_shaderGraph);
-        }
-
-        m_shader->tag_update(param->GetCyclesScene());
-        m_shader->tag_used(param->GetCyclesScene());
-        param->Interrupt();
+    m_shader      = shader;
+    m_networkHash = networkHash;
 
-        _DumpGraph(m_shaderGraph, m_shader->name.c_str());
+    // Rprims bound earlier still reference the previous shader. The bindings
+    // aren't known here, so like HdStMaterial every rprim re-resolves its
+    // material. This only happens when a shared material is edited.
+    if (previousShader && previousShader != m_shader) {
+        sceneDelegate->GetRenderIndex().GetChangeTracker().MarkAllRprimsDirty(
+            HdChangeTracker::DirtyMaterialId);
     }
 
-    param->GetCyclesScene()->mutex.unlock();
+    param->Interrupt();
 
     *dirtyBits = Clean;
 }
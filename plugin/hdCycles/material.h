@@ -124,8 +124,9 @@ public:
     ccl::Shader* GetCyclesShader() const;
 
 protected:
+    // Possibly shared with other materials of an identical network
     ccl::Shader* m_shader;
-    ccl::ShaderGraph* m_shaderGraph;
+    size_t m_networkHash;
 
     HdCyclesRenderDelegate* m_renderDelegate;
 };
@@ -20,6 +20,7 @@
 #include "mesh.h"
 
 #include "config.h"
+#include "geometryCache.h"
 #include "instancer.h"
 #include "material.h"
 #include "renderDelegate.h"
@@ -28,6 +29,8 @@
 
 #include "Mikktspace/mikktspace.h"
 
+#include <algorithm>
+#include <list>
 #include <vector>
 
 #include <render/mesh.h>
@@ -44,10 +47,12 @@
 #include <pxr/base/gf/vec2f.h>
 #include <pxr/base/gf/vec3f.h>
 #include <pxr/base/gf/vec3i.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/work/loops.h>
 #include <pxr/imaging/hd/changeTracker.h>
 #include <pxr/imaging/hd/extComputationUtils.h>
 #include <pxr/imaging/hd/mesh.h>
-#include <pxr/imaging/hd/meshUtil.h>
+#include <pxr/imaging/hd/perfLog.h>
 #include <pxr/imaging/hd/points.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 #include <pxr/imaging/hd/smoothNormals.h>
@@ -61,16 +66,44 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 // clang-format off
 TF_DEFINE_PRIVATE_TOKENS(_tokens, 
+    (accelerations)
     (st)
     (uv)
 );
 // clang-format on
 
+namespace {
+
+// Primvar read for a rebuild, shared by the cache key and the conversion
+struct _DirtyPrimvar {
+    HdPrimvarDescriptor desc;
+    HdInterpolation interpolation;
+    VtValue value;
+};
+
+// Translation of the sample at the frame, or the first one
+GfVec3d
+_HdCyclesSamplePosition(
+    const HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& a_samples)
+{
+    if (a_samples.count == 0)
+        return GfVec3d(0.0);
+
+    for (size_t i = 0; i < a_samples.count; ++i) {
+        if (a_samples.times[i] == 0.0f)
+            return a_samples.values[i].ExtractTranslation();
+    }
+    return a_samples.values[0].ExtractTranslation();
+}
+
+}  // namespace
+
 HdCyclesMesh::HdCyclesMesh(SdfPath const& id, SdfPath const& instancerId,
                            HdCyclesRenderDelegate* a_renderDelegate)
     : HdMesh(id, instancerId)
     , m_renderDelegate(a_renderDelegate)
     , m_cyclesMesh(nullptr)
+    , m_stagingMesh(nullptr)
     , m_cyclesObject(nullptr)
     , m_hasVertexColors(false)
     , m_visibilityFlags(ccl::PATH_RAY_ALL_VISIBILITY)
@@ -80,9 +113,15 @@ HdCyclesMesh::HdCyclesMesh(SdfPath const& id, SdfPath const& instancerId,
     , m_visScatter(true)
     , m_visShadow(true)
     , m_visTransmission(true)
+    , m_isShadowCatcher(false)
+    , m_useHoldout(false)
+    , m_passId(-1)
+    , m_displayColor(ccl::make_float3(0.0f, 0.0f, 0.0f))
+    , m_materialShader(nullptr)
     , m_velocityScale(1.0f)
     , m_useMotionBlur(false)
     , m_useDeformMotionBlur(false)
+    , m_motionSteps(HD_CYCLES_MOTION_STEPS)
 {
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
     config.enable_subdivision.eval(m_subdivEnabled, true);
@@ -94,6 +133,10 @@ HdCyclesMesh::HdCyclesMesh(SdfPath const& id, SdfPath const& instancerId,
 
     m_cyclesMesh = _CreateCyclesMesh();
 
+    // Never added to the scene, Sync builds into this without holding the
+    // scene lock and _CommitMesh moves the result into m_cyclesMesh
+    m_stagingMesh = _CreateCyclesMesh();
+
     m_numTransformSamples = HD_CYCLES_MOTION_STEPS;
 
     if (m_useMotionBlur) {
@@ -109,24 +152,34 @@ HdCyclesMesh::HdCyclesMesh(SdfPath const& id, SdfPath const& instancerId,
         // TODO: Needed when we properly handle motion_verts
         m_cyclesMesh->motion_steps    = m_motionSteps;
         m_cyclesMesh->use_motion_blur = m_useDeformMotionBlur;
+
+        m_stagingMesh->motion_steps    = m_motionSteps;
+        m_stagingMesh->use_motion_blur = m_useDeformMotionBlur;
     }
 
     m_cyclesObject->geometry = m_cyclesMesh;
 
-    m_renderDelegate->GetCyclesRenderParam()->AddGeometry(m_cyclesMesh);
+    m_renderDelegate->GetCyclesRenderParam()->RegisterGeometry(m_cyclesMesh);
     m_renderDelegate->GetCyclesRenderParam()->AddObject(m_cyclesObject);
 }
 
 HdCyclesMesh::~HdCyclesMesh()
 {
+    m_renderDelegate->GetCyclesRenderParam()->UnregisterSubdivMesh(GetId());
+
+    // The render param takes ownership of removed items, a shared mesh is
+    // only removed with its last user
     if (m_cyclesMesh) {
-        m_renderDelegate->GetCyclesRenderParam()->RemoveMesh(m_cyclesMesh);
-        delete m_cyclesMesh;
+        m_renderDelegate->GetCyclesRenderParam()->ReleaseGeometry(
+            m_cyclesMesh);
+    }
+
+    if (m_stagingMesh) {
+        delete m_stagingMesh;
     }
 
     if (m_cyclesObject) {
         m_renderDelegate->GetCyclesRenderParam()->RemoveObject(m_cyclesObject);
-        delete m_cyclesObject;
     }
 
     if (m_cyclesInstances.size() > 0) {
@@ -134,7 +187,6 @@ HdCyclesMesh::~HdCyclesMesh()
             if (instance) {
                 m_renderDelegate->GetCyclesRenderParam()->RemoveObject(
                     instance);
-                delete instance;
             }
         }
     }
@@ -209,13 +261,13 @@ HdCyclesMesh::_ComputeTangents(bool needsign)
 {
     // This is likely deprecated now
     const ccl::AttributeSet& attributes = (m_useSubdivision && m_subdivEnabled)
-                                              ? m_cyclesMesh->subd_attributes
-                                              : m_cyclesMesh->attributes;
+                                              ? m_stagingMesh->subd_attributes
+                                              : m_stagingMesh->attributes;
 
     ccl::Attribute* attr = attributes.find(ccl::ATTR_STD_UV);
     if (attr) {
         mikk_compute_tangents(attr->standard_name(ccl::ATTR_STD_UV),
-                              m_cyclesMesh, needsign, true);
+                              m_stagingMesh, needsign, true);
     }
 }
 
@@ -224,21 +276,11 @@ HdCyclesMesh::_AddUVSet(TfToken name, VtValue uvs, ccl::Scene* scene,
                         HdInterpolation interpolation)
 {
     ccl::AttributeSet* attributes = (m_useSubdivision && m_subdivEnabled)
-                                        ? &m_cyclesMesh->subd_attributes
-                                        : &m_cyclesMesh->attributes;
+                                        ? &m_stagingMesh->subd_attributes
+                                        : &m_stagingMesh->attributes;
     bool subdivide_uvs = false;
 
-    ccl::ustring uv_name      = ccl::ustring(name.GetString());
-    ccl::ustring tangent_name = ccl::ustring(name.GetString() + ".tangent");
-
-    bool need_uv = m_cyclesMesh->need_attribute(scene, uv_name)
-                   || m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_UV);
-    bool need_tangent
-        = m_cyclesMesh->need_attribute(scene, tangent_name)
-          || m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_UV_TANGENT);
-
-    // Forced true for now... Should be based on shader compilation needs
-    need_tangent = true;
+    ccl::ustring uv_name = ccl::ustring(name.GetString());
 
     ccl::Attribute* attr = attributes->add(ccl::ATTR_STD_UV, uv_name);
 
@@ -248,81 +290,156 @@ HdCyclesMesh::_AddUVSet(TfToken name, VtValue uvs, ccl::Scene* scene,
     _PopulateAttribute(name, HdPrimvarRoleTokens->textureCoordinate,
                        interpolation, uvs, attr, this);
 
-    if (need_tangent) {
-        ccl::ustring sign_name = ccl::ustring(name.GetString()
-                                              + ".tangent_sign");
-        bool need_sign
-            = m_cyclesMesh->need_attribute(scene, sign_name)
-              || m_cyclesMesh->need_attribute(scene,
-                                              ccl::ATTR_STD_UV_TANGENT_SIGN);
-
-
-        // Forced for now
-        need_sign = true;
-        mikk_compute_tangents(name.GetString().c_str(), m_cyclesMesh, need_sign,
-                              true);
-    }
+    // Tangents follow in _PopulateTangents
+    m_uvSets.emplace_back(name, uvs);
 }
 
 void
-HdCyclesMesh::_AddVelocities(VtVec3fArray& velocities,
-                             HdInterpolation interpolation)
+HdCyclesMesh::_PopulateTangents(ccl::Scene* scene, ccl::Mesh* a_mesh,
+                                bool a_sceneLocked)
 {
-    ccl::AttributeSet* attributes = (m_useSubdivision && m_subdivEnabled)
-                                        ? &m_cyclesMesh->subd_attributes
-                                        : &m_cyclesMesh->attributes;
+    HD_TRACE_FUNCTION();
 
-    m_cyclesMesh->use_motion_blur = true;
-    m_cyclesMesh->motion_steps    = 3;
-
-    ccl::Attribute* attr_mP = attributes->find(
-        ccl::ATTR_STD_MOTION_VERTEX_POSITION);
-
-    if (attr_mP)
-        attributes->remove(attr_mP);
+    if (m_uvSets.empty()) {
+        m_tangentCache.clear();
+        return;
+    }
 
-    if (!attr_mP) {
-        attr_mP = attributes->add(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+    // Interactive sessions edit materials without resyncing the meshes
+    // using them, so unused tangents are only skipped for batch renders
+    // Cached meshes can be loaded by sessions with other materials, they
+    // keep all tangents
+    HdCyclesRenderParam* param = m_renderDelegate->GetCyclesRenderParam();
+    ccl::Session* session      = param->GetCyclesSession();
+    const bool lazy = session && session->params.background
+                      && !param->GetGeometryCache();
+
+    std::vector<char> needTangents(m_uvSets.size(), lazy ? 0 : 1);
+    std::vector<char> needSigns(m_uvSets.size(), lazy ? 0 : 1);
+
+    // Shader graphs are compiled in place by the render thread, only
+    // inspect them with the scene locked
+    if (lazy) {
+        if (!a_sceneLocked)
+            scene->mutex.lock();
+        for (size_t i = 0; i < m_uvSets.size(); ++i) {
+            bool needSign   = false;
+            needTangents[i] = HdCyclesShadersNeedTangents(
+                m_usedShaders, m_uvSets[i].first.GetString(), i == 0,
+                &needSign);
+            needSigns[i] = needSign;
+        }
+        if (!a_sceneLocked)
+            scene->mutex.unlock();
     }
-    //ccl::float3* vdata = attr_mP->data_float3();
 
-    /*if (interpolation == HdInterpolationVertex) {
-        VtIntArray::const_iterator idxIt = m_faceVertexIndices.begin();
+    struct Layer {
+        const char* name;
+        ccl::Attribute* tangent;
+        ccl::Attribute* sign;
+        TangentCache* cache;
+        bool cached;
+    };
+    std::vector<Layer> layers;
+    std::map<TfToken, TangentCache> tangentCache;
+
+    // The attribute set is not thread safe, everything is added up front
+    for (size_t i = 0; i < m_uvSets.size(); ++i) {
+        if (!needTangents[i])
+            continue;
 
-        // TODO: Add support for subd faces?
-        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-            const int vCount = m_faceVertexCounts[i];
+        const TfToken& name = m_uvSets[i].first;
 
-            for (int j = 1; j < vCount - 1; ++j) {
-                int v0 = *idxIt;
-                int v1 = *(idxIt + j + 0);
-                int v2 = *(idxIt + j + 1);
-
-                if (m_orientation == HdTokens->leftHanded) {
-                    int temp = v2;
-                    v2       = v0;
-                    v0       = temp;
-                }
+        Layer layer;
+        layer.name    = name.GetText();
+        layer.tangent = nullptr;
+        layer.sign    = nullptr;
+        mikk_add_tangents(layer.name, a_mesh, true, &layer.tangent,
+                          needSigns[i] ? &layer.sign : nullptr);
 
-                vdata[0] = vec3f_to_float3(velocities[v0]);
-                vdata[1] = vec3f_to_float3(velocities[v1]);
-                vdata[2] = vec3f_to_float3(velocities[v2]);
-                vdata += 3;
-            }
-            idxIt += vCount;
+        // Entries of uv sets no longer used are dropped with the old map
+        auto it = m_tangentCache.find(name);
+        if (it != m_tangentCache.end()) {
+            tangentCache[name] = std::move(it->second);
         }
-    } else {*/
 
-    ccl::float3* mP = attr_mP->data_float3();
+        TangentCache& cache = tangentCache[name];
+        layer.cache         = &cache;
 
-    for (size_t i = 0; i < m_cyclesMesh->motion_steps; ++i) {
-        //VtVec3fArray pp;
-        //pp = m_pointSamples.values.data()[i].Get<VtVec3fArray>();
+        layer.cached = cache.uvs == m_uvSets[i].second
+                       && cache.points == m_points
+                       && cache.tangent.size() == layer.tangent->buffer.size();
+        if (layer.sign)
+            layer.cached &= cache.sign.size() == layer.sign->buffer.size();
 
-        for (size_t j = 0; j < velocities.size(); ++j, ++mP) {
-            *mP = vec3f_to_float3(m_points[j]
-                                  + (velocities[j] * m_velocityScale));
+        cache.uvs    = m_uvSets[i].second;
+        cache.points = m_points;
+
+        layers.push_back(layer);
+    }
+    m_tangentCache.swap(tangentCache);
+
+    // Mikktspace would add missing normals itself, which is not safe from
+    // several layers at once
+    const ccl::AttributeSet& attributes = (a_mesh->subd_faces.size())
+                                              ? a_mesh->subd_attributes
+                                              : a_mesh->attributes;
+    bool anyGenerated = false;
+    for (const Layer& layer : layers) {
+        anyGenerated |= !layer.cached;
+    }
+    if (anyGenerated && !attributes.find(ccl::ATTR_STD_VERTEX_NORMAL)) {
+        a_mesh->add_face_normals();
+        a_mesh->add_vertex_normals();
+    }
+
+    WorkParallelForEach(layers.begin(), layers.end(), [&](const Layer& layer) {
+        if (!layer.cached) {
+            mikk_generate_tangents(layer.name, a_mesh,
+                                   layer.tangent->data_float3(),
+                                   layer.sign ? layer.sign->data_float()
+                                              : nullptr);
+            layer.cache->tangent = layer.tangent->buffer;
+            if (layer.sign)
+                layer.cache->sign = layer.sign->buffer;
+        } else {
+            layer.tangent->buffer = layer.cache->tangent;
+            if (layer.sign)
+                layer.sign->buffer = layer.cache->sign;
         }
+    });
+}
+
+void
+HdCyclesMesh::_PopulateVelocityMotion()
+{
+    ccl::AttributeSet* attributes = (m_useSubdivision)
+                                        ? &m_stagingMesh->subd_attributes
+                                        : &m_stagingMesh->attributes;
+
+    attributes->remove(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+
+    if (m_velocities.size() != m_points.size()
+        || m_points.size() != m_numMeshVerts) {
+        return;
+    }
+
+    const std::vector<float> offsets = HdCyclesMotionStepOffsets(
+        m_renderDelegate->GetCyclesRenderParam()->GetCyclesScene(),
+        m_motionSteps);
+
+    m_stagingMesh->use_motion_blur = true;
+    m_stagingMesh->motion_steps    = static_cast<int>(offsets.size()) + 1;
+
+    ccl::Attribute* attr_mP = attributes->add(
+        ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+
+    ccl::float3* mP = attr_mP->data_float3();
+
+    for (float offset : offsets) {
+        HdCyclesExtrapolatePoints(m_points, m_velocities, m_accelerations,
+                                  offset * m_velocityScale, mP);
+        mP += m_numMeshVerts;
     }
 }
 
@@ -334,14 +451,10 @@ HdCyclesMesh::_AddColors(TfToken name, TfToken role, VtValue colors,
         return;
 
     ccl::AttributeSet* attributes = (m_useSubdivision && m_subdivEnabled)
-                                        ? &m_cyclesMesh->subd_attributes
-                                        : &m_cyclesMesh->attributes;
+                                        ? &m_stagingMesh->subd_attributes
+                                        : &m_stagingMesh->attributes;
 
-    ccl::AttributeStandard vcol_std = ccl::ATTR_STD_VERTEX_COLOR;
-    ccl::ustring vcol_name          = ccl::ustring(name.GetString());
-
-    const bool need_vcol = m_cyclesMesh->need_attribute(scene, vcol_name)
-                           || m_cyclesMesh->need_attribute(scene, vcol_std);
+    ccl::ustring vcol_name = ccl::ustring(name.GetString());
 
     // TODO: Maybe we move this to _PopulateAttributes as well?
     // seems generic enough. Although different types (uv/vel/cols)
@@ -373,16 +486,19 @@ HdCyclesMesh::_AddColors(TfToken name, TfToken role, VtValue colors,
         ctype = ccl::TypeDesc::TypeFloat;
     } else if (colors.IsHolding<VtArray<GfVec2f>>()
                || colors.IsHolding<VtArray<GfVec2d>>()
-               || colors.IsHolding<VtArray<GfVec2i>>()) {
+               || colors.IsHolding<VtArray<GfVec2i>>()
+               || colors.IsHolding<VtArray<GfVec2h>>()) {
         ctype = ccl::TypeFloat2;
     } else if (colors.IsHolding<VtArray<GfVec3f>>()
                || colors.IsHolding<VtArray<GfVec3d>>()
-               || colors.IsHolding<VtArray<GfVec3i>>()) {
+               || colors.IsHolding<VtArray<GfVec3i>>()
+               || colors.IsHolding<VtArray<GfVec3h>>()) {
         ctype = ccl::TypeDesc::TypeColor;
 
     } else if (colors.IsHolding<VtArray<GfVec4f>>()
                || colors.IsHolding<VtArray<GfVec4d>>()
-               || colors.IsHolding<VtArray<GfVec4i>>()) {
+               || colors.IsHolding<VtArray<GfVec4i>>()
+               || colors.IsHolding<VtArray<GfVec4h>>()) {
         ctype = ccl::TypeDesc::TypeVector;
     }
 
@@ -416,55 +532,63 @@ HdCyclesMesh::_AddColors(TfToken name, TfToken role, VtValue colors,
                 << colors.GetTypeName() << "\n";
         }
 
-        m_cyclesObject->color = ccl::make_float3(displayColor.x, displayColor.y,
-                                                 displayColor.z);
+        m_displayColor = ccl::make_float3(displayColor.x, displayColor.y,
+                                          displayColor.z);
     }
 }
 
 void
-HdCyclesMesh::_AddNormals(VtVec3fArray& normals, HdInterpolation interpolation)
+HdCyclesMesh::_AddNormals(const VtVec3fArray& normals,
+                          HdInterpolation interpolation)
 {
-    ccl::AttributeSet& attributes = m_cyclesMesh->attributes;
+    ccl::AttributeSet& attributes = m_stagingMesh->attributes;
 
     if (interpolation == HdInterpolationUniform) {
         ccl::Attribute* attr_fN = attributes.add(ccl::ATTR_STD_FACE_NORMAL);
         ccl::float3* fN         = attr_fN->data_float3();
 
-        int idx = 0;
-        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-            const int vCount = m_faceVertexCounts[i];
-
-            // This needs to be checked
-            for (int j = 1; j < vCount - 1; ++idx) {
-                fN[idx] = vec3f_to_float3(normals[idx]);
-            }
-        }
+        const int* triFaces = m_triangleFaces.cdata();
+        WorkParallelForN(m_stagingMesh->num_triangles(),
+                         [&](size_t begin, size_t end) {
+                             for (size_t t = begin; t < end; ++t) {
+                                 const size_t face = triFaces[t];
+                                 if (face < normals.size())
+                                     fN[t] = vec3f_to_float3(normals[face]);
+                             }
+                         });
 
     } else if (interpolation == HdInterpolationVertex) {
         ccl::Attribute* attr = attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
         ccl::float3* cdata   = attr->data_float3();
 
-        memset(cdata, 0, m_cyclesMesh->verts.size() * sizeof(ccl::float3));
-
-        for (size_t i = 0; i < m_cyclesMesh->verts.size(); i++) {
-            ccl::float3 n = vec3f_to_float3(normals[i]);
-            if (m_orientation == HdTokens->leftHanded)
-                n = -n;
-            cdata[i] = n;
+        const size_t count = std::min(normals.size(),
+                                      m_stagingMesh->verts.size());
+        if (count < m_stagingMesh->verts.size()) {
+            memset(cdata, 0,
+                   m_stagingMesh->verts.size() * sizeof(ccl::float3));
         }
 
+        const bool flip    = m_orientation == HdTokens->leftHanded;
+        const GfVec3f* src = normals.cdata();
+        WorkParallelForN(count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const ccl::float3 n = vec3f_to_float3(src[i]);
+                cdata[i]            = flip ? -n : n;
+            }
+        });
+
     } else if (interpolation == HdInterpolationFaceVarying) {
         //ccl::Attribute* attr = attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
         //ccl::float3* cdata   = attr->data_float3();
 
         // TODO: For now, this method produces very wrong results. Some other solution will be needed
 
-        m_cyclesMesh->add_face_normals();
-        m_cyclesMesh->add_vertex_normals();
+        m_stagingMesh->add_face_normals();
+        m_stagingMesh->add_vertex_normals();
 
         return;
 
-        //memset(cdata, 0, m_cyclesMesh->verts.size() * sizeof(ccl::float3));
+        //memset(cdata, 0, m_stagingMesh->verts.size() * sizeof(ccl::float3));
 
         // Although looping through all faces, normals are averaged per
         // vertex. This seems to be a limitation of cycles. Not allowing
@@ -475,11 +599,11 @@ HdCyclesMesh::_AddNormals(VtVec3fArray& normals, HdInterpolation interpolation)
         /*for (size_t i = 0; i < m_numMeshFaces; i++) {
             for (size_t j = 0; j < 3; j++) {
                 ccl::float3 n = vec3f_to_float3(normals[(i * 3) + j]);
-                cdata[m_cyclesMesh->get_triangle(i).v[j]] += n;
+                cdata[m_stagingMesh->get_triangle(i).v[j]] += n;
             }
         }
 
-        for (size_t i = 0; i < m_cyclesMesh->verts.size(); i++) {
+        for (size_t i = 0; i < m_stagingMesh->verts.size(); i++) {
             cdata[i] = ccl::normalize(cdata[i]);
         }*/
     }
@@ -495,13 +619,49 @@ HdCyclesMesh::_CreateCyclesMesh()
         mesh->use_motion_blur = true;
     }
 
-    m_numMeshVerts = 0;
-    m_numMeshFaces = 0;
-
     mesh->subdivision_type = ccl::Mesh::SUBDIVISION_NONE;
     return mesh;
 }
 
+void
+HdCyclesMesh::_DetachCyclesMesh(HdCyclesRenderParam* a_param,
+                                bool a_copyContent)
+{
+    ccl::Mesh* mesh = _CreateCyclesMesh();
+
+    if (a_copyContent) {
+        mesh->verts             = m_cyclesMesh->verts;
+        mesh->triangles         = m_cyclesMesh->triangles;
+        mesh->shader            = m_cyclesMesh->shader;
+        mesh->smooth            = m_cyclesMesh->smooth;
+        mesh->subd_faces        = m_cyclesMesh->subd_faces;
+        mesh->subd_face_corners = m_cyclesMesh->subd_face_corners;
+        mesh->subd_creases      = m_cyclesMesh->subd_creases;
+        mesh->num_ngons         = m_cyclesMesh->num_ngons;
+        mesh->subdivision_type  = m_cyclesMesh->subdivision_type;
+
+        mesh->attributes.attributes = m_cyclesMesh->attributes.attributes;
+        mesh->subd_attributes.attributes
+            = m_cyclesMesh->subd_attributes.attributes;
+
+        mesh->used_shaders    = m_cyclesMesh->used_shaders;
+        mesh->use_motion_blur = m_cyclesMesh->use_motion_blur;
+        mesh->motion_steps    = m_cyclesMesh->motion_steps;
+        mesh->bounds          = m_cyclesMesh->bounds;
+
+        if (m_cyclesMesh->subd_params) {
+            mesh->subd_params = new ccl::SubdParams(
+                *m_cyclesMesh->subd_params);
+            mesh->subd_params->mesh = mesh;
+        }
+    }
+
+    a_param->RegisterGeometry(mesh);
+    a_param->ReleaseGeometry(m_cyclesMesh);
+
+    m_cyclesMesh = mesh;
+}
+
 ccl::Object*
 HdCyclesMesh::_CreateCyclesObject()
 {
@@ -518,26 +678,30 @@ HdCyclesMesh::_CreateCyclesObject()
 void
 HdCyclesMesh::_PopulateVertices()
 {
-    m_cyclesMesh->verts.reserve(m_numMeshVerts);
+    HD_TRACE_FUNCTION();
+
+    m_stagingMesh->verts.reserve(m_numMeshVerts);
     for (int i = 0; i < m_points.size(); i++) {
-        m_cyclesMesh->verts.push_back_reserved(vec3f_to_float3(m_points[i]));
+        m_stagingMesh->verts.push_back_reserved(vec3f_to_float3(m_points[i]));
     }
 }
 
 void
 HdCyclesMesh::_PopulateMotion()
 {
+    // A single point sample can still be blurred from its velocities
     if (m_pointSamples.count <= 1) {
+        _PopulateVelocityMotion();
         return;
     }
 
     ccl::AttributeSet* attributes = (m_useSubdivision)
-                                        ? &m_cyclesMesh->subd_attributes
-                                        : &m_cyclesMesh->attributes;
+                                        ? &m_stagingMesh->subd_attributes
+                                        : &m_stagingMesh->attributes;
 
-    m_cyclesMesh->use_motion_blur = true;
+    m_stagingMesh->use_motion_blur = true;
 
-    m_cyclesMesh->motion_steps = m_pointSamples.count + 1;
+    m_stagingMesh->motion_steps = m_pointSamples.count + 1;
 
     ccl::Attribute* attr_mP = attributes->find(
         ccl::ATTR_STD_MOTION_VERTEX_POSITION);
@@ -567,69 +731,159 @@ void
 HdCyclesMesh::_PopulateFaces(const std::vector<int>& a_faceMaterials,
                              bool a_subdivide)
 {
-    if (a_subdivide) {
-        m_cyclesMesh->subdivision_type = ccl::Mesh::SUBDIVISION_CATMULL_CLARK;
-        m_cyclesMesh->reserve_subd_faces(m_numMeshFaces, m_numNgons,
-                                         m_numCorners);
-    } else {
-        m_cyclesMesh->reserve_mesh(m_numMeshVerts, m_numMeshFaces);
-    }
-
-    VtIntArray::const_iterator idxIt = m_faceVertexIndices.begin();
+    HD_TRACE_FUNCTION();
 
     m_numTriFaces = 0;
 
-    if (a_subdivide) {
-        bool smooth = true;
-        std::vector<int> vi;
-        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-            const int vCount = m_faceVertexCounts[i];
-            int materialId   = 0;
+    if (!a_subdivide) {
+        // Triangles are written in place from the cached triangulation
+        m_stagingMesh->resize_mesh(m_numMeshVerts,
+                                   m_numMeshVerts ? m_numMeshFaces : 0);
+
+        const size_t numTris = m_stagingMesh->num_triangles();
+        const int* triVerts  = m_triangleVertices.cdata();
+        const int* triFaces  = m_triangleFaces.cdata();
+
+        WorkParallelForN(numTris, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const int* v = triVerts + t * 3;
+                int* tri     = &m_stagingMesh->triangles[t * 3];
+
+                // Out of range triangles are kept degenerate, so that
+                // the primvars gathered per triangle stay aligned
+                const bool valid = static_cast<size_t>(v[0]) < m_numMeshVerts
+                                   && static_cast<size_t>(v[1]) < m_numMeshVerts
+                                   && static_cast<size_t>(v[2])
+                                          < m_numMeshVerts;
+
+                tri[0] = valid ? v[0] : 0;
+                tri[1] = valid ? v[1] : 0;
+                tri[2] = valid ? v[2] : 0;
+
+                const size_t face = static_cast<size_t>(triFaces[t]);
+                m_stagingMesh->shader[t] = face < a_faceMaterials.size()
+                                               ? a_faceMaterials[face]
+                                               : 0;
+                m_stagingMesh->smooth[t] = true;
+            }
+        });
 
-            vi.resize(vCount);
+        m_numTriFaces = static_cast<int>(numTris);
+    } else {
+        m_stagingMesh->subdivision_type = ccl::Mesh::SUBDIVISION_CATMULL_CLARK;
+        m_stagingMesh->reserve_subd_faces(m_numMeshFaces, m_numNgons,
+                                          m_numCorners);
 
-            if (m_orientation == HdTokens->rightHanded) {
-                for (int j = 0; j < vCount; ++j) {
-                    vi[j] = *(idxIt + j);
-                }
-            } else {
-                for (int j = vCount; j > 0; j--) {
-                    vi[j] = *(idxIt + j);
-                }
-            }
+        VtIntArray::const_iterator idxIt = m_faceVertexIndices.cbegin();
 
+        // Left handed indices are already reversed by the triangulation
+        std::vector<int> vi;
+        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
+            const int vCount     = m_faceVertexCounts[i];
+            const int materialId = static_cast<size_t>(i)
+                                           < a_faceMaterials.size()
+                                       ? a_faceMaterials[i]
+                                       : 0;
+
+            vi.assign(idxIt, idxIt + vCount);
             idxIt += vCount;
 
-            m_cyclesMesh->add_subd_face(&vi[0], vCount, materialId, true);
+            m_stagingMesh->add_subd_face(vi.data(), vCount, materialId, true);
         }
-    } else {
-        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-            const int vCount = m_faceVertexCounts[i];
-            int materialId   = 0;
+    }
+}
+
+void
+HdCyclesMesh::_ComputeTriangulation()
+{
+    HD_TRACE_FUNCTION();
+
+    const size_t numFaces = m_faceVertexCounts.size();
+
+    std::vector<int> firstCorners(numFaces + 1, 0);
+    std::vector<int> firstTris(numFaces + 1, 0);
+    for (size_t i = 0; i < numFaces; ++i) {
+        const int vCount    = m_faceVertexCounts[i];
+        firstCorners[i + 1] = firstCorners[i] + std::max(vCount, 0);
+        firstTris[i + 1]    = firstTris[i] + std::max(vCount - 2, 0);
+    }
 
-            if (i < a_faceMaterials.size()) {
-                materialId = a_faceMaterials[i];
+    const size_t numIndices = m_faceVertexIndices.size();
+    const bool validCounts  = static_cast<size_t>(firstCorners.back())
+                             <= numIndices;
+    if (!validCounts) {
+        TF_WARN("Mesh %s has fewer face vertex indices than counted",
+                GetId().GetText());
+        std::fill(firstTris.begin(), firstTris.end(), 0);
+    }
+
+    m_numMeshFaces = firstTris.back();
+    m_triangleVertices.resize(m_numMeshFaces * 3);
+    m_triangleCorners.resize(m_numMeshFaces * 3);
+    m_triangleFaces.resize(m_numMeshFaces);
+
+    const bool leftHanded = m_orientation == HdTokens->leftHanded;
+
+    // Left handed faces keep their first vertex and reverse the others. Each
+    // face is reversed right before it is triangulated, by the same task.
+    // TODO: We still dont handle leftHanded primvars properly.
+    VtIntArray reversed;
+    const int* authored = m_faceVertexIndices.cdata();
+    int* flipped        = nullptr;
+    if (leftHanded && validCounts) {
+        reversed.resize(numIndices);
+        flipped = reversed.data();
+        std::copy(authored + firstCorners.back(), authored + numIndices,
+                  flipped + firstCorners.back());
+    }
+
+    const int* indices    = flipped ? flipped : authored;
+    int* triVerts         = m_triangleVertices.data();
+    int* triCorners       = m_triangleCorners.data();
+    int* triFaces         = m_triangleFaces.data();
+
+    WorkParallelForN(numFaces, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int vCount = firstCorners[i + 1] - firstCorners[i];
+            const int c      = firstCorners[i];
+
+            if (flipped && vCount > 0) {
+                flipped[c] = authored[c];
+                for (int j = 1; j < vCount; ++j)
+                    flipped[c + j] = authored[c + vCount - j];
             }
 
             for (int j = 1; j < vCount - 1; ++j) {
-                int v0 = *idxIt;
-                int v1 = *(idxIt + j + 0);
-                int v2 = *(idxIt + j + 1);
-                if (v0 < m_numMeshVerts && v1 < m_numMeshVerts
-                    && v2 < m_numMeshVerts) {
-                    if (m_orientation == HdTokens->rightHanded) {
-                        m_cyclesMesh->add_triangle(v0, v1, v2, materialId,
-                                                   true);
-                    } else {
-                        m_cyclesMesh->add_triangle(v0, v2, v1, materialId,
-                                                   true);
-                    }
-                    m_numTriFaces++;
+                const int t = firstTris[i] + j - 1;
+                if (t >= firstTris[i + 1])
+                    break;
+
+                int* v       = triVerts + t * 3;
+                int* corners = triCorners + t * 3;
+
+                // Indices of left handed faces are already reversed, the
+                // primvars are not
+                corners[0] = c;
+                v[0]       = indices[c];
+                if (leftHanded) {
+                    corners[1] = c + (vCount - 1 - j);
+                    corners[2] = c + (vCount - j);
+                    v[1]       = indices[c + j + 1];
+                    v[2]       = indices[c + j];
+                } else {
+                    corners[1] = c + j;
+                    corners[2] = c + j + 1;
+                    v[1]       = indices[c + j];
+                    v[2]       = indices[c + j + 1];
                 }
+
+                triFaces[t] = static_cast<int>(i);
             }
-            idxIt += vCount;
         }
-    }
+    });
+
+    if (flipped)
+        m_faceVertexIndices.swap(reversed);
 }
 
 void
@@ -637,9 +891,9 @@ HdCyclesMesh::_PopulateCreases()
 {
     size_t num_creases = m_creaseLengths.size();
 
-    m_cyclesMesh->subd_creases.resize(num_creases);
+    m_stagingMesh->subd_creases.resize(num_creases);
 
-    ccl::Mesh::SubdEdgeCrease* crease = m_cyclesMesh->subd_creases.data();
+    ccl::Mesh::SubdEdgeCrease* crease = m_stagingMesh->subd_creases.data();
     for (int i = 0; i < num_creases; i++) {
         crease->v[0]   = m_creaseIndices[(i * 2) + 0];
         crease->v[1]   = m_creaseIndices[(i * 2) + 1];
@@ -652,18 +906,18 @@ HdCyclesMesh::_PopulateCreases()
 void
 HdCyclesMesh::_PopulateGenerated(ccl::Scene* scene)
 {
-    if (m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_GENERATED)) {
+    if (m_stagingMesh->need_attribute(scene, ccl::ATTR_STD_GENERATED)) {
         ccl::float3 loc, size;
-        HdCyclesMeshTextureSpace(m_cyclesMesh, loc, size);
+        HdCyclesMeshTextureSpace(m_stagingMesh, loc, size);
 
         ccl::AttributeSet* attributes = (m_useSubdivision)
-                                            ? &m_cyclesMesh->subd_attributes
-                                            : &m_cyclesMesh->attributes;
+                                            ? &m_stagingMesh->subd_attributes
+                                            : &m_stagingMesh->attributes;
         ccl::Attribute* attr = attributes->add(ccl::ATTR_STD_GENERATED);
 
         ccl::float3* generated = attr->data_float3();
-        for (int i = 0; i < m_cyclesMesh->verts.size(); i++) {
-            generated[i] = m_cyclesMesh->verts[i] * size - loc;
+        for (int i = 0; i < m_stagingMesh->verts.size(); i++) {
+            generated[i] = m_stagingMesh->verts[i] * size - loc;
         }
     }
 }
@@ -671,27 +925,100 @@ HdCyclesMesh::_PopulateGenerated(ccl::Scene* scene)
 void
 HdCyclesMesh::_FinishMesh(ccl::Scene* scene)
 {
+    HD_TRACE_FUNCTION();
+
     // Deprecated in favour of adding when uv's are added
     // This should no longer be necessary
     //_ComputeTangents(true);
 
     // This must be done first, because HdCyclesMeshTextureSpace requires computed min/max
-    m_cyclesMesh->compute_bounds();
+    m_stagingMesh->compute_bounds();
 
     _PopulateGenerated(scene);
 }
 
+void
+HdCyclesMesh::_CommitMesh()
+{
+    m_cyclesMesh->clear();
+
+    m_cyclesMesh->verts.steal_data(m_stagingMesh->verts);
+    m_cyclesMesh->triangles.steal_data(m_stagingMesh->triangles);
+    m_cyclesMesh->shader.steal_data(m_stagingMesh->shader);
+    m_cyclesMesh->smooth.steal_data(m_stagingMesh->smooth);
+
+    m_cyclesMesh->subd_faces.steal_data(m_stagingMesh->subd_faces);
+    m_cyclesMesh->subd_face_corners.steal_data(
+        m_stagingMesh->subd_face_corners);
+    m_cyclesMesh->subd_creases.steal_data(m_stagingMesh->subd_creases);
+    m_cyclesMesh->num_ngons        = m_stagingMesh->num_ngons;
+    m_cyclesMesh->subdivision_type = m_stagingMesh->subdivision_type;
+
+    // Attributes were sized against the staging mesh, which now matches
+    m_cyclesMesh->attributes.attributes.swap(
+        m_stagingMesh->attributes.attributes);
+    m_cyclesMesh->subd_attributes.attributes.swap(
+        m_stagingMesh->subd_attributes.attributes);
+
+    m_cyclesMesh->used_shaders    = m_stagingMesh->used_shaders;
+    m_cyclesMesh->use_motion_blur = m_stagingMesh->use_motion_blur;
+    m_cyclesMesh->motion_steps    = m_stagingMesh->motion_steps;
+    m_cyclesMesh->bounds          = m_stagingMesh->bounds;
+
+    // Leave the staging mesh empty for the next rebuild
+    m_stagingMesh->clear();
+}
+
+void
+HdCyclesMesh::_CommitPoints()
+{
+    m_cyclesMesh->verts.steal_data(m_stagingMesh->verts);
+
+    // Derived from the old positions, Cycles recomputes them when missing
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_FACE_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_VERTEX_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_VERTEX_NORMAL);
+
+    // Replace the live attributes with the rebuilt ones, everything else
+    // (uvs, colors, face data) stays as is
+    std::list<ccl::Attribute>& staged = m_stagingMesh->attributes.attributes;
+    std::list<ccl::Attribute>& live   = m_cyclesMesh->attributes.attributes;
+
+    while (!staged.empty()) {
+        const ccl::Attribute& attr = staged.front();
+        if (attr.std != ccl::ATTR_STD_NONE) {
+            m_cyclesMesh->attributes.remove(attr.std);
+        } else {
+            m_cyclesMesh->attributes.remove(attr.name);
+        }
+        live.splice(live.end(), staged, staged.begin());
+    }
+
+    m_cyclesMesh->use_motion_blur = m_stagingMesh->use_motion_blur;
+    m_cyclesMesh->motion_steps    = m_stagingMesh->motion_steps;
+    m_cyclesMesh->bounds          = m_stagingMesh->bounds;
+
+    m_stagingMesh->clear();
+}
+
 void
 HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                    HdDirtyBits* dirtyBits, TfToken const& reprToken)
 {
+    HD_TRACE_FUNCTION();
+
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
     ccl::Scene* scene          = param->GetCyclesScene();
 
-    scene->mutex.lock();
+    HdCyclesSyncTimer syncTimer(param, HdPrimTypeTokens->mesh);
 
     const SdfPath& id = GetId();
 
+    // Everything up until the commit below only touches this prim's own
+    // state and m_stagingMesh, so Hydra can sync meshes in parallel. The
+    // scene lock is only taken while moving the results into Cycles.
+
     // -------------------------------------
     // -- Pull scene data
 
@@ -747,8 +1074,34 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         }
     }
 
+    // Velocities and accelerations blur from the one point sample above,
+    // which also covers caches whose topology changes every frame
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id,
+                                        HdTokens->velocities)) {
+        VtVec3fArray velocities;
+        VtVec3fArray accelerations;
+
+        VtValue value = sceneDelegate->Get(id, HdTokens->velocities);
+        if (value.IsHolding<VtVec3fArray>())
+            velocities = value.UncheckedGet<VtVec3fArray>();
+
+        value = sceneDelegate->Get(id, _tokens->accelerations);
+        if (value.IsHolding<VtVec3fArray>())
+            accelerations = value.UncheckedGet<VtVec3fArray>();
+
+        if (velocities != m_velocities || accelerations != m_accelerations) {
+            m_velocities    = velocities;
+            m_accelerations = accelerations;
+            newMesh         = newMesh || !m_points.empty();
+        }
+    }
+
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
 
+    // Anything that changes the faces and needs a full rebuild, as opposed
+    // to points only which can be updated in place
+    bool topologyChanged = false;
+
     if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
         m_topology          = GetMeshTopology(sceneDelegate);
         m_faceVertexCounts  = m_topology.GetFaceVertexCounts();
@@ -756,34 +1109,21 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         m_geomSubsets       = m_topology.GetGeomSubsets();
         m_orientation       = m_topology.GetOrientation();
 
-        // TODO: We still dont handle leftHanded primvars properly.
-        // However this helps faces be aligned the correct way...
-        if (m_orientation == HdTokens->leftHanded) {
-            VtIntArray newIndices;
-            newIndices.resize(m_faceVertexIndices.size());
-            int tot = 0;
-            for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-                int count = m_faceVertexCounts[i];
-
-                for (int j = 0; j < count; j++) {
-                    int idx  = tot + j;
-                    int ridx = tot + (count - j);
-
-                    if (j == 0)
-                        newIndices[idx] = m_faceVertexIndices[idx];
-                    else
-                        newIndices[idx] = m_faceVertexIndices[ridx];
-                }
-
-                tot += count;
-            }
-            m_faceVertexIndices = newIndices;
+        // Hashed as authored, the triangulation reverses left handed faces
+        if (param->GetGeometryCache()) {
+            uint64_t hash = HdCyclesGeometryCache::Hash(
+                m_faceVertexCounts.cdata(),
+                m_faceVertexCounts.size() * sizeof(int),
+                HdCyclesGeometryCache::GetConversionSeed());
+            hash = HdCyclesGeometryCache::Hash(
+                m_faceVertexIndices.cdata(),
+                m_faceVertexIndices.size() * sizeof(int), hash);
+            m_topologyHash = HdCyclesGeometryCache::Hash(
+                m_orientation.GetText(), m_orientation.size(), hash);
         }
 
-        m_numMeshFaces = 0;
-        for (int i = 0; i < m_faceVertexCounts.size(); i++) {
-            m_numMeshFaces += m_faceVertexCounts[i] - 2;
-        }
+        m_triangulationValid = false;
+        m_tangentCache.clear();
 
         m_numNgons   = 0;
         m_numCorners = 0;
@@ -801,7 +1141,8 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                                == PxOsdOpenSubdivTokens->catmullClark;
         }
 
-        newMesh = true;
+        newMesh         = true;
+        topologyChanged = true;
     }
 
     std::map<HdInterpolation, HdPrimvarDescriptorVector>
@@ -826,16 +1167,13 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     // -------------------------------------
     // -- Resolve Drawstyles
 
-    bool isRefineLevelDirty = false;
+    // Dicing is driven by the dicing rate and camera, not the refine level,
+    // so a refine level change keeps the diced mesh
     if (*dirtyBits & HdChangeTracker::DirtyDisplayStyle) {
         mesh_updated = true;
 
         m_displayStyle = sceneDelegate->GetDisplayStyle(id);
-        if (m_refineLevel != m_displayStyle.refineLevel) {
-            isRefineLevelDirty = true;
-            m_refineLevel      = m_displayStyle.refineLevel;
-            newMesh            = true;
-        }
+        m_refineLevel  = m_displayStyle.refineLevel;
     }
 
     if (HdChangeTracker::IsSubdivTagsDirty(*dirtyBits, id)) {
@@ -847,7 +1185,8 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         m_creaseLengths = subdivTags.GetCreaseLengths();
         m_creaseWeights = subdivTags.GetCreaseWeights();
 
-        newMesh = true;
+        newMesh         = true;
+        topologyChanged = true;
     }
 
 #ifdef USE_USD_CYCLES_SCHEMA
@@ -864,7 +1203,7 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                 usdCyclesTokens->primvarsCyclesObjectMblurDeform,
                 m_useDeformMotionBlur);
 
-            m_motionSteps = _HdCyclesGetMeshParam<bool>(
+            m_motionSteps = _HdCyclesGetMeshParam<int>(
                 pv, dirtyBits, id, this, sceneDelegate,
                 usdCyclesTokens->primvarsCyclesObjectMblurSteps, m_motionSteps);
 
@@ -876,12 +1215,12 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                 subdivisionType);
 
             if (subdivisionType == usdCyclesTokens->catmull_clark) {
-                m_cyclesMesh->subdivision_type
+                m_stagingMesh->subdivision_type
                     = ccl::Mesh::SUBDIVISION_CATMULL_CLARK;
             } else if (subdivisionType == usdCyclesTokens->linear) {
-                m_cyclesMesh->subdivision_type = ccl::Mesh::SUBDIVISION_LINEAR;
+                m_stagingMesh->subdivision_type = ccl::Mesh::SUBDIVISION_LINEAR;
             } else {
-                m_cyclesMesh->subdivision_type = ccl::Mesh::SUBDIVISION_NONE;
+                m_stagingMesh->subdivision_type = ccl::Mesh::SUBDIVISION_NONE;
             }
 
             m_dicingRate = _HdCyclesGetMeshParam<float>(
@@ -895,20 +1234,19 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
             // Object Generic
 
-            m_cyclesObject->is_shadow_catcher = _HdCyclesGetMeshParam<bool>(
+            m_isShadowCatcher = _HdCyclesGetMeshParam<bool>(
                 pv, dirtyBits, id, this, sceneDelegate,
                 usdCyclesTokens->primvarsCyclesObjectIs_shadow_catcher,
-                m_cyclesObject->is_shadow_catcher);
+                m_isShadowCatcher);
 
-            m_cyclesObject->pass_id = _HdCyclesGetMeshParam<bool>(
+            m_passId = _HdCyclesGetMeshParam<bool>(
                 pv, dirtyBits, id, this, sceneDelegate,
-                usdCyclesTokens->primvarsCyclesObjectPass_id,
-                m_cyclesObject->pass_id);
+                usdCyclesTokens->primvarsCyclesObjectPass_id, m_passId);
 
-            m_cyclesObject->use_holdout = _HdCyclesGetMeshParam<bool>(
+            m_useHoldout = _HdCyclesGetMeshParam<bool>(
                 pv, dirtyBits, id, this, sceneDelegate,
                 usdCyclesTokens->primvarsCyclesObjectUse_holdout,
-                m_cyclesObject->use_holdout);
+                m_useHoldout);
 
             // Visibility
 
@@ -960,17 +1298,100 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     // -------------------------------------
     // -- Create Cycles Mesh
 
-    HdMeshUtil meshUtil(&m_topology, id);
-    if (newMesh) {
-        m_cyclesMesh->clear();
+    // Shaders referenced by this prim that need tagging once locked
+    std::vector<ccl::Shader*> shadersToTag;
+
+    // Geometry cache entry of a rebuild, zero when not cached
+    const HdCyclesGeometryCache* geometryCache = param->GetGeometryCache();
+    uint64_t cacheKey                          = 0;
+    bool cacheHit                              = false;
+
+    // Deforming meshes usually only change points. When the topology and
+    // vertex count are unchanged and no other primvar besides vertex normals
+    // is dirty, only the vertex data is rebuilt and the rest of the live
+    // mesh is kept, which also lets Cycles refit instead of rebuild the BVH.
+    bool pointsOnly = newMesh && !topologyChanged && !m_useSubdivision
+                      && m_points.size() == m_cyclesMesh->verts.size();
+
+    VtVec3fArray vertexNormals;
+    if (pointsOnly) {
+        for (auto& primvarDescsEntry : primvarDescsPerInterpolation) {
+            for (auto& pv : primvarDescsEntry.second) {
+                if (pv.name == HdTokens->points
+                    || pv.name == HdTokens->velocities
+                    || pv.name == _tokens->accelerations
+                    || !HdChangeTracker::IsPrimvarDirty(*dirtyBits, id,
+                                                        pv.name)) {
+                    continue;
+                }
+
+                const bool isNormals = pv.name == HdTokens->normals
+                                       || pv.role
+                                              == HdPrimvarRoleTokens->normal;
+                if (isNormals
+                    && primvarDescsEntry.first == HdInterpolationVertex) {
+                    VtValue value = GetPrimvar(sceneDelegate, pv.name);
+                    if (value.IsHolding<VtVec3fArray>()) {
+                        vertexNormals = value.UncheckedGet<VtVec3fArray>();
+                        continue;
+                    }
+                }
+
+                pointsOnly = false;
+            }
+        }
+    }
+
+    if (pointsOnly) {
+        m_stagingMesh->clear();
 
         _PopulateVertices();
 
         if (m_useMotionBlur && m_useDeformMotionBlur)
             _PopulateMotion();
 
-        std::vector<int> faceMaterials;
-        faceMaterials.resize(m_numMeshFaces);
+        if (vertexNormals.size() == m_points.size()) {
+            _AddNormals(vertexNormals, HdInterpolationVertex);
+        }
+
+        // Needed to decide about generated coordinates in _FinishMesh
+        m_stagingMesh->used_shaders = m_usedShaders;
+
+        mesh_updated = true;
+    } else if (newMesh) {
+        m_stagingMesh->clear();
+        m_uvSets.clear();
+
+        const bool subdivide = m_useSubdivision && m_subdivEnabled;
+
+        std::vector<_DirtyPrimvar> dirtyPrimvars;
+        for (auto& primvarDescsEntry : primvarDescsPerInterpolation) {
+            for (auto& pv : primvarDescsEntry.second) {
+                // Velocities are consumed by _PopulateMotion
+                if (pv.name == HdTokens->velocities
+                    || pv.name == _tokens->accelerations
+                    || !HdChangeTracker::IsPrimvarDirty(*dirtyBits, id,
+                                                        pv.name)) {
+                    continue;
+                }
+
+                _DirtyPrimvar primvar;
+                primvar.desc          = pv;
+                primvar.interpolation = primvarDescsEntry.first;
+                primvar.value         = GetPrimvar(sceneDelegate, pv.name);
+                dirtyPrimvars.push_back(std::move(primvar));
+
+                // This swaps the default_surface to one that uses
+                // displayColor for diffuse
+                if (pv.name == HdTokens->displayColor) {
+                    m_hasVertexColors = true;
+                }
+            }
+        }
+
+        // Material index of each subset, assigned to its faces below
+        std::vector<int> subsetMaterials;
+        subsetMaterials.reserve(m_geomSubsets.size());
 
         for (auto const& subset : m_geomSubsets) {
             int subsetMaterialIndex = 0;
@@ -984,7 +1405,7 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                     if (m_materialMap.find(subset.materialId)
                         == m_materialMap.end()) {
                         m_usedShaders.push_back(subMat->GetCyclesShader());
-                        subMat->GetCyclesShader()->tag_update(scene);
+                        shadersToTag.push_back(subMat->GetCyclesShader());
 
                         m_materialMap.insert(
                             std::pair<SdfPath, int>(subset.materialId,
@@ -994,145 +1415,153 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                         subsetMaterialIndex = m_materialMap.at(
                             subset.materialId);
                     }
-                    m_cyclesMesh->used_shaders = m_usedShaders;
+                    m_stagingMesh->used_shaders = m_usedShaders;
                 }
             }
 
-            for (int i : subset.indices) {
-                faceMaterials[i] = std::max(subsetMaterialIndex - 1, 0);
-            }
+            subsetMaterials.push_back(std::max(subsetMaterialIndex - 1, 0));
         }
 
-        _PopulateFaces(faceMaterials, (m_useSubdivision && m_subdivEnabled));
-
-        if (m_useSubdivision && m_subdivEnabled) {
-            _PopulateCreases();
-
-            if (!m_cyclesMesh->subd_params) {
-                m_cyclesMesh->subd_params = new ccl::SubdParams(m_cyclesMesh);
+        // Static meshes are looked up by their inputs. Deforming ones change
+        // every frame and subdivision is diced by Cycles, neither is cached.
+        if (geometryCache && !subdivide
+            && !(m_useMotionBlur && m_useDeformMotionBlur)) {
+            const std::string& path = id.GetString();
+            cacheKey = HdCyclesGeometryCache::Hash(path.data(), path.size(),
+                                                   m_topologyHash);
+            cacheKey = HdCyclesGeometryCache::Hash(m_points.cdata(),
+                                                   m_points.size()
+                                                       * sizeof(GfVec3f),
+                                                   cacheKey);
+
+            for (size_t i = 0; i < m_geomSubsets.size(); ++i) {
+                const VtIntArray& faces = m_geomSubsets[i].indices;
+                cacheKey = HdCyclesGeometryCache::Hash(faces.cdata(),
+                                                       faces.size()
+                                                           * sizeof(int),
+                                                       cacheKey);
+                cacheKey = HdCyclesGeometryCache::Hash(&subsetMaterials[i],
+                                                       sizeof(int), cacheKey);
             }
 
-            ccl::SubdParams& subd_params = *m_cyclesMesh->subd_params;
+            for (const _DirtyPrimvar& primvar : dirtyPrimvars) {
+                const std::string key = TfStringPrintf(
+                    "%s %s %d", primvar.desc.name.GetText(),
+                    primvar.desc.role.GetText(), int(primvar.interpolation));
+                cacheKey = HdCyclesGeometryCache::Hash(key.data(), key.size(),
+                                                       cacheKey);
+                cacheKey = HdCyclesGeometryCache::Hash(primvar.value,
+                                                       cacheKey);
+            }
 
-            subd_params.dicing_rate = m_dicingRate;
-            subd_params.max_level   = m_maxSubdivision;
+            // An all zero key can't be told from no key
+            cacheKey = std::max<uint64_t>(cacheKey, 1);
+
+            ccl::float3 displayColor = m_displayColor;
+            cacheHit = geometryCache->Load(cacheKey, id, m_stagingMesh,
+                                           &displayColor);
+            if (cacheHit) {
+                m_displayColor = displayColor;
+                m_numTriFaces  = static_cast<int>(
+                    m_stagingMesh->num_triangles());
+                m_tangentCache.clear();
+
+                // Tangents are regenerated from these when points move
+                for (const _DirtyPrimvar& primvar : dirtyPrimvars) {
+                    if (primvar.desc.role
+                        == HdPrimvarRoleTokens->textureCoordinate) {
+                        m_uvSets.emplace_back(primvar.desc.name,
+                                              primvar.value);
+                    }
+                }
 
-            // This allows us to dice based on USD refine level (low, medium, high, etc)
-            // However it is unclear if we want to support this, or if we want it off by default
-            // Disabled for now...
-            if (false) {
-                // Note: This math is abitrary and possible wrong
-                subd_params.dicing_rate = subd_params.dicing_rate
-                                          / ((m_refineLevel + 1) * 2.0f);
+                mesh_updated = true;
             }
-
-            subd_params.objecttoworld = ccl::transform_identity();
         }
 
-        // Ingest mesh primvars (data, not schema)
-        for (auto& primvarDescsEntry : primvarDescsPerInterpolation) {
-            for (auto& pv : primvarDescsEntry.second) {
-                if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, pv.name)) {
-                    auto value = GetPrimvar(sceneDelegate, pv.name);
-                    VtValue triangulated;
-
-                    // - Normals
-
-                    if (pv.name == HdTokens->normals
-                        || pv.role == HdPrimvarRoleTokens->normal) {
-                        VtVec3fArray normals;
-                        normals = value.UncheckedGet<VtArray<GfVec3f>>();
-
-                        if (primvarDescsEntry.first
-                            == HdInterpolationFaceVarying) {
-                            // Triangulate primvar normals
-                            meshUtil.ComputeTriangulatedFaceVaryingPrimvar(
-                                normals.data(), normals.size(), HdTypeFloatVec3,
-                                &triangulated);
-                            normals = triangulated.Get<VtVec3fArray>();
-                        }
+        if (!cacheHit) {
+            // Also reverses the indices of left handed meshes
+            if (!m_triangulationValid) {
+                _ComputeTriangulation();
+                m_triangulationValid = true;
+            }
 
-                        _AddNormals(normals, primvarDescsEntry.first);
-                        mesh_updated = true;
-                    }
+            _PopulateVertices();
 
-                    // - Velocities
+            if (m_useMotionBlur && m_useDeformMotionBlur)
+                _PopulateMotion();
 
-                    // TODO: Properly implement
-                    else if (pv.name == HdTokens->velocities) {
-                        if (value.IsHolding<VtArray<GfVec3f>>()) {
-                            VtVec3fArray vels;
-                            vels = value.UncheckedGet<VtArray<GfVec3f>>();
+            std::vector<int> faceMaterials;
+            faceMaterials.resize(m_numMeshFaces);
 
-                            /*meshUtil.ComputeTriangulatedFaceVaryingPrimvar(
-                            vels.data(), vels.size(), HdTypeFloatVec3,
-                            &triangulatedVal);
-                        VtVec3fArray m_vels_tri
-                            = triangulatedVal.Get<VtVec3fArray>();
-                        _AddVelocities(m_vels_tri, primvarDescsEntry.first);*/
+            for (size_t s = 0; s < m_geomSubsets.size(); ++s) {
+                const int material  = subsetMaterials[s];
+                const VtIntArray& f = m_geomSubsets[s].indices;
+                const int* faces    = f.cdata();
+                const size_t limit  = faceMaterials.size();
+                WorkParallelForN(f.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        const size_t face = faces[i];
+                        if (face < limit)
+                            faceMaterials[face] = material;
+                    }
+                });
+            }
 
+            _PopulateFaces(faceMaterials, subdivide);
 
-                            if (primvarDescsEntry.first
-                                == HdInterpolationFaceVarying) {
-                                meshUtil.ComputeTriangulatedFaceVaryingPrimvar(
-                                    vels.data(), vels.size(), HdTypeFloatVec3,
-                                    &triangulated);
+            if (subdivide) {
+                _PopulateCreases();
+            }
 
-                                VtVec3fArray triangulatedVels
-                                    = triangulated.Get<VtVec3fArray>();
+            // Ingest mesh primvars (data, not schema)
+            for (const _DirtyPrimvar& primvar : dirtyPrimvars) {
+                const HdPrimvarDescriptor& pv = primvar.desc;
+                const VtValue& value          = primvar.value;
 
-                                //_AddVelocities(triangulatedVels,
-                                //               primvarDescsEntry.first);
-                            } else {
-                                //_AddVelocities(vels, primvarDescsEntry.first);
-                            }
-                        }
-                        mesh_updated = true;
-                    }
+                // - Normals
 
-                    // - Texture Coordinates
+                if (pv.name == HdTokens->normals
+                    || pv.role == HdPrimvarRoleTokens->normal) {
+                    const VtVec3fArray& normals
+                        = value.UncheckedGet<VtArray<GfVec3f>>();
 
-                    else if (pv.role
-                             == HdPrimvarRoleTokens->textureCoordinate) {
-                        _AddUVSet(pv.name, value, scene,
-                                  primvarDescsEntry.first);
+                    // Tangents are derived from the normals
+                    m_tangentCache.clear();
 
-                        mesh_updated = true;
-                    }
+                    _AddNormals(normals, primvar.interpolation);
+                }
 
-                    // - Colors + other data
+                // - Texture Coordinates
 
-                    else {
-                        _AddColors(pv.name, pv.role, value, scene,
-                                   primvarDescsEntry.first);
+                else if (pv.role == HdPrimvarRoleTokens->textureCoordinate) {
+                    _AddUVSet(pv.name, value, scene, primvar.interpolation);
+                }
 
-                        // This swaps the default_surface to one that uses
-                        // displayColor for diffuse
-                        if (pv.name == HdTokens->displayColor) {
-                            m_hasVertexColors = true;
-                        }
-                        mesh_updated = true;
-                    }
+                // - Colors + other data
+
+                else {
+                    _AddColors(pv.name, pv.role, value, scene,
+                               primvar.interpolation);
                 }
+
+                mesh_updated = true;
             }
         }
 
         // Apply existing shaders
         if (m_usedShaders.size() > 0)
-            m_cyclesMesh->used_shaders = m_usedShaders;
+            m_stagingMesh->used_shaders = m_usedShaders;
     }
 
+    bool transformDirty = false;
     if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        // This causes a known slowdown to deforming motion blur renders
-        // This will be addressed in an upcoming PR
-        m_transformSamples = HdCyclesSetTransform(m_cyclesObject, sceneDelegate,
-                                                  id, m_useMotionBlur);
-
-        if (m_cyclesMesh && m_cyclesMesh->subd_params) {
-            m_cyclesMesh->subd_params->objecttoworld = m_cyclesObject->tfm;
-        }
-
-        mesh_updated = true;
+        // Only sampled here and applied to the object under the scene lock,
+        // unchanged samples skip the object update entirely
+        transformDirty = HdCyclesSampleTransform(sceneDelegate, id,
+                                                 &m_transformSamples);
+        if (transformDirty)
+            mesh_updated = true;
     }
 
     ccl::Shader* fallbackShader = scene->default_surface;
@@ -1143,9 +1572,10 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
     if (*dirtyBits & HdChangeTracker::DirtyPrimID) {
         // Offset of 1 added because Cycles primId pass needs to be shifted down to -1
-        m_cyclesObject->pass_id = this->GetPrimId() + 1;
+        m_passId = this->GetPrimId() + 1;
     }
 
+    bool shadersDirty = false;
     if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
         // We probably need to clear this array, however putting this here,
         // breaks some IPR sessions
@@ -1154,6 +1584,7 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         if (m_cyclesMesh) {
             m_cachedMaterialId = sceneDelegate->GetMaterialId(id);
             if (m_faceVertexCounts.size() > 0) {
+                ccl::Shader* materialShader = fallbackShader;
                 if (!m_cachedMaterialId.IsEmpty()) {
                     const HdCyclesMaterial* material
                         = static_cast<const HdCyclesMaterial*>(
@@ -1161,17 +1592,38 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                                 HdPrimTypeTokens->material, m_cachedMaterialId));
 
                     if (material && material->GetCyclesShader()) {
-                        m_usedShaders.push_back(material->GetCyclesShader());
+                        materialShader = material->GetCyclesShader();
 
-                        material->GetCyclesShader()->tag_update(scene);
-                    } else {
-                        m_usedShaders.push_back(fallbackShader);
+                        shadersToTag.push_back(materialShader);
                     }
+                }
+
+                // Materials can hand out a different shared shader after
+                // an edit, rebind the slot the previous one was in
+                auto slot = std::find(m_usedShaders.begin(),
+                                      m_usedShaders.end(), m_materialShader);
+                if (m_materialShader && slot != m_usedShaders.end()) {
+                    *slot = materialShader;
                 } else {
-                    m_usedShaders.push_back(fallbackShader);
+                    m_usedShaders.push_back(materialShader);
+                }
+                m_materialShader = materialShader;
+
+                // Subset materials keep their slots
+                for (auto const& subset : m_materialMap) {
+                    const HdCyclesMaterial* subMat
+                        = static_cast<const HdCyclesMaterial*>(
+                            sceneDelegate->GetRenderIndex().GetSprim(
+                                HdPrimTypeTokens->material, subset.first));
+                    if (subMat && subMat->GetCyclesShader()
+                        && subset.second > 0
+                        && subset.second <= m_usedShaders.size()) {
+                        m_usedShaders[subset.second - 1]
+                            = subMat->GetCyclesShader();
+                    }
                 }
 
-                m_cyclesMesh->used_shaders = m_usedShaders;
+                shadersDirty = true;
             }
         }
     }
@@ -1184,6 +1636,11 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     // -------------------------------------
     // -- Handle point instances
 
+    // New instance objects are created here, but only swapped into the
+    // scene during the commit
+    bool instancesDirty = false;
+    std::vector<ccl::Object*> newInstances;
+
     if (newMesh || (*dirtyBits & HdChangeTracker::DirtyInstancer)) {
         mesh_updated = true;
         if (auto instancer = static_cast<HdCyclesInstancer*>(
@@ -1193,69 +1650,42 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
             auto newNumInstances    = (instanceTransforms.count > 0)
                                        ? instanceTransforms.values[0].size()
                                        : 0;
-            // Clear all instances...
-            if (m_cyclesInstances.size() > 0) {
-                for (auto instance : m_cyclesInstances) {
-                    if (instance) {
-                        m_renderDelegate->GetCyclesRenderParam()->RemoveObject(
-                            instance);
-                        delete instance;
-                    }
-                }
-                m_cyclesInstances.clear();
-            }
+            instancesDirty = true;
 
             if (newNumInstances != 0) {
-                std::vector<TfSmallVector<GfMatrix4d, 1>> combinedTransforms;
-                combinedTransforms.reserve(newNumInstances);
-                for (size_t i = 0; i < newNumInstances; ++i) {
-                    // Apply prototype transform (m_transformSamples) to all the instances
-                    combinedTransforms.emplace_back(instanceTransforms.count);
-                    auto& instanceTransform = combinedTransforms.back();
-
-                    if (m_transformSamples.count == 0
-                        || (m_transformSamples.count == 1
-                            && (m_transformSamples.values[0]
-                                == GfMatrix4d(1)))) {
-                        for (size_t j = 0; j < instanceTransforms.count; ++j) {
-                            instanceTransform[j]
-                                = instanceTransforms.values[j][i];
+                const bool identityPrototypeTransform
+                    = m_transformSamples.count == 0
+                      || (m_transformSamples.count == 1
+                          && (m_transformSamples.values[0] == GfMatrix4d(1)));
+
+                // TODO: Implement motion blur for point instanced objects,
+                // only the first sample is used for now. The prototype
+                // transform is resampled once rather than per instance.
+                const GfMatrix4d prototypeTransform
+                    = identityPrototypeTransform
+                          ? GfMatrix4d(1)
+                          : m_transformSamples.Resample(
+                              instanceTransforms.times[0]);
+
+                newInstances.resize(newNumInstances);
+                WorkParallelForN(newNumInstances, [&](size_t begin,
+                                                      size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        GfMatrix4d instanceTransform
+                            = instanceTransforms.values[0][i];
+                        if (!identityPrototypeTransform) {
+                            instanceTransform = prototypeTransform
+                                                * instanceTransform;
                         }
-                    } else {
-                        for (size_t j = 0; j < instanceTransforms.count; ++j) {
-                            GfMatrix4d xf_j = m_transformSamples.Resample(
-                                instanceTransforms.times[j]);
-                            instanceTransform[j]
-                                = xf_j * instanceTransforms.values[j][i];
-                        }
-                    }
-                }
-
-                for (int j = 0; j < newNumInstances; ++j) {
-                    ccl::Object* instanceObj = _CreateCyclesObject();
 
-                    instanceObj->tfm = mat4d_to_transform(
-                        combinedTransforms[j].data()[0]);
-                    instanceObj->geometry = m_cyclesMesh;
+                        ccl::Object* instanceObj = _CreateCyclesObject();
+                        instanceObj->tfm = mat4d_to_transform(
+                            instanceTransform);
+                        instanceObj->geometry = m_cyclesMesh;
 
-                    // TODO: Implement motion blur for point instanced objects
-                    /*if (m_useMotionBlur) {
-                        m_cyclesMesh->motion_steps    = m_motionSteps;
-                        m_cyclesMesh->use_motion_blur = m_useMotionBlur;
-
-                        instanceObj->motion.clear();
-                        instanceObj->motion.resize(m_motionSteps);
-                        for (int j = 0; j < m_motionSteps; j++) {
-                            instanceObj->motion[j] = mat4d_to_transform(
-                                combinedTransforms[j].data()[j]);
-                        }
-                    }*/
-
-                    m_cyclesInstances.push_back(instanceObj);
-
-                    m_renderDelegate->GetCyclesRenderParam()->AddObject(
-                        instanceObj);
-                }
+                        newInstances[i] = instanceObj;
+                    }
+                });
 
                 // Hide prototype
                 if (m_cyclesObject)
@@ -1267,8 +1697,108 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     // -------------------------------------
     // -- Finish Mesh
 
-    if (newMesh && m_cyclesMesh) {
+    if (newMesh && m_stagingMesh) {
+        // Cached meshes come with their tangents. Points only updates have
+        // no topology to derive them from, they follow after the commit.
+        if (!cacheHit && !pointsOnly) {
+            _PopulateTangents(scene, m_stagingMesh, false);
+
+            if (cacheKey)
+                geometryCache->Store(cacheKey, id, m_stagingMesh,
+                                     m_displayColor);
+        }
         _FinishMesh(scene);
+        syncTimer.AddElements(m_cyclesMesh->num_triangles());
+    }
+
+    // -------------------------------------
+    // -- Commit to Cycles
+
+    if (!(mesh_updated || newMesh || shadersDirty || instancesDirty
+          || !shadersToTag.empty()
+          || (*dirtyBits & HdChangeTracker::DirtyPrimID))) {
+        *dirtyBits = HdChangeTracker::Clean;
+        return;
+    }
+
+    // Changes to the geometry itself, as opposed to the object. Subdivision
+    // dices in world space, so moving further than the dicing threshold
+    // changes the geometry too.
+    bool geometryChanged = newMesh || shadersDirty;
+    if (transformDirty && m_cyclesMesh->subd_params) {
+        const float threshold = param->GetDicingThreshold();
+        const GfVec3d offset  = _HdCyclesSamplePosition(m_transformSamples)
+                               - m_dicedPosition;
+        if (threshold >= 0.0f && offset.GetLength() > threshold)
+            geometryChanged = true;
+    }
+
+    scene->mutex.lock();
+
+    // A mesh shared with other prims is never edited in place, this prim
+    // moves to its own mesh first. Only a full rebuild can skip the copy.
+    if (geometryChanged && !param->UnshareGeometry(m_cyclesMesh)) {
+        _DetachCyclesMesh(param, !newMesh || pointsOnly);
+    }
+
+    if (pointsOnly) {
+        _CommitPoints();
+
+        // The live mesh still has its topology and uvs, only the tangents
+        // of the moved points are regenerated
+        if (!m_uvSets.empty())
+            _PopulateTangents(scene, m_cyclesMesh, true);
+    } else if (newMesh) {
+        _CommitMesh();
+
+        if (m_useSubdivision && m_subdivEnabled) {
+            if (!m_cyclesMesh->subd_params) {
+                m_cyclesMesh->subd_params = new ccl::SubdParams(m_cyclesMesh);
+            }
+
+            ccl::SubdParams& subd_params = *m_cyclesMesh->subd_params;
+
+            // The render param lowers max_level to fit the face budget
+            subd_params.dicing_rate   = m_dicingRate;
+            subd_params.max_level     = m_maxSubdivision;
+            subd_params.objecttoworld = m_cyclesObject->tfm;
+        }
+    }
+
+    if (shadersDirty) {
+        m_cyclesMesh->used_shaders = m_usedShaders;
+    }
+
+    for (ccl::Shader* shader : shadersToTag) {
+        shader->tag_update(scene);
+    }
+
+    if (transformDirty) {
+        HdCyclesApplyTransform(m_cyclesObject, m_transformSamples,
+                               m_useMotionBlur);
+
+        if (geometryChanged && m_cyclesMesh->subd_params) {
+            m_cyclesMesh->subd_params->objecttoworld = m_cyclesObject->tfm;
+        }
+    }
+
+    m_cyclesObject->is_shadow_catcher = m_isShadowCatcher;
+    m_cyclesObject->pass_id           = m_passId;
+    m_cyclesObject->use_holdout       = m_useHoldout;
+    m_cyclesObject->color             = m_displayColor;
+
+    if (instancesDirty) {
+        // Clear all instances...
+        for (auto instance : m_cyclesInstances) {
+            if (instance) {
+                param->RemoveObject(instance);
+            }
+        }
+        m_cyclesInstances = std::move(newInstances);
+
+        for (auto instance : m_cyclesInstances) {
+            param->AddObject(instance);
+        }
     }
 
     if (mesh_updated || newMesh) {
@@ -1276,13 +1806,73 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         if (!_sharedData.visible)
             m_cyclesObject->visibility = 0;
 
-        m_cyclesMesh->tag_update(scene, false);
         m_cyclesObject->tag_update(scene);
-        param->Interrupt();
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeTransform);
     }
 
     scene->mutex.unlock();
 
+    // Identical meshes share one ccl::Mesh and BVH, only the objects differ.
+    // This mesh is only used by this prim right now, so it can be hashed
+    // without holding the scene lock.
+    if (geometryChanged || instancesDirty) {
+        size_t geometryHash = 0;
+        if (geometryChanged) {
+            geometryHash = HdCyclesHashMesh(m_cyclesMesh);
+        }
+
+        scene->mutex.lock();
+
+        bool sharesExisting = false;
+        if (geometryChanged) {
+            ccl::Geometry* geometry = param->ShareGeometry(geometryHash,
+                                                           m_cyclesMesh);
+            sharesExisting = (geometry != m_cyclesMesh);
+            m_cyclesMesh   = static_cast<ccl::Mesh*>(geometry);
+        }
+
+        if (m_cyclesObject->geometry != m_cyclesMesh) {
+            m_cyclesObject->geometry = m_cyclesMesh;
+            m_cyclesObject->tag_update(scene);
+        }
+
+        for (auto instance : m_cyclesInstances) {
+            if (instance && instance->geometry != m_cyclesMesh) {
+                instance->geometry = m_cyclesMesh;
+                instance->tag_update(scene);
+            }
+        }
+
+        // Only a change of faces needs a BVH rebuild, moved points refit
+        // and object only edits leave the mesh alone. A mesh picked up from
+        // another prim is already up to date.
+        if (sharesExisting) {
+            param->TagSceneChange(HdCyclesRenderParam::SceneChangeGeometry);
+        } else if (geometryChanged) {
+            const bool rebuild = newMesh && !pointsOnly;
+            m_cyclesMesh->tag_update(scene, rebuild);
+            param->TagSceneChange(
+                rebuild ? HdCyclesRenderParam::SceneChangeGeometry
+                        : HdCyclesRenderParam::SceneChangeDeform);
+        }
+
+        scene->mutex.unlock();
+    }
+
+    // Diced again with the next update, remember where from
+    if (geometryChanged) {
+        if (m_cyclesMesh->subd_params) {
+            m_dicedPosition = _HdCyclesSamplePosition(m_transformSamples);
+            param->RegisterSubdivMesh(id, m_cyclesMesh, m_maxSubdivision);
+        } else if (newMesh) {
+            param->UnregisterSubdivMesh(id);
+        }
+    }
+
+    if (mesh_updated || newMesh) {
+        param->Interrupt();
+    }
+
     *dirtyBits = HdChangeTracker::Clean;
 }
 
@@ -29,6 +29,7 @@
 #include <pxr/base/gf/matrix4d.h>
 #include <pxr/base/gf/matrix4f.h>
 #include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3d.h>
 #include <pxr/base/gf/vec3f.h>
 #include <pxr/base/gf/vec3i.h>
 #include <pxr/imaging/hd/enums.h>
@@ -46,6 +47,7 @@ class Object;
 PXR_NAMESPACE_OPEN_SCOPE
 
 class HdCyclesRenderDelegate;
+class HdCyclesRenderParam;
 
 /**
  * @brief HdCycles Mesh Rprim mapped to Cycles mesh
@@ -101,6 +103,16 @@ protected:
      */
     ccl::Mesh* _CreateCyclesMesh();
 
+    /**
+     * @brief Switch to a new mesh only used by this prim, when the current
+     * one is shared with other prims. Must be called with the scene mutex
+     * held.
+     *
+     * @param a_param Render param the meshes are registered with
+     * @param a_copyContent Copy the shared mesh, for edits that keep parts
+     */
+    void _DetachCyclesMesh(HdCyclesRenderParam* a_param, bool a_copyContent);
+
     /**
      * @brief Create the cycles object representation
      * 
@@ -115,6 +127,22 @@ protected:
      */
     void _FinishMesh(ccl::Scene* scene);
 
+    /**
+     * @brief Move the data built into the staging mesh into the Cycles
+     * mesh used by the scene. Must be called with the scene mutex held.
+     * 
+     */
+    void _CommitMesh();
+
+    /**
+     * @brief Move the vertex positions and vertex attributes built into the
+     * staging mesh into the Cycles mesh, keeping its faces and other
+     * attributes. Only valid when the topology is unchanged. Must be called
+     * with the scene mutex held.
+     * 
+     */
+    void _CommitPoints();
+
     /**
      * @brief Comptue Mikktspace tangents
      * 
@@ -132,22 +160,33 @@ protected:
     void _AddUVSet(TfToken name, VtValue uvs, ccl::Scene* scene,
                    HdInterpolation interpolation);
 
+    /**
+     * @brief Generate uv set tangents in parallel across uv sets, for
+     * batch renders only those the bound shaders use. Reuses the previous
+     * tangents of uv sets whose values, points and topology did not change.
+     * 
+     * @param scene 
+     * @param a_mesh Mesh holding the topology, uvs and points
+     * @param a_sceneLocked Whether the caller holds the scene mutex
+     */
+    void _PopulateTangents(ccl::Scene* scene, ccl::Mesh* a_mesh,
+                           bool a_sceneLocked);
+
     /**
      * @brief Add vertex/face normals (Not implemented)
      * 
      * @param normals 
      * @param interpolation 
      */
-    void _AddNormals(VtVec3fArray& normals, HdInterpolation interpolation);
+    void _AddNormals(const VtVec3fArray& normals,
+                     HdInterpolation interpolation);
 
     /**
-     * @brief Add vertex velocities (Not tested)
-     * 
-     * @param velocities 
-     * @param interpolation 
+     * @brief Populate motion vertices by moving the points along their
+     * velocities and accelerations over the shutter. Used when points only
+     * have a single time sample.
      */
-    void _AddVelocities(VtVec3fArray& velocities,
-                        HdInterpolation interpolation);
+    void _PopulateVelocityMotion();
 
     /**
      * @brief Add vertex/primitive colors
@@ -221,6 +260,14 @@ protected:
     void _PopulateFaces(const std::vector<int>& a_faceMaterials,
                         bool a_subdivide);
 
+    /**
+     * @brief Fan triangulate the topology, shared by the faces and all
+     * uniform and face-varying primvars until the topology changes. Left
+     * handed face vertex indices are reversed in the same pass.
+     * 
+     */
+    void _ComputeTriangulation();
+
     /**
      * @brief Populate subdiv creases
      * 
@@ -234,6 +281,7 @@ protected:
     void _PopulateGenerated(ccl::Scene* scene);
 
     ccl::Mesh* m_cyclesMesh;
+    ccl::Mesh* m_stagingMesh;
     ccl::Object* m_cyclesObject;
     std::vector<ccl::Object*> m_cyclesInstances;
 
@@ -253,15 +301,44 @@ protected:
     VtIntArray m_faceVertexIndices;
     TfToken m_orientation;
 
+    // Per triangle corner the vertex and face-varying index, per triangle
+    // the authored face it was fanned from
+    VtIntArray m_triangleVertices;
+    VtIntArray m_triangleCorners;
+    VtIntArray m_triangleFaces;
+
+    // Triangulation is deferred until a rebuild misses the geometry cache
+    bool m_triangulationValid = false;
+
+    // Hash of the authored topology for geometry cache keys
+    uint64_t m_topologyHash = 0;
+
     HdCyclesSampledPrimvarType m_pointSamples;
 
+    VtVec3fArray m_velocities;
+    VtVec3fArray m_accelerations;
     float m_velocityScale;
 
+    // Uv sets added to the staging mesh, tangents are generated once the
+    // bound shaders are known
+    std::vector<std::pair<TfToken, VtValue>> m_uvSets;
+
+    struct TangentCache {
+        VtValue uvs;
+        VtVec3fArray points;
+        ccl::vector<char> tangent;
+        ccl::vector<char> sign;
+    };
+    std::map<TfToken, TangentCache> m_tangentCache;
+
     bool m_useSubdivision = false;
     bool m_subdivEnabled  = false;
     int m_maxSubdivision  = 12;
     float m_dicingRate    = 0.1f;
 
+    // Object position the subdivided mesh was last diced at
+    GfVec3d m_dicedPosition = GfVec3d(0.0);
+
     int m_numNgons;
     int m_numCorners;
 
@@ -306,12 +383,22 @@ protected:
 
     bool m_hasVertexColors;
 
+    // Object settings, staged until the commit
+    bool m_isShadowCatcher;
+    bool m_useHoldout;
+    int m_passId;
+    ccl::float3 m_displayColor;
+
     ccl::vector<ccl::Shader*> m_usedShaders;
+    // Shader of the bound material, as last seen in m_usedShaders
+    ccl::Shader* m_materialShader;
 
 public:
     const VtIntArray& GetFaceVertexCounts() { return m_faceVertexCounts; }
     const VtIntArray& GetFaceVertexIndices() { return m_faceVertexIndices; }
     const TfToken& GetOrientation() { return m_orientation; }
+    const VtIntArray& GetTriangleCorners() { return m_triangleCorners; }
+    const VtIntArray& GetTriangleFaces() { return m_triangleFaces; }
 
 private:
     HdCyclesRenderDelegate* m_renderDelegate;
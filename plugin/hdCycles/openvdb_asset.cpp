@@ -19,11 +19,93 @@
 
 #include "openvdb_asset.h"
 
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/tf/instantiateSingleton.h>
 #include <pxr/imaging/hd/renderIndex.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 
+#include <iostream>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
+#ifdef WITH_OPENVDB
+TF_INSTANTIATE_SINGLETON(HdCyclesVdbCache);
+
+HdCyclesVdbCache&
+HdCyclesVdbCache::GetInstance()
+{
+    return TfSingleton<HdCyclesVdbCache>::GetInstance();
+}
+
+openvdb::GridBase::ConstPtr
+HdCyclesVdbCache::GetGrid(const std::string& a_filepath,
+                          const std::string& a_gridName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    _Prune();
+
+    double modificationTime = 0.0;
+    ArchGetModificationTime(a_filepath.c_str(), &modificationTime);
+
+    FileEntry& entry = m_files[a_filepath];
+
+    // Caches written over in place, as sims do, are read again
+    if (entry.file && entry.modificationTime != modificationTime) {
+        entry.file.reset();
+        entry.grids.clear();
+    }
+
+    auto gridIt = entry.grids.find(a_gridName);
+    if (gridIt != entry.grids.end()) {
+        if (openvdb::GridBase::ConstPtr grid = gridIt->second.lock())
+            return grid;
+    }
+
+    try {
+        if (!entry.file) {
+            entry.file.reset(new openvdb::io::File(a_filepath));
+
+            // Delay loads voxel data straight from the file
+            entry.file->setCopyMaxBytes(0);
+            entry.file->open();
+            entry.modificationTime = modificationTime;
+        }
+
+        openvdb::GridBase::ConstPtr grid = entry.file->readGrid(a_gridName);
+        entry.grids[a_gridName]          = grid;
+        return grid;
+    } catch (const openvdb::Exception& e) {
+        std::cout << "Could not load grid " << a_gridName << " from "
+                  << a_filepath << ": " << e.what() << '\n';
+    }
+
+    if (entry.grids.empty())
+        m_files.erase(a_filepath);
+
+    return nullptr;
+}
+
+void
+HdCyclesVdbCache::_Prune()
+{
+    for (auto fileIt = m_files.begin(); fileIt != m_files.end();) {
+        auto& grids = fileIt->second.grids;
+        for (auto gridIt = grids.begin(); gridIt != grids.end();) {
+            if (gridIt->second.expired())
+                gridIt = grids.erase(gridIt);
+            else
+                ++gridIt;
+        }
+
+        if (grids.empty())
+            fileIt = m_files.erase(fileIt);
+        else
+            ++fileIt;
+    }
+}
+#endif
+
 HdCyclesOpenvdbAsset::HdCyclesOpenvdbAsset(HdCyclesRenderDelegate* a_delegate,
                                            const SdfPath& id)
     : HdField(id)
@@ -27,32 +27,86 @@
 
 #include "renderDelegate.h"
 
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #ifdef WITH_OPENVDB
 #    include <render/image_vdb.h>
 #    include <openvdb/openvdb.h>
+
+#    include <pxr/base/tf/singleton.h>
 #endif
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 #ifdef WITH_OPENVDB
-// Very temporary. Apparently Cycles has code to do this but it isnt in the head cycles standalone repo
+/**
+ * @brief Shares open OpenVDB files and their grids between fields, volumes
+ * and frames. Fields stored in the same file open it once, and a grid is
+ * read once for as long as a loader still holds it. Cycles compares VDB
+ * loaders by grid, so reusing the grid also reuses the uploaded image.
+ *
+ */
+class HdCyclesVdbCache {
+public:
+    /**
+     * @brief Get the instance of the shared cache
+     *
+     * @return Cache instance
+     */
+    HDCYCLES_API
+    static HdCyclesVdbCache& GetInstance();
+
+    /**
+     * @brief Get a grid, reading it only if no loader holds it. Files are
+     * reopened when they change on disk. This is thread safe.
+     *
+     * @param a_filepath Resolved path of the OpenVDB file
+     * @param a_gridName Name of the grid in the file
+     * @return The grid, or nullptr if it can't be read
+     */
+    HDCYCLES_API
+    openvdb::GridBase::ConstPtr GetGrid(const std::string& a_filepath,
+                                        const std::string& a_gridName);
+
+private:
+    struct FileEntry {
+        std::unique_ptr<openvdb::io::File> file;
+        double modificationTime;
+        std::unordered_map<std::string, std::weak_ptr<const openvdb::GridBase>>
+            grids;
+    };
+
+    /**
+     * @brief Close files whose grids are no longer used by any loader
+     */
+    void _Prune();
+
+    HdCyclesVdbCache()                        = default;
+    ~HdCyclesVdbCache()                       = default;
+    HdCyclesVdbCache(const HdCyclesVdbCache&) = delete;
+    HdCyclesVdbCache& operator=(const HdCyclesVdbCache&) = delete;
+
+    friend class TfSingleton<HdCyclesVdbCache>;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, FileEntry> m_files;
+};
+
+/**
+ * @brief Cycles image loader for a grid from the shared HdCyclesVdbCache
+ *
+ */
 class HdCyclesVolumeLoader : public ccl::VDBImageLoader {
 public:
     HdCyclesVolumeLoader(const char* filepath, const char* grid_name)
         : ccl::VDBImageLoader(grid_name)
     {
-        openvdb::io::File file(filepath);
-
-        try {
-            file.setCopyMaxBytes(0);
-            file.open();
-            this->grid = file.readGrid(grid_name);
-        } catch (const openvdb::IoError& e) {
-            std::cout << "LOAD ERROR\n";
-        }
+        this->grid = HdCyclesVdbCache::GetInstance().GetGrid(filepath,
+                                                             grid_name);
     }
 };
 #endif
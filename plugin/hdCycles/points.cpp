@@ -33,7 +33,10 @@
 
 #include <pxr/base/gf/vec3f.h>
 #include <pxr/base/gf/vec3i.h>
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/base/work/loops.h>
 #include <pxr/imaging/hd/mesh.h>
+#include <pxr/imaging/hd/perfLog.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 
 #ifdef USE_USD_CYCLES_SCHEMA
@@ -42,11 +45,18 @@
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+// clang-format off
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    (accelerations)
+);
+// clang-format on
+
 HdCyclesPoints::HdCyclesPoints(SdfPath const& id, SdfPath const& instancerId,
                                HdCyclesRenderDelegate* a_renderDelegate)
     : HdPoints(id, instancerId)
     , m_renderDelegate(a_renderDelegate)
     , m_transform(ccl::transform_identity())
+    , m_visible(true)
 {
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
     config.enable_motion_blur.eval(m_useMotionBlur, true);
@@ -72,11 +82,9 @@ HdCyclesPoints::~HdCyclesPoints()
 
     m_cyclesObjects.clear();
 
-    // Remove mesh
+    // Remove mesh, the render param takes ownership of removed items
 
     m_renderDelegate->GetCyclesRenderParam()->RemoveMesh(m_cyclesMesh);
-
-    delete m_cyclesMesh;
 }
 
 void
@@ -99,16 +107,19 @@ void
 HdCyclesPoints::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                      HdDirtyBits* dirtyBits, TfToken const& reprSelector)
 {
+    HD_TRACE_FUNCTION();
+
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
 
-    const SdfPath& id = GetId();
+    HdCyclesSyncTimer syncTimer(param, HdPrimTypeTokens->points);
 
-    HdCyclesPDPIMap pdpi;
+    const SdfPath& id = GetId();
 
     ccl::Scene* scene = param->GetCyclesScene();
 
-    bool needs_update  = false;
-    bool needs_newMesh = true;
+    bool needs_update     = false;
+    bool needs_newMesh    = m_cyclesMesh->verts.empty();
+    bool needs_transforms = false;
 
     // Read Cycles Primvars
 
@@ -116,154 +127,148 @@ HdCyclesPoints::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
     if (HdChangeTracker::IsPrimvarDirty(
             *dirtyBits, id, usdCyclesTokens->cyclesObjectPoint_style)) {
-        needs_newMesh = true;
-
         HdTimeSampleArray<VtValue, 1> xf;
         sceneDelegate->SamplePrimvar(id,
                                      usdCyclesTokens->cyclesObjectPoint_style,
                                      &xf);
         if (xf.count > 0) {
             const TfToken& styles = xf.values[0].Get<TfToken>();
-            m_pointStyle          = POINT_DISCS;
+            int pointStyle        = POINT_DISCS;
             if (styles == usdCyclesTokens->sphere) {
-                m_pointStyle = POINT_SPHERES;
+                pointStyle = POINT_SPHERES;
             }
+            needs_newMesh |= pointStyle != m_pointStyle;
+            m_pointStyle = pointStyle;
         }
     }
 
     if (HdChangeTracker::IsPrimvarDirty(
             *dirtyBits, id, usdCyclesTokens->cyclesObjectPoint_resolution)) {
-        needs_newMesh = true;
-
         HdTimeSampleArray<VtValue, 1> xf;
         sceneDelegate->SamplePrimvar(
             id, usdCyclesTokens->cyclesObjectPoint_resolution, &xf);
         if (xf.count > 0) {
             const int& resolutions = xf.values[0].Get<int>();
-            m_pointResolution      = std::max(resolutions, 10);
+            int pointResolution    = std::max(resolutions, 10);
+            needs_newMesh |= pointResolution != m_pointResolution;
+            m_pointResolution = pointResolution;
         }
     }
 
 #endif
 
-    // Create Points
-
-    if (*dirtyBits & HdChangeTracker::DirtyPoints || needs_newMesh) {
-        needs_update = true;
+    // Gather point data, nothing here touches the Cycles scene
 
-        m_cyclesMesh->clear();
+    if (*dirtyBits & HdChangeTracker::DirtyPoints) {
+        needs_transforms = true;
 
-        if (m_pointStyle == HdCyclesPointStyle::POINT_DISCS) {
-            _CreateDiscMesh();
+        const auto pointsValue = sceneDelegate->Get(id, HdTokens->points);
+        if (!pointsValue.IsEmpty() && pointsValue.IsHolding<VtVec3fArray>()) {
+            m_points = pointsValue.UncheckedGet<VtVec3fArray>();
         } else {
-            _CreateSphereMesh();
+            m_points = VtVec3fArray();
         }
+    }
 
-        m_cyclesMesh->tag_update(scene, true);
+    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
+        needs_transforms = true;
 
-        const auto pointsValue = sceneDelegate->Get(id, HdTokens->points);
-        if (!pointsValue.IsEmpty() && pointsValue.IsHolding<VtVec3fArray>()) {
-            const VtVec3fArray& points = pointsValue.Get<VtVec3fArray>();
+        m_transform = HdCyclesExtractTransform(sceneDelegate, id);
+    }
 
-            for (int i = 0; i < m_cyclesObjects.size(); i++) {
-                param->RemoveObject(m_cyclesObjects[i]);
-            }
+    // Points are separate objects, velocities and accelerations become
+    // object motion instead of motion vertices
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id,
+                                        HdTokens->velocities)) {
+        VtVec3fArray velocities;
+        VtVec3fArray accelerations;
+
+        VtValue value = sceneDelegate->Get(id, HdTokens->velocities);
+        if (value.IsHolding<VtVec3fArray>())
+            velocities = value.UncheckedGet<VtVec3fArray>();
+
+        value = sceneDelegate->Get(id, _tokens->accelerations);
+        if (value.IsHolding<VtVec3fArray>())
+            accelerations = value.UncheckedGet<VtVec3fArray>();
+
+        if (velocities != m_velocities || accelerations != m_accelerations) {
+            m_velocities     = velocities;
+            m_accelerations  = accelerations;
+            needs_transforms = true;
+        }
+    }
 
-            m_cyclesObjects.clear();
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->widths)) {
+        needs_transforms = true;
 
-            for (int i = 0; i < points.size(); i++) {
-                ccl::Object* pointObject = _CreatePointsObject(
-                    ccl::transform_translate(vec3f_to_float3(points[i])),
-                    m_cyclesMesh);
+        m_widths = VtFloatArray();
 
-                pointObject->random_id = i;
-                pointObject->name
-                    = ccl::ustring::format("%s@%08x", pointObject->name,
-                                           pointObject->random_id);
-                m_cyclesObjects.push_back(pointObject);
-                param->AddObject(pointObject);
-            }
+        HdTimeSampleArray<VtValue, 2> xf;
+        sceneDelegate->SamplePrimvar(id, HdTokens->widths, &xf);
+        if (xf.count > 0 && xf.values[0].IsHolding<VtFloatArray>()) {
+            m_widths = xf.values[0].UncheckedGet<VtFloatArray>();
         }
     }
 
-    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        ccl::Transform newTransform = HdCyclesExtractTransform(sceneDelegate,
-                                                               id);
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals)) {
+        needs_transforms = true;
+
+        // TODO: Orient to camera when no normals are authored
 
-        for (int i = 0; i < m_cyclesObjects.size(); i++) {
-            m_cyclesObjects[i]->tfm = ccl::transform_inverse(m_transform)
-                                      * m_cyclesObjects[i]->tfm;
-            m_cyclesObjects[i]->tfm = newTransform * m_cyclesObjects[i]->tfm;
+        m_normals = VtVec3fArray();
+
+        HdTimeSampleArray<VtValue, 1> xf;
+        sceneDelegate->SamplePrimvar(id, HdTokens->normals, &xf);
+        if (xf.count > 0 && xf.values[0].IsHolding<VtVec3fArray>()) {
+            m_normals = xf.values[0].UncheckedGet<VtVec3fArray>();
         }
+    }
 
-        m_transform = newTransform;
+    bool needs_visibility = false;
+    if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
+        needs_visibility = true;
 
-        needs_update = true;
+        m_visible = sceneDelegate->GetVisible(id);
     }
 
-    // TODO: It's likely that this can cause double transforms due to modifying the core transform
-    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->widths)) {
-        needs_update = true;
-
-        if (m_cyclesObjects.size() > 0) {
-            HdTimeSampleArray<VtValue, 2> xf;
-            sceneDelegate->SamplePrimvar(id, HdTokens->widths, &xf);
-            if (xf.count > 0) {
-                const VtFloatArray& widths = xf.values[0].Get<VtFloatArray>();
-                for (int i = 0; i < widths.size(); i++) {
-                    if (i < m_cyclesObjects.size()) {
-                        float w                 = widths[i];
-                        m_cyclesObjects[i]->tfm = m_cyclesObjects[i]->tfm
-                                                  * ccl::transform_scale(w, w,
-                                                                         w);
-                    }
-                }
-            }
-        }
+    // Objects are queued with the render param, new ones are not in the
+    // scene yet and can be set up without the scene mutex
+
+    if (*dirtyBits & HdChangeTracker::DirtyPoints) {
+        _ResizePointObjects(param, m_points.size());
+        needs_visibility = true;
     }
 
-    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals)) {
-        needs_update = true;
-
-        if (m_cyclesObjects.size() > 0) {
-            HdTimeSampleArray<VtValue, 1> xf;
-            sceneDelegate->SamplePrimvar(id, HdTokens->normals, &xf);
-            if (xf.count > 0) {
-                const VtVec3fArray& normals = xf.values[0].Get<VtVec3fArray>();
-                for (int i = 0; i < normals.size(); i++) {
-                    if (i < m_cyclesObjects.size()) {
-                        ccl::float3 rotAxis
-                            = ccl::cross(ccl::make_float3(0.0f, 0.0f, 1.0f),
-                                         ccl::make_float3(normals[i][0],
-                                                          normals[i][1],
-                                                          normals[i][2]));
-                        float d = ccl::dot(ccl::make_float3(0.0f, 0.0f, 1.0f),
-                                           ccl::make_float3(normals[i][0],
-                                                            normals[i][1],
-                                                            normals[i][2]));
-                        float angle = atan2f(ccl::len(rotAxis), d);
-                        m_cyclesObjects[i]->tfm
-                            = m_cyclesObjects[i]->tfm
-                              * ccl::transform_rotate((angle), rotAxis);
-                    }
-                }
+    needs_update = needs_newMesh || needs_transforms || needs_visibility;
+
+    if (needs_update) {
+        scene->mutex.lock();
+
+        if (needs_newMesh) {
+            if (m_pointStyle == HdCyclesPointStyle::POINT_DISCS) {
+                _CreateDiscMesh();
             } else {
-                // handle orient to camera
+                _CreateSphereMesh();
             }
+
+            m_cyclesMesh->tag_update(scene, true);
+            param->TagSceneChange(HdCyclesRenderParam::SceneChangeGeometry);
         }
-    }
 
-    if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
-        needs_update = true;
+        if (needs_transforms) {
+            _UpdatePointTransforms();
+            syncTimer.AddElements(m_cyclesObjects.size());
+        }
 
-        bool visible = sceneDelegate->GetVisible(id);
-        for (int i = 0; i < m_cyclesObjects.size(); i++) {
-            if (visible) {
-                m_cyclesObjects[i]->visibility |= ccl::PATH_RAY_ALL_VISIBILITY;
-            } else {
-                m_cyclesObjects[i]->visibility &= ~ccl::PATH_RAY_ALL_VISIBILITY;
-            }
+        if (needs_visibility)
+            _UpdatePointVisibility();
+
+        if (needs_transforms || needs_visibility) {
+            scene->object_manager->tag_update(scene);
+            param->TagSceneChange(HdCyclesRenderParam::SceneChangeTransform);
         }
+
+        scene->mutex.unlock();
     }
 
     if (needs_update)
@@ -385,4 +390,129 @@ HdCyclesPoints::_CreatePointsObject(const ccl::Transform& transform,
     return object;
 }
 
+void
+HdCyclesPoints::_ResizePointObjects(HdCyclesRenderParam* a_param,
+                                    size_t a_count)
+{
+    while (m_cyclesObjects.size() > a_count) {
+        a_param->RemoveObject(m_cyclesObjects.back());
+        m_cyclesObjects.pop_back();
+    }
+
+    m_cyclesObjects.reserve(a_count);
+
+    while (m_cyclesObjects.size() < a_count) {
+        // Points are only told apart by random_id, a unique name per point
+        // would put millions of strings in the ustring table
+        ccl::Object* pointObject = _CreatePointsObject(m_transform,
+                                                       m_cyclesMesh);
+        pointObject->random_id   = static_cast<int>(m_cyclesObjects.size());
+        pointObject->visibility  = m_visible ? ccl::PATH_RAY_ALL_VISIBILITY
+                                             : 0;
+
+        m_cyclesObjects.push_back(pointObject);
+        a_param->AddObject(pointObject);
+    }
+}
+
+void
+HdCyclesPoints::_UpdatePointTransforms()
+{
+    const size_t numPoints   = std::min(m_points.size(),
+                                      m_cyclesObjects.size());
+    const bool constantWidth = m_widths.size() == 1;
+
+    const bool useVelocities = m_useMotionBlur
+                               && m_velocities.size() == m_points.size();
+    const bool useAccelerations = useVelocities
+                                  && m_accelerations.size() == m_points.size();
+
+    std::vector<float> offsets;
+    if (useVelocities) {
+        offsets = HdCyclesMotionStepOffsets(
+            m_renderDelegate->GetCyclesRenderParam()->GetCyclesScene(),
+            m_motionSteps);
+    }
+    const size_t center = offsets.size() / 2;
+
+    // Each transform is built from scratch, so repeated syncs of the
+    // widths or normals no longer stack on top of each other
+
+    WorkParallelForN(numPoints, [&](size_t begin, size_t end) {
+        const ccl::float3 up = ccl::make_float3(0.0f, 0.0f, 1.0f);
+
+        for (size_t i = begin; i < end; ++i) {
+            ccl::Transform local = ccl::transform_identity();
+
+            if (i < m_normals.size() && m_normals[i].GetLength() > 0.0f) {
+                const ccl::float3 normal = ccl::normalize(
+                    vec3f_to_float3(m_normals[i]));
+                const ccl::float3 rotAxis = ccl::cross(up, normal);
+                const float sinAngle      = ccl::len(rotAxis);
+                const float cosAngle      = ccl::dot(up, normal);
+
+                if (sinAngle > 1e-6f) {
+                    local = local
+                            * ccl::transform_rotate(atan2f(sinAngle, cosAngle),
+                                                    rotAxis / sinAngle);
+                } else if (cosAngle < 0.0f) {
+                    local = local
+                            * ccl::transform_rotate(M_PI_F,
+                                                    ccl::make_float3(1.0f, 0.0f,
+                                                                     0.0f));
+                }
+            }
+
+            if (constantWidth || i < m_widths.size()) {
+                const float w = m_widths[constantWidth ? 0 : i];
+                local         = local * ccl::transform_scale(w, w, w);
+            }
+
+            ccl::Object* object = m_cyclesObjects[i];
+
+            object->tfm = m_transform
+                          * ccl::transform_translate(
+                              vec3f_to_float3(m_points[i]))
+                          * local;
+
+            object->motion.clear();
+            if (!useVelocities)
+                continue;
+
+            // Only the position moves over the shutter, the center step
+            // is the frame itself
+            object->motion.resize(offsets.size() + 1);
+            for (size_t step = 0; step <= offsets.size(); ++step) {
+                if (step == center) {
+                    object->motion[step] = object->tfm;
+                    continue;
+                }
+
+                const float t = offsets[step < center ? step : step - 1];
+
+                GfVec3f p = m_points[i] + m_velocities[i] * t;
+                if (useAccelerations)
+                    p += m_accelerations[i] * (0.5f * t * t);
+
+                object->motion[step] = m_transform
+                                       * ccl::transform_translate(
+                                           vec3f_to_float3(p))
+                                       * local;
+            }
+        }
+    });
+}
+
+void
+HdCyclesPoints::_UpdatePointVisibility()
+{
+    for (ccl::Object* object : m_cyclesObjects) {
+        if (m_visible) {
+            object->visibility |= ccl::PATH_RAY_ALL_VISIBILITY;
+        } else {
+            object->visibility &= ~ccl::PATH_RAY_ALL_VISIBILITY;
+        }
+    }
+}
+
 PXR_NAMESPACE_CLOSE_SCOPE
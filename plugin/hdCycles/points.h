@@ -27,6 +27,7 @@
 
 #include <util/util_transform.h>
 
+#include <pxr/base/vt/types.h>
 #include <pxr/imaging/hd/points.h>
 #include <pxr/pxr.h>
 
@@ -40,6 +41,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 class HdSceneDelegate;
 class HdCyclesRenderDelegate;
+class HdCyclesRenderParam;
 
 enum HdCyclesPointStyle {
     POINT_DISCS,
@@ -49,6 +51,10 @@ enum HdCyclesPointStyle {
 /**
  * @brief An intermediate solution for HdPoints as Cycles doesn't
  * natively support point clouds.
+ *
+ * Every point is a ccl::Object instancing one shared disc or sphere
+ * prototype mesh, the prototype is only rebuilt when the style or
+ * resolution changes.
  * 
  */
 class HdCyclesPoints final : public HdPoints {
@@ -145,6 +151,29 @@ private:
     ccl::Object* _CreatePointsObject(const ccl::Transform& transform,
                                      ccl::Mesh* mesh);
 
+    /**
+     * @brief Grow or shrink the point objects to match the point count,
+     * existing objects are reused
+     *
+     * @param a_param Render param to queue added and removed objects with
+     * @param a_count Number of points
+     */
+    void _ResizePointObjects(HdCyclesRenderParam* a_param, size_t a_count);
+
+    /**
+     * @brief Rebuild every point transform from the prim transform and the
+     * cached points, widths and normals, with object motion from the
+     * velocities when motion blur is enabled. Must be called with the scene
+     * mutex held.
+     */
+    void _UpdatePointTransforms();
+
+    /**
+     * @brief Apply the cached visibility to every point object. Must be
+     * called with the scene mutex held.
+     */
+    void _UpdatePointVisibility();
+
     ccl::Mesh* m_cyclesMesh;
 
     std::vector<ccl::Object*> m_cyclesObjects;
@@ -156,11 +185,18 @@ private:
     int m_pointStyle;
     int m_pointResolution;
 
-    // -- Currently unused
+    VtVec3fArray m_points;
+    VtFloatArray m_widths;
+    VtVec3fArray m_normals;
+    VtVec3fArray m_velocities;
+    VtVec3fArray m_accelerations;
+    bool m_visible;
 
     bool m_useMotionBlur;
     int m_motionSteps;
 
+    // -- Currently unused
+
     HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> m_transformSamples;
 };
 
@@ -21,54 +21,160 @@
 #include "renderDelegate.h"
 #include "renderPass.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <pxr/base/gf/vec2i.h>
 #include <pxr/base/gf/vec3i.h>
+#include <pxr/base/work/loops.h>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 namespace {
-template<typename T>
+
+// Component storage types. Read and Write convert to and from the
+// intermediate type T, which is int32_t when both sides are integers so
+// they don't round trip through float.
+
+struct _Int32 {
+    using Type = int32_t;
+    template<typename T> static T Read(Type a_value)
+    {
+        return static_cast<T>(a_value);
+    }
+    template<typename T> static Type Write(T a_value)
+    {
+        return static_cast<Type>(a_value);
+    }
+};
+
+struct _Float16 {
+    using Type = uint16_t;
+    template<typename T> static T Read(Type a_value)
+    {
+        GfHalf half;
+        half.setBits(a_value);
+        return static_cast<T>(static_cast<float>(half));
+    }
+    template<typename T> static Type Write(T a_value)
+    {
+        return GfHalf(static_cast<float>(a_value)).bits();
+    }
+};
+
+struct _Float32 {
+    using Type = float;
+    template<typename T> static T Read(Type a_value)
+    {
+        return static_cast<T>(a_value);
+    }
+    template<typename T> static Type Write(T a_value)
+    {
+        return static_cast<Type>(a_value);
+    }
+};
+
+struct _UNorm8 {
+    using Type = uint8_t;
+    template<typename T> static T Read(Type a_value)
+    {
+        return static_cast<T>(a_value / 255.0f);
+    }
+    template<typename T> static Type Write(T a_value)
+    {
+        float v = std::min(std::max(static_cast<float>(a_value), 0.0f), 1.0f);
+        return static_cast<Type>(v * 255.0f);
+    }
+};
+
+struct _SNorm8 {
+    using Type = int8_t;
+    template<typename T> static T Read(Type a_value)
+    {
+        return static_cast<T>(a_value / 127.0f);
+    }
+    template<typename T> static Type Write(T a_value)
+    {
+        float v = std::min(std::max(static_cast<float>(a_value), -1.0f),
+                           1.0f);
+        return static_cast<Type>(v * 127.0f);
+    }
+};
+
+// Converts one row of pixels. a_columns maps destination to source columns
+// for nearest point sampling, or is null when the widths match.
+template<typename T, typename Src, typename Dst>
 void
-_ConvertPixel(HdFormat dstFormat, uint8_t* dst, HdFormat srcFormat,
-              uint8_t const* src)
+_ConvertRow(uint8_t* a_dst, size_t a_dstComponents, uint8_t const* a_src,
+            size_t a_srcComponents, unsigned int const* a_columns,
+            unsigned int a_width)
 {
-    HdFormat srcComponentFormat = HdGetComponentFormat(srcFormat);
-    HdFormat dstComponentFormat = HdGetComponentFormat(dstFormat);
-    size_t srcComponentCount    = HdGetComponentCount(srcFormat);
-    size_t dstComponentCount    = HdGetComponentCount(dstFormat);
-
-    for (size_t c = 0; c < dstComponentCount; ++c) {
-        T readValue = 0;
-        if (c < srcComponentCount) {
-            if (srcComponentFormat == HdFormatInt32) {
-                readValue = ((int32_t*)src)[c];
-            } else if (srcComponentFormat == HdFormatFloat16) {
-                GfHalf half;
-                half.setBits(((uint16_t*)src)[c]);
-                readValue = static_cast<float>(half);
-            } else if (srcComponentFormat == HdFormatFloat32) {
-                // We need to subtract one from here due to cycles prim defaulting to 0 but hydra to -1
-                readValue = ((float*)src)[c];
-            } else if (srcComponentFormat == HdFormatUNorm8) {
-                readValue = ((uint8_t*)src)[c] / 255.0f;
-            } else if (srcComponentFormat == HdFormatSNorm8) {
-                readValue = ((int8_t*)src)[c] / 127.0f;
-            }
-        }
+    auto dst = reinterpret_cast<typename Dst::Type*>(a_dst);
+    auto src = reinterpret_cast<typename Src::Type const*>(a_src);
+
+    const size_t numComponents = std::min(a_srcComponents, a_dstComponents);
 
-        if (dstComponentFormat == HdFormatInt32) {
-            ((int32_t*)dst)[c] = readValue;
-        } else if (dstComponentFormat == HdFormatFloat16) {
-            ((uint16_t*)dst)[c] = GfHalf(float(readValue)).bits();
-        } else if (dstComponentFormat == HdFormatFloat32) {
-            ((float*)dst)[c] = readValue;
-        } else if (dstComponentFormat == HdFormatUNorm8) {
-            ((uint8_t*)dst)[c] = (readValue * 255.0f);
-        } else if (dstComponentFormat == HdFormatSNorm8) {
-            ((int8_t*)dst)[c] = (readValue * 127.0f);
+    for (unsigned int i = 0; i < a_width; ++i) {
+        const size_t ii = a_columns ? a_columns[i] : i;
+        auto srcPixel   = src + ii * a_srcComponents;
+        auto dstPixel   = dst + i * a_dstComponents;
+
+        size_t c = 0;
+        for (; c < numComponents; ++c) {
+            dstPixel[c] = Dst::Write(Src::template Read<T>(srcPixel[c]));
+        }
+        for (; c < a_dstComponents; ++c) {
+            dstPixel[c] = Dst::Write(T(0));
         }
     }
 }
+
+using _ConvertRowFn = void (*)(uint8_t*, size_t, uint8_t const*, size_t,
+                               unsigned int const*, unsigned int);
+
+template<typename T, typename Src>
+_ConvertRowFn
+_GetConvertRow(HdFormat a_dstComponentFormat)
+{
+    switch (a_dstComponentFormat) {
+    case HdFormatInt32: return &_ConvertRow<T, Src, _Int32>;
+    case HdFormatFloat16: return &_ConvertRow<T, Src, _Float16>;
+    case HdFormatFloat32: return &_ConvertRow<T, Src, _Float32>;
+    case HdFormatUNorm8: return &_ConvertRow<T, Src, _UNorm8>;
+    case HdFormatSNorm8: return &_ConvertRow<T, Src, _SNorm8>;
+    default: return nullptr;
+    }
+}
+
+// Resolves the row converter once per blit instead of branching on the
+// formats for every component
+_ConvertRowFn
+_GetConvertRow(HdFormat a_srcFormat, HdFormat a_dstFormat)
+{
+    const HdFormat srcComponentFormat = HdGetComponentFormat(a_srcFormat);
+    const HdFormat dstComponentFormat = HdGetComponentFormat(a_dstFormat);
+
+    // If src and dst are both int-based, don't round trip to float.
+    if (srcComponentFormat == HdFormatInt32
+        && dstComponentFormat == HdFormatInt32) {
+        return &_ConvertRow<int32_t, _Int32, _Int32>;
+    }
+
+    switch (srcComponentFormat) {
+    case HdFormatInt32:
+        return _GetConvertRow<float, _Int32>(dstComponentFormat);
+    case HdFormatFloat16:
+        return _GetConvertRow<float, _Float16>(dstComponentFormat);
+    case HdFormatFloat32:
+        return _GetConvertRow<float, _Float32>(dstComponentFormat);
+    case HdFormatUNorm8:
+        return _GetConvertRow<float, _UNorm8>(dstComponentFormat);
+    case HdFormatSNorm8:
+        return _GetConvertRow<float, _SNorm8>(dstComponentFormat);
+    default: return nullptr;
+    }
+}
+
 }  // namespace
 
 HdCyclesRenderBuffer::HdCyclesRenderBuffer(
@@ -178,59 +284,77 @@ void
 HdCyclesRenderBuffer::Blit(HdFormat format, int width, int height, int offset,
                            int stride, uint8_t const* data)
 {
-    if (m_format == format) {
-        if (static_cast<unsigned int>(width) == m_width
-            && static_cast<unsigned int>(height) == m_height) {
-            // Blit line by line.
-            for (unsigned int j = 0; j < m_height; ++j) {
-                memcpy(&m_buffer[(j * m_width) * m_pixelSize],
-                       &data[(j * stride + offset) * m_pixelSize],
-                       m_width * m_pixelSize);
-            }
-        } else {
-            // Blit pixel by pixel, with nearest point sampling.
-            float scalei = width / float(m_width);
-            float scalej = height / float(m_height);
-            for (unsigned int j = 0; j < m_height; ++j) {
-                for (unsigned int i = 0; i < m_width; ++i) {
-                    unsigned int ii = scalei * i;
-                    unsigned int jj = scalej * j;
-                    memcpy(&m_buffer[(j * m_width + i) * m_pixelSize],
-                           &data[(jj * stride + offset + ii) * m_pixelSize],
-                           m_pixelSize);
-                }
-            }
+    BlitRegion(format, 0, 0, m_width, m_height, width, height, offset, stride,
+               data);
+}
+
+void
+HdCyclesRenderBuffer::BlitRegion(HdFormat format, unsigned int x,
+                                 unsigned int y, unsigned int regionWidth,
+                                 unsigned int regionHeight, int width,
+                                 int height, int offset, int stride,
+                                 uint8_t const* data)
+{
+    if (m_buffer.empty() || width <= 0 || height <= 0)
+        return;
+
+    if (x >= m_width || y >= m_height)
+        return;
+
+    regionWidth  = std::min(regionWidth, m_width - x);
+    regionHeight = std::min(regionHeight, m_height - y);
+    if (regionWidth == 0 || regionHeight == 0)
+        return;
+
+    const size_t srcPixelSize = HdDataSizeOfFormat(format);
+    const size_t rowSize      = m_width * m_pixelSize;
+    const size_t copySize     = regionWidth * m_pixelSize;
+
+    // Nearest point sampling when the sizes differ, the source columns are
+    // computed once here rather than per pixel
+    std::vector<unsigned int> columns;
+    if (static_cast<unsigned int>(width) != regionWidth) {
+        float scalei = width / float(regionWidth);
+        columns.resize(regionWidth);
+        for (unsigned int i = 0; i < regionWidth; ++i) {
+            columns[i] = static_cast<unsigned int>(scalei * i);
         }
-    } else {
-        // Convert pixel by pixel, with nearest point sampling.
-        // If src and dst are both int-based, don't round trip to float.
-        size_t pixelSize  = HdDataSizeOfFormat(format);
-        bool convertAsInt = (HdGetComponentFormat(format) == HdFormatInt32)
-                            && (HdGetComponentFormat(m_format)
-                                == HdFormatInt32);
-
-        float scalei = width / float(m_width);
-        float scalej = height / float(m_height);
-        for (unsigned int j = 0; j < m_height; ++j) {
-            for (unsigned int i = 0; i < m_width; ++i) {
-                unsigned int ii = scalei * i;
-                unsigned int jj = scalej * j;
-                if (convertAsInt) {
-                    _ConvertPixel<int32_t>(
-                        m_format,
-                        static_cast<uint8_t*>(
-                            &m_buffer[(j * m_width + i) * m_pixelSize]),
-                        format, &data[(jj * stride + offset + ii) * pixelSize]);
-                } else {
-                    _ConvertPixel<float>(
-                        m_format,
-                        static_cast<uint8_t*>(
-                            &m_buffer[(j * m_width + i) * m_pixelSize]),
-                        format, &data[(jj * stride + offset + ii) * pixelSize]);
+    }
+    const float scalej    = height / float(regionHeight);
+    const bool sameHeight = static_cast<unsigned int>(height) == regionHeight;
+
+    _ConvertRowFn convertRow = nullptr;
+    if (m_format != format) {
+        convertRow = _GetConvertRow(format, m_format);
+        if (!convertRow)
+            return;
+    }
+
+    const size_t srcComponents = HdGetComponentCount(format);
+    const size_t dstComponents = HdGetComponentCount(m_format);
+
+    WorkParallelForN(regionHeight, [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            const size_t jj = sameHeight ? j
+                                         : static_cast<size_t>(scalej * j);
+            uint8_t const* srcRow = &data[(jj * stride + offset)
+                                          * srcPixelSize];
+            uint8_t* dstRow = &m_buffer[(y + j) * rowSize + x * m_pixelSize];
+
+            if (convertRow) {
+                convertRow(dstRow, dstComponents, srcRow, srcComponents,
+                           columns.empty() ? nullptr : columns.data(),
+                           regionWidth);
+            } else if (columns.empty()) {
+                memcpy(dstRow, srcRow, copySize);
+            } else {
+                for (unsigned int i = 0; i < regionWidth; ++i) {
+                    memcpy(&dstRow[i * m_pixelSize],
+                           &srcRow[columns[i] * srcPixelSize], m_pixelSize);
                 }
             }
         }
-    }
+    });
 }
 
 void
@@ -239,8 +363,7 @@ HdCyclesRenderBuffer::Clear()
     if (m_format == HdFormatInvalid)
         return;
 
-    size_t pixelSize = HdDataSizeOfFormat(m_format);
-    memset(&m_buffer[0], 0, m_buffer.size() * pixelSize);
+    memset(m_buffer.data(), 0, m_buffer.size());
 }
 
 void
@@ -259,55 +382,35 @@ HdCyclesRenderBuffer::BlitTile(HdFormat format, unsigned int x, unsigned int y,
         return;
     }
 
-    const auto numPixels = static_cast<size_t>(m_width * m_height);
-    size_t pixelSize     = HdDataSizeOfFormat(format);
+    if (x >= m_width || y >= m_height) {
+        return;
+    }
 
-    if (m_format == format) {
-        for (unsigned int j = 0; j < height; ++j) {
-            if ((x + width) <= m_width) {
-                if ((y + height) <= m_height) {
-                    int mem_start = (((y + j) * m_width) * pixelSize)
-                                    + (x * pixelSize);
+    _ConvertRowFn convertRow = nullptr;
+    if (m_format != format) {
+        convertRow = _GetConvertRow(format, m_format);
+        if (!convertRow)
+            return;
+    }
 
+    const size_t srcPixelSize  = HdDataSizeOfFormat(format);
+    const size_t srcComponents = HdGetComponentCount(format);
+    const size_t dstComponents = HdGetComponentCount(m_format);
 
-                    int tile_mem_start = (j * width) * pixelSize;
+    // Tiles overlapping the buffer edge are clipped
+    const unsigned int copyWidth  = std::min(width, m_width - x);
+    const unsigned int copyHeight = std::min(height, m_height - y);
 
-                    memcpy(&m_buffer[mem_start], &data[tile_mem_start],
-                           width * pixelSize);
-                }
-            }
-        }
-    } else {
-        // Convert pixel by pixel, with nearest point sampling.
-        // If src and dst are both int-based, don't round trip to float.
-        bool convertAsInt = (HdGetComponentFormat(format) == HdFormatInt32)
-                            && (HdGetComponentFormat(m_format)
-                                == HdFormatInt32);
-
-        for (unsigned int j = 0; j < height; ++j) {
-            for (unsigned int i = 0; i < width; ++i) {
-                int mem_start = (((y + j) * m_width) * m_pixelSize)
-                                + ((x + i) * m_pixelSize);
-
-                int tile_mem_start = ((j * width) * pixelSize)
-                                     + (i * pixelSize);
-
-                if (convertAsInt) {
-                    _ConvertPixel<int32_t>(m_format,
-                                           static_cast<uint8_t*>(
-                                               &m_buffer[mem_start]),
-                                           format, &data[tile_mem_start]);
-                } else {
-                    if (mem_start >= m_buffer.size()) {
-                        // TODO: This is triggered more times than it should be
-                    } else {
-                        _ConvertPixel<float>(m_format,
-                                             static_cast<uint8_t*>(
-                                                 &m_buffer[mem_start]),
-                                             format, &data[tile_mem_start]);
-                    }
-                }
-            }
+    for (unsigned int j = 0; j < copyHeight; ++j) {
+        uint8_t const* srcRow = &data[(j * width) * srcPixelSize];
+        uint8_t* dstRow       = &m_buffer[((y + j) * m_width + x)
+                                    * m_pixelSize];
+
+        if (convertRow) {
+            convertRow(dstRow, dstComponents, srcRow, srcComponents, nullptr,
+                       copyWidth);
+        } else {
+            memcpy(dstRow, srcRow, copyWidth * m_pixelSize);
         }
     }
 }
@@ -148,9 +148,32 @@ public:
      * @param stride Stride of pixel
      * @param data Pointer to data
      */
+    HDCYCLES_API
     void Blit(HdFormat format, int width, int height, int offset, int stride,
               uint8_t const* data);
 
+    /**
+     * @brief Blit the render buffer data scaled into a region, pixels
+     * outside of it are left untouched
+     * 
+     * @param format Input format
+     * @param x Left of the region
+     * @param y Bottom of the region
+     * @param regionWidth Width of the region
+     * @param regionHeight Height of the region
+     * @param width Width of buffer
+     * @param height Height of buffer
+     * @param offset Offset between pixels
+     * @param stride Stride of pixel
+     * @param data Pointer to data
+     */
+    HDCYCLES_API
+    void BlitRegion(HdFormat format, unsigned int x, unsigned int y,
+                    unsigned int regionWidth, unsigned int regionHeight,
+                    int width, int height, int offset, int stride,
+                    uint8_t const* data);
+
+    HDCYCLES_API
     void BlitTile(HdFormat format, unsigned int x, unsigned int y,
                   unsigned int width, unsigned int height, int offset,
                   int stride, uint8_t const* data);
@@ -41,9 +41,13 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <fstream>
+
 #include <pxr/base/gf/api.h>
 #include <pxr/base/gf/vec2i.h>
 #include <pxr/base/tf/getenv.h>
+#include <pxr/base/trace/collector.h>
+#include <pxr/base/trace/reporter.h>
 #include <pxr/base/vt/api.h>
 #include <pxr/imaging/hd/camera.h>
 #include <pxr/imaging/hd/tokens.h>
@@ -108,6 +112,9 @@ HdCyclesRenderDelegate::HdCyclesRenderDelegate(
 void
 HdCyclesRenderDelegate::_Initialize(HdRenderSettingsMap const& settingsMap)
 {
+    if (!HdCyclesConfig::GetInstance().trace_file.empty())
+        TraceCollector::GetInstance().SetEnabled(true);
+
     // -- Initialize Render Param (Core cycles wrapper)
     m_renderParam.reset(new HdCyclesRenderParam());
 
@@ -123,6 +130,18 @@ HdCyclesRenderDelegate::~HdCyclesRenderDelegate()
 {
     m_renderParam->StopRender();
     m_resourceRegistry.reset();
+
+    const std::string& traceFile = HdCyclesConfig::GetInstance().trace_file;
+    if (!traceFile.empty()) {
+        TraceCollector::GetInstance().SetEnabled(false);
+
+        std::ofstream file(traceFile);
+        if (file) {
+            TraceReporter::GetGlobalReporter()->ReportChromeTracing(file);
+        } else {
+            TF_WARN("Couldn't write trace to %s", traceFile.c_str());
+        }
+    }
 }
 
 TfTokenVector const&
@@ -167,8 +186,10 @@ HdCyclesRenderDelegate::SetRenderSetting(const TfToken& key,
                                          const VtValue& value)
 {
     HdRenderDelegate::SetRenderSetting(key, value);
+
+    // Only queued, CommitResources applies changed settings and resets the
+    // render when one of them took effect
     m_renderParam->SetRenderSetting(key, value);
-    m_renderParam->Interrupt();
 }
 
 HdRenderSettingDescriptorList
@@ -213,7 +234,7 @@ HdCyclesRenderDelegate::CommitResources(HdChangeTracker* tracker)
         }
     }
 
-    m_renderParam->CommitResources();
+    m_renderParam->CommitResources(tracker);
 }
 
 HdRprim*
@@ -20,17 +20,34 @@
 #include "renderParam.h"
 
 #include "config.h"
+#include "geometryCache.h"
 #include "renderBuffer.h"
 #include "renderDelegate.h"
+#include "tileWriter.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
 #include <memory>
+#include <unordered_set>
+
+#ifndef _WIN32
+#    include <sys/resource.h>
+#endif
 
 #include <device/device.h>
 #include <render/background.h>
 #include <render/buffers.h>
 #include <render/camera.h>
 #include <render/curves.h>
+#include <render/film.h>
 #include <render/hair.h>
 #include <render/integrator.h>
 #include <render/light.h>
@@ -40,11 +57,21 @@
 #include <render/scene.h>
 #include <render/session.h>
 #include <render/stats.h>
+#include <util/util_guarded_allocator.h>
+#include <util/util_time.h>
 
 #ifdef WITH_CYCLES_LOGGING
 #    include <util/util_logging.h>
 #endif
 
+#include <OpenImageIO/texture.h>
+
+#include <pxr/base/gf/vec4d.h>
+#include <pxr/base/js/json.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/work/threadLimits.h>
+#include <pxr/imaging/hd/perfLog.h>
+
 #ifdef USE_USD_CYCLES_SCHEMA
 #    include <usdCycles/tokens.h>
 #endif
@@ -77,25 +104,309 @@ std::vector<HdCyclesDefaultAov> DefaultAovs = {
 
 };
 
+// clang-format off
+TF_DEFINE_PRIVATE_TOKENS(_tokens,
+    ((cyclesDevice, "cycles:device"))
+    ((cyclesTime_limit, "cycles:time_limit"))
+    ((cyclesDicing_camera_threshold, "cycles:dicing_camera_threshold"))
+    ((cyclesSubdivision_face_budget, "cycles:subdivision_face_budget"))
+    ((cyclesTile_output_file, "cycles:tile_output_file"))
+    ((cyclesBucket_count, "cycles:bucket_count"))
+    ((cyclesBucket_index, "cycles:bucket_index"))
+    (blitTile)
+    (dataWindowNDC)
+);
+// clang-format on
+
+namespace {
+
+// A checkpoint file is this header, the pass types as int32 and the raw
+// accumulated buffer of the frame
+struct _CheckpointHeader {
+    char magic[8];
+    int32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t samples;
+    int32_t numPasses;
+    uint64_t numValues;
+};
+
+const char _kCheckpointMagic[8] = { 'H', 'D', 'C', 'Y', 'C', 'K', 'P', 'T' };
+const int32_t _kCheckpointVersion = 1;
+
+// Reaches the synchronization Cycles keeps protected in its session, the
+// type itself is never constructed
+struct _SessionAccess : ccl::Session {
+    static ccl::thread_mutex& BuffersMutex(ccl::Session* a_session)
+    {
+        return a_session->*(&_SessionAccess::buffers_mutex);
+    }
+
+    static ccl::thread_mutex& ResetMutex(ccl::Session* a_session)
+    {
+        return (a_session->*(&_SessionAccess::delayed_reset)).mutex;
+    }
+
+    static bool ResetPending(ccl::Session* a_session)
+    {
+        return (a_session->*(&_SessionAccess::delayed_reset)).do_reset;
+    }
+};
+
+// Square sample count, squared in 64 bits so large counts clamp to INT_MAX
+int
+_SquareSamples(int a_samples)
+{
+    const int64_t squared = static_cast<int64_t>(a_samples) * a_samples;
+    return static_cast<int>(
+        std::min(squared, static_cast<int64_t>(INT_MAX)));
+}
+
+const HdCyclesDefaultAov*
+_FindDefaultAov(const TfToken& a_aovName)
+{
+    static const std::unordered_map<TfToken, const HdCyclesDefaultAov*,
+                                    TfToken::HashFunctor>
+        aovs = [] {
+            std::unordered_map<TfToken, const HdCyclesDefaultAov*,
+                               TfToken::HashFunctor>
+                result;
+            for (const HdCyclesDefaultAov& aov : DefaultAovs)
+                result.emplace(aov.token, &aov);
+            return result;
+        }();
+
+    auto it = aovs.find(a_aovName);
+    return it != aovs.end() ? it->second : nullptr;
+}
+
+// Enumerating devices initializes the device APIs, which can take seconds
+// for GPUs, so it is done once per process for each device type
+const std::vector<ccl::DeviceInfo>&
+_AvailableDevices(ccl::DeviceTypeMask a_mask)
+{
+    static std::mutex mutex;
+    static std::map<ccl::DeviceTypeMask, std::vector<ccl::DeviceInfo>> devices;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = devices.find(a_mask);
+    if (it == devices.end()) {
+        it = devices.emplace(a_mask, ccl::Device::available_devices(a_mask))
+                 .first;
+    }
+    return it->second;
+}
+
+// Collects the devices selected by a device spec, see SetDeviceType
+bool
+_ParseDeviceSpec(const std::string& a_spec,
+                 std::vector<ccl::DeviceInfo>& a_devices)
+{
+    for (const std::string& term : TfStringTokenize(a_spec, "+")) {
+        const std::string::size_type sep = term.find(':');
+        const std::string typeName       = TfStringTrim(term.substr(0, sep));
+        const std::string selection = (sep == std::string::npos)
+                                          ? ""
+                                          : TfStringTrim(term.substr(sep + 1));
+
+        ccl::DeviceType type = ccl::Device::type_from_string(typeName.c_str());
+        if (type == ccl::DEVICE_NONE) {
+            TF_WARN("Unknown Cycles device type '%s'", typeName.c_str());
+            return false;
+        }
+
+        const std::vector<ccl::DeviceInfo>& available = _AvailableDevices(
+            (ccl::DeviceTypeMask)(1 << type));
+        if (available.empty()) {
+            TF_WARN("No Cycles devices of type '%s' available",
+                    typeName.c_str());
+            return false;
+        }
+
+        std::vector<size_t> indices;
+        if (selection.empty()) {
+            indices.push_back(0);
+        } else if (selection == "*") {
+            for (size_t i = 0; i < available.size(); ++i)
+                indices.push_back(i);
+        } else {
+            for (const std::string& index : TfStringTokenize(selection, ",")) {
+                const size_t i = static_cast<size_t>(
+                    std::max(0, std::atoi(index.c_str())));
+                if (i >= available.size()) {
+                    TF_WARN("Cycles device %s:%zu is not available",
+                            typeName.c_str(), i);
+                    continue;
+                }
+                indices.push_back(i);
+            }
+        }
+
+        for (size_t i : indices) {
+            const ccl::DeviceInfo& info = available[i];
+            bool duplicate = std::any_of(a_devices.begin(), a_devices.end(),
+                                         [&info](const ccl::DeviceInfo& d) {
+                                             return d.id == info.id;
+                                         });
+            if (!duplicate)
+                a_devices.push_back(info);
+        }
+    }
+
+    return !a_devices.empty();
+}
+
+// Drops the hash entry of a shared item, unless the hash already moved on
+// to another item
+template<typename T>
+void
+_UnlistShared(std::unordered_map<size_t, T*>& a_hashes, size_t a_hash,
+              T* a_item)
+{
+    auto it = a_hashes.find(a_hash);
+    if (it != a_hashes.end() && it->second == a_item)
+        a_hashes.erase(it);
+}
+
+// Appends an item and records its slot
+template<typename T, typename Vec>
+void
+_IndexedAdd(Vec& a_items, std::unordered_map<T*, size_t>& a_slots, T* a_item)
+{
+    a_slots[a_item] = a_items.size();
+    a_items.push_back(a_item);
+}
+
+// Removes an item by moving the last item into its slot. Order is not
+// preserved, only for vectors Cycles packs again when they change, e.g.
+// objects, geometry and lights. Items that were not added through
+// _IndexedAdd are only searched for when a_scanUntracked is set.
+template<typename T, typename Vec>
+bool
+_IndexedRemove(Vec& a_items, std::unordered_map<T*, size_t>& a_slots,
+               T* a_item, bool a_scanUntracked = false)
+{
+    size_t slot = a_items.size();
+
+    auto it = a_slots.find(a_item);
+    if (it != a_slots.end()) {
+        slot = it->second;
+        a_slots.erase(it);
+    } else if (!a_scanUntracked) {
+        return false;
+    }
+
+    if (slot >= a_items.size() || a_items[slot] != a_item) {
+        // Untracked or stale slot, the vector was edited elsewhere
+        auto found = std::find(a_items.begin(), a_items.end(), a_item);
+        if (found == a_items.end())
+            return false;
+        slot = found - a_items.begin();
+    }
+
+    T* last       = a_items.back();
+    a_items[slot] = last;
+    a_items.pop_back();
+
+    if (last != a_item) {
+        auto lastIt = a_slots.find(last);
+        if (lastIt != a_slots.end())
+            lastIt->second = slot;
+    }
+
+    return true;
+}
+
+// Removes an item and moves the ones after it down a slot. Shaders use it,
+// their id is their index in scene->shaders, so the later ones are still
+// renumbered and whatever packed their ids has to be updated.
+template<typename T, typename Vec>
+bool
+_OrderedRemove(Vec& a_items, std::unordered_map<T*, size_t>& a_slots,
+               T* a_item)
+{
+    a_slots.erase(a_item);
+
+    auto found = std::find(a_items.begin(), a_items.end(), a_item);
+    if (found == a_items.end())
+        return false;
+
+    const size_t slot = found - a_items.begin();
+    a_items.erase(found);
+
+    for (size_t i = slot; i < a_items.size(); ++i) {
+        auto it = a_slots.find(a_items[i]);
+        if (it != a_slots.end())
+            it->second = i;
+    }
+
+    return true;
+}
+
+template<typename T>
+void
+_DeleteAll(std::vector<T*>& a_items)
+{
+    for (T* item : a_items)
+        delete item;
+    a_items.clear();
+}
+
+}  // namespace
+
 HdCyclesRenderParam::HdCyclesRenderParam()
-    : m_shouldUpdate(false)
+    : m_checkpointInterval(300.0)
+    , m_checkpointTime(0.0)
+    , m_checkpointRead(false)
+    , m_checkpointWidth(0)
+    , m_checkpointHeight(0)
+    , m_checkpointSamples(0)
+    , m_checkpointRestored(false)
+    , m_resumeSample(0)
+    , m_checkpointWrittenSamples(0)
+    , m_defaultRangeStart(0)
+    , m_defaultRangeSamples(-1)
     , m_renderPercent(0)
     , m_renderProgress(0.0f)
-    , m_useSquareSamples(false)
     , m_useTiledRendering(false)
-    , m_cyclesScene(nullptr)
-    , m_cyclesSession(nullptr)
-    , m_objectsUpdated(false)
-    , m_geometryUpdated(false)
-    , m_curveUpdated(false)
-    , m_meshUpdated(false)
-    , m_lightsUpdated(false)
-    , m_shadersUpdated(false)
+    , m_width(0)
+    , m_height(0)
+    , m_sceneChanges(SceneChangeNone)
+    , m_shouldUpdate(false)
+    , m_sessionStarted(false)
+    , m_resetPending(false)
+    , m_navigating(false)
+    , m_navigationTime(0.0)
+    , m_navigationFullSamples(0)
+    , m_dicingThreshold(1.0f)
+    , m_subdivFaceBudget(0)
+    , m_commitTime(0.0)
+    , m_lastCommitTime(0.0)
+    , m_resetTime(0.0)
+    , m_sceneUpdateTime(0.0)
+    , m_createTime(ccl::time_dt())
+    , m_firstSyncTime(0.0)
+    , m_firstPixelTime(0.0)
+    , m_kernelLoadTime(0.0)
+    , m_waitingForFirstSample(false)
+    , m_statsWritten(false)
     , m_numDomeLights(0)
+    , m_defaultBackground(nullptr)
+    , m_emptyBackground(nullptr)
+    , m_renderRegion(0.0f, 0.0f, 1.0f, 1.0f)
+    , m_bucketCount(1)
+    , m_bucketIndex(0)
+    , m_useSquareSamples(false)
+    , m_cyclesSession(nullptr)
+    , m_cyclesScene(nullptr)
 {
     _InitializeDefaults();
 }
 
+HdCyclesRenderParam::~HdCyclesRenderParam() = default;
+
 void
 HdCyclesRenderParam::_InitializeDefaults()
 {
@@ -130,6 +441,18 @@ HdCyclesRenderParam::GetProgress()
 bool
 HdCyclesRenderParam::IsConverged()
 {
+    // The navigation samples are not the final image
+    if (m_navigating)
+        return false;
+
+    // Cycles stops sampling once the time limit is reached, wherever the
+    // sample count is
+    const double timeLimit = m_cyclesSession
+                                 ? m_cyclesSession->params.time_limit
+                                 : 0.0;
+    if (timeLimit > 0.0 && m_renderTime >= timeLimit)
+        return true;
+
     return GetProgress() >= 1.0f;
 }
 
@@ -155,6 +478,34 @@ HdCyclesRenderParam::_SessionUpdateCallback()
 
     m_cyclesSession->progress.get_time(m_totalTime, m_renderTime);
 
+    // - Scene update covers the BVH build and device upload, it ends when
+    // the first sample comes in after a reset
+
+    bool writeStats = false;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+
+        if (m_waitingForFirstSample
+            && m_cyclesSession->progress.get_current_sample() > 0) {
+            m_sceneUpdateTime       = ccl::time_dt() - m_resetTime;
+            m_waitingForFirstSample = false;
+
+            if (m_firstPixelTime == 0.0)
+                m_firstPixelTime = ccl::time_dt() - m_createTime;
+        }
+
+        if (IsConverged() && !m_statsWritten) {
+            writeStats     = true;
+            m_statsWritten = true;
+        }
+    }
+
+    const std::string& statsFile
+        = HdCyclesConfig::GetInstance().render_stats_file;
+    if (writeStats && !statsFile.empty()) {
+        WriteRenderStats(statsFile);
+    }
+
     // - Handle Session status logging
 
     if (HdCyclesConfig::GetInstance().enable_logging) {
@@ -175,6 +526,12 @@ HdCyclesRenderParam::_SessionUpdateCallback()
 bool
 HdCyclesRenderParam::Initialize(HdRenderSettingsMap const& settingsMap)
 {
+    HD_TRACE_FUNCTION();
+
+    // Hydra sends these again through SetRenderSetting
+    for (const auto& entry : settingsMap)
+        m_appliedSettings[entry.first] = entry.second;
+
     // -- Delegate
     _UpdateDelegateFromConfig(true);
     _UpdateDelegateFromRenderSettings(settingsMap);
@@ -219,6 +576,9 @@ HdCyclesRenderParam::Initialize(HdRenderSettingsMap const& settingsMap)
 
     _HandlePasses();
 
+    if (HdCyclesConfig::GetInstance().async_kernel_loading.value)
+        _LoadKernelsAsync();
+
     return true;
 }
 
@@ -234,6 +594,31 @@ HdCyclesRenderParam::_UpdateDelegateFromConfig(bool a_forceInit)
 
     if (m_cyclesSession)
         sessionParams = &m_cyclesSession->params;
+
+    std::string dicingCamera = m_dicingCamera.GetString();
+    if (config.dicing_camera.eval(dicingCamera, a_forceInit))
+        m_dicingCamera = SdfPath(dicingCamera);
+
+    config.dicing_camera_threshold.eval(m_dicingThreshold, a_forceInit);
+    config.subdivision_face_budget.eval(m_subdivFaceBudget, a_forceInit);
+
+    config.tile_output_file.eval(m_tileOutputFile, a_forceInit);
+
+    bool bucketUpdated = config.bucket_count.eval(m_bucketCount, a_forceInit);
+    bucketUpdated |= config.bucket_index.eval(m_bucketIndex, a_forceInit);
+    if (bucketUpdated && m_cyclesSession)
+        _UpdateBufferParams();
+
+    config.checkpoint_file.eval(m_checkpointFile, a_forceInit);
+    config.checkpoint_interval.eval(m_checkpointInterval, a_forceInit);
+
+    // Only read at startup, meshes look their entries up as they sync
+    std::string geometryCacheDir;
+    if (!m_geometryCache
+        && config.geometry_cache_dir.eval(geometryCacheDir, a_forceInit)
+        && !geometryCacheDir.empty()) {
+        m_geometryCache.reset(new HdCyclesGeometryCache(geometryCacheDir));
+    }
 }
 
 void
@@ -251,6 +636,61 @@ bool
 HdCyclesRenderParam::_HandleDelegateRenderSetting(const TfToken& key,
                                                   const VtValue& value)
 {
+    // Only takes effect when the session is created
+    if (key == _tokens->cyclesDevice) {
+        if (value.IsHolding<std::string>()) {
+            m_deviceName = value.UncheckedGet<std::string>();
+        } else if (value.IsHolding<TfToken>()) {
+            m_deviceName = value.UncheckedGet<TfToken>().GetString();
+        }
+        return true;
+    }
+
+    if (key == _tokens->dataWindowNDC) {
+        if (value.IsHolding<GfVec4f>()) {
+            SetRenderRegion(value.UncheckedGet<GfVec4f>());
+        } else if (value.IsHolding<GfVec4d>()) {
+            SetRenderRegion(GfVec4f(value.UncheckedGet<GfVec4d>()));
+        }
+        return true;
+    }
+
+    // Dicing is brought up to date with the next commit
+    if (key == _tokens->cyclesDicing_camera_threshold) {
+        if (value.IsHolding<float>()) {
+            m_dicingThreshold = value.UncheckedGet<float>();
+        } else if (value.IsHolding<double>()) {
+            m_dicingThreshold = (float)value.UncheckedGet<double>();
+        }
+        return true;
+    }
+
+    if (key == _tokens->cyclesSubdivision_face_budget) {
+        m_subdivFaceBudget = _HdCyclesGetVtValue<int>(value,
+                                                      m_subdivFaceBudget);
+        return true;
+    }
+
+    // Picked up by the next frame
+    if (key == _tokens->cyclesTile_output_file) {
+        m_tileOutputFile = _HdCyclesGetVtValue<std::string>(value,
+                                                            m_tileOutputFile);
+        return true;
+    }
+
+    if (key == _tokens->cyclesBucket_count
+        || key == _tokens->cyclesBucket_index) {
+        int& bucket = key == _tokens->cyclesBucket_count ? m_bucketCount
+                                                         : m_bucketIndex;
+        bool bucketUpdated = false;
+        bucket = _HdCyclesGetVtValue<int>(value, bucket, &bucketUpdated);
+        if (bucketUpdated && m_cyclesSession) {
+            _UpdateBufferParams();
+            RequestReset();
+        }
+        return true;
+    }
+
 #ifdef USE_USD_CYCLES_SCHEMA
 
     bool delegate_updated = false;
@@ -261,6 +701,19 @@ HdCyclesRenderParam::_HandleDelegateRenderSetting(const TfToken& key,
                                                        &delegate_updated);
     }
 
+    // The camera prim may not exist yet, it applies itself to the scene
+    // dicing camera when it syncs
+    if (key == usdCyclesTokens->cyclesDicing_camera) {
+        if (value.IsHolding<SdfPath>()) {
+            m_dicingCamera = value.UncheckedGet<SdfPath>();
+        } else if (value.IsHolding<std::string>()) {
+            m_dicingCamera = SdfPath(value.UncheckedGet<std::string>());
+        } else if (value.IsHolding<TfToken>()) {
+            m_dicingCamera = SdfPath(value.UncheckedGet<TfToken>());
+        }
+        return true;
+    }
+
     if (delegate_updated) {
         // Although this is called, it does not correctly reset session in IPR
         //Interrupt();
@@ -297,6 +750,7 @@ HdCyclesRenderParam::_UpdateSessionFromConfig(bool a_forceInit)
     sessionParams->background = false;
 
     config.start_resolution.eval(sessionParams->start_resolution, a_forceInit);
+    config.num_threads.eval(sessionParams->threads, a_forceInit);
 
     sessionParams->progressive                = true;
     sessionParams->progressive_refine         = false;
@@ -317,6 +771,24 @@ HdCyclesRenderParam::_UpdateSessionFromConfig(bool a_forceInit)
     }
 
     config.max_samples.eval(sessionParams->samples, a_forceInit);
+
+    config.adaptive_sampling.eval(sessionParams->adaptive_sampling,
+                                  a_forceInit);
+    config.time_limit.eval(sessionParams->time_limit, a_forceInit);
+
+    // Cycles denoises the display on its render thread whenever it updates
+    // past the start sample, guided by albedo and normal. Tiled renders
+    // write their tiles directly and are left alone.
+    if (!sessionParams->background) {
+        config.interactive_denoising.eval(sessionParams->denoising.use,
+                                          a_forceInit);
+        config.denoising_start_sample.eval(
+            sessionParams->denoising_start_sample, a_forceInit);
+        sessionParams->denoising.input_passes
+            = ccl::DENOISER_INPUT_RGB_ALBEDO_NORMAL;
+    } else {
+        sessionParams->denoising.use = false;
+    }
 }
 
 void
@@ -429,6 +901,12 @@ HdCyclesRenderParam::_HandleSessionRenderSetting(const TfToken& key,
                                         &session_updated);
     }
 
+    if (key == _tokens->cyclesTime_limit) {
+        sessionParams->time_limit = _HdCyclesGetVtValue<float>(
+            value, static_cast<float>(sessionParams->time_limit),
+            &session_updated);
+    }
+
     if (key == usdCyclesTokens->cyclesUse_profiling) {
         sessionParams->use_profiling
             = _HdCyclesGetVtValue<bool>(value, sessionParams->use_profiling,
@@ -466,7 +944,7 @@ HdCyclesRenderParam::_HandleSessionRenderSetting(const TfToken& key,
     // Denoising
 
     bool denoising_updated = false;
-    ccl::DenoiseParams denoisingParams;
+    ccl::DenoiseParams denoisingParams = sessionParams->denoising;
 
     if (key == usdCyclesTokens->cyclesRun_denoising) {
         denoisingParams.use = _HdCyclesGetVtValue<int>(value,
@@ -525,6 +1003,14 @@ HdCyclesRenderParam::_UpdateSceneFromConfig(bool a_forceInit)
     sceneParams->persistent_data = true;
 
     config.curve_subdivisions.eval(sceneParams->hair_subdivisions, a_forceInit);
+
+    // Cycles downscales textures past the limit as they are loaded, so
+    // finals don't need every UDIM resident at full resolution
+    if (sessionParams->background) {
+        config.texture_limit.eval(sceneParams->texture_limit, a_forceInit);
+    } else {
+        config.ipr_texture_limit.eval(sceneParams->texture_limit, a_forceInit);
+    }
 }
 
 void
@@ -580,14 +1066,6 @@ HdCyclesRenderParam::_HandleSceneRenderSetting(const TfToken& key,
                                        &scene_updated);
     }
 
-    // TODO: Unsure how we will handle this if the camera hasn't been created yet/at all...
-    /*if (key == usdCyclesTokens->cyclesDicing_camera) {
-        scene->dicing_camera
-            = _HdCyclesGetVtValue<std::string>(value, scene->dicing_camera,
-                                       &scene_updated);
-    }*/
-
-
     if (key == usdCyclesTokens->cyclesUse_bvh_spatial_split) {
         sceneParams->use_bvh_spatial_split = _HdCyclesGetVtValue<bool>(
             value, sceneParams->use_bvh_spatial_split, &scene_updated);
@@ -605,9 +1083,14 @@ HdCyclesRenderParam::_HandleSceneRenderSetting(const TfToken& key,
     }
 
     if (scene_updated) {
-        // Although this is called, it does not correctly reset session in IPR
-        if (m_cyclesSession && m_cyclesScene)
-            Interrupt(true);
+        if (key == usdCyclesTokens->cyclesBvh_type
+            || key == usdCyclesTokens->cyclesUse_bvh_spatial_split
+            || key == usdCyclesTokens->cyclesUse_bvh_unaligned_nodes
+            || key == usdCyclesTokens->cyclesNum_bvh_time_steps) {
+            TagSceneChange(SceneChangeBvh);
+        }
+
+        // The commit applying the setting resets the session
         return true;
     }
 
@@ -673,13 +1156,18 @@ HdCyclesRenderParam::_UpdateIntegratorFromConfig(bool a_forceInit)
         integrator->volume_samples = integrator->volume_samples
                                      * integrator->volume_samples;
     }
-    /*if (config.adaptive_min_samples.eval(integrator->adaptive_min_samples)
-        && m_useSquareSamples) {
-        integrator->adaptive_min_samples
-            = std::min(integrator->adaptive_min_samples
-                           * integrator->adaptive_min_samples,
-                       INT_MAX);
-    }*/
+    if (config.adaptive_min_samples.eval(integrator->adaptive_min_samples,
+                                         a_forceInit)) {
+        // Cycles derives the min samples from the sample count at INT_MAX
+        if (integrator->adaptive_min_samples <= 0) {
+            integrator->adaptive_min_samples = INT_MAX;
+        } else if (m_useSquareSamples) {
+            integrator->adaptive_min_samples = _SquareSamples(
+                integrator->adaptive_min_samples);
+        }
+    }
+    config.adaptive_threshold.eval(integrator->adaptive_threshold,
+                                   a_forceInit);
 
     config.enable_motion_blur.eval(integrator->motion_blur, a_forceInit);
 
@@ -830,10 +1318,8 @@ HdCyclesRenderParam::_HandleIntegratorRenderSetting(const TfToken& key,
 
         if (sample_updated) {
             if (m_useSquareSamples) {
-                integrator->adaptive_min_samples
-                    = std::min(integrator->adaptive_min_samples
-                                   * integrator->adaptive_min_samples,
-                               INT_MAX);
+                integrator->adaptive_min_samples = _SquareSamples(
+                    integrator->adaptive_min_samples);
             }
             integrator_updated = true;
         }
@@ -1191,10 +1677,20 @@ HdCyclesRenderParam::_HandleBackgroundRenderSetting(const TfToken& key,
 
     // Visibility
 
-    bool visCamera, visDiffuse, visGlossy, visTransmission, visScatter;
-    visCamera = visDiffuse = visGlossy = visTransmission = visScatter = true;
+    // Each key only sets its own ray type
+    const unsigned int visMask = ccl::PATH_RAY_CAMERA | ccl::PATH_RAY_DIFFUSE
+                                 | ccl::PATH_RAY_GLOSSY
+                                 | ccl::PATH_RAY_TRANSMIT
+                                 | ccl::PATH_RAY_VOLUME_SCATTER;
+
+    const unsigned int vis = background->visibility;
+    bool visCamera         = vis & ccl::PATH_RAY_CAMERA;
+    bool visDiffuse        = vis & ccl::PATH_RAY_DIFFUSE;
+    bool visGlossy         = vis & ccl::PATH_RAY_GLOSSY;
+    bool visTransmission   = vis & ccl::PATH_RAY_TRANSMIT;
+    bool visScatter        = vis & ccl::PATH_RAY_VOLUME_SCATTER;
 
-    unsigned int visFlags = 0;
+    unsigned int visFlags = vis & ~visMask;
 
     if (key == usdCyclesTokens->cyclesBackgroundVisibilityCamera) {
         visCamera = _HdCyclesGetVtValue<bool>(value, visCamera,
@@ -1267,134 +1763,783 @@ HdCyclesRenderParam::_HandleBackgroundRenderSetting(const TfToken& key,
     return false;
 }
 
+void
+HdCyclesRenderParam::_SelectDenoiser(ccl::SessionParams& a_params)
+{
+    if (!a_params.denoising.use)
+        return;
+
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+    const std::string denoiser = TfStringToUpper(config.denoiser.value);
+
+    const bool hasOptix = a_params.device.denoisers & ccl::DENOISER_OPTIX;
+
+    a_params.denoising.type = ccl::DENOISER_OPENIMAGEDENOISE;
+    if (denoiser == "OPTIX" || (denoiser.empty() && hasOptix))
+        a_params.denoising.type = ccl::DENOISER_OPTIX;
+
+    if (!(a_params.device.denoisers & a_params.denoising.type)) {
+        TF_WARN("Denoiser %s is not supported by device %s, interactive "
+                "denoising is disabled",
+                denoiser.empty() ? "OIDN" : denoiser.c_str(),
+                a_params.device.description.c_str());
+        a_params.denoising.use = false;
+    }
+}
+
+void
+HdCyclesRenderParam::_HandleAdaptiveSampling()
+{
+    const bool adaptive = m_cyclesSession->params.adaptive_sampling;
+
+    ccl::Film* film = m_cyclesScene->film;
+    if (film->use_adaptive_sampling != adaptive) {
+        film->use_adaptive_sampling = adaptive;
+        film->tag_update(m_cyclesScene);
+    }
+
+    // The adaptive filter is only supported by the progressive multi-jitter
+    // pattern
+    ccl::Integrator* integrator = m_cyclesScene->integrator;
+    if (adaptive
+        && integrator->sampling_pattern != ccl::SAMPLING_PATTERN_PMJ) {
+        integrator->sampling_pattern = ccl::SAMPLING_PATTERN_PMJ;
+        integrator->tag_update(m_cyclesScene);
+    }
+}
+
 void
 HdCyclesRenderParam::_HandlePasses()
 {
     // TODO: These might need to live elsewhere when we fully implement aovs/passes
     m_bufferParams.passes.clear();
 
+    _HandleAdaptiveSampling();
+
+    // Albedo and normal guides of the display denoiser
+    const bool denoise = m_cyclesSession->params.denoising.use;
+    m_bufferParams.denoising_data_pass = denoise;
+    if (m_cyclesScene->film->denoising_data_pass != denoise) {
+        m_cyclesScene->film->denoising_data_pass = denoise;
+        m_cyclesScene->film->tag_update(m_cyclesScene);
+    }
+
     if (m_useTiledRendering) {
+        static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+
+        const std::vector<ccl::PassType> bound = _GetBoundAovPasses();
+
+        // Combined always comes first
         for (HdCyclesDefaultAov& aov : DefaultAovs) {
+            if (aov.type != ccl::PASS_COMBINED && !config.all_aov_passes.value
+                && std::find(bound.begin(), bound.end(), aov.type)
+                       == bound.end()) {
+                continue;
+            }
             ccl::Pass::add(aov.type, m_bufferParams.passes, aov.name.c_str());
         }
     } else {
         ccl::Pass::add(ccl::PASS_COMBINED, m_bufferParams.passes, "Combined");
     }
 
+    // Per pixel convergence state of the adaptive sampler
+    if (m_cyclesSession->params.adaptive_sampling) {
+        ccl::Pass::add(ccl::PASS_ADAPTIVE_AUX_BUFFER, m_bufferParams.passes);
+        ccl::Pass::add(ccl::PASS_SAMPLE_COUNT, m_bufferParams.passes);
+    }
+
     m_cyclesScene->film->tag_passes_update(m_cyclesScene,
                                            m_bufferParams.passes);
-}
 
-bool
-HdCyclesRenderParam::SetRenderSetting(const TfToken& key, const VtValue& value)
-{
-    // This has some inherent performance overheads (runs multiple times, unecessary)
-    // however for now, this works the most clearly due to Cycles restrictions
-#ifdef USE_USD_CYCLES_SCHEMA
-    _HandleSessionRenderSetting(key, value);
-    _HandleSceneRenderSetting(key, value);
-    _HandleIntegratorRenderSetting(key, value);
-    _HandleFilmRenderSetting(key, value);
-    _HandleBackgroundRenderSetting(key, value);
-#endif
-    return false;
+    _ResolveAovPassBindings();
 }
 
-bool
-HdCyclesRenderParam::_CreateSession()
+void
+HdCyclesRenderParam::_ResolveAovPassBindings()
 {
-    bool foundDevice = SetDeviceType(m_deviceName, m_sessionParams);
-
-    if (!foundDevice)
-        return false;
+    auto bindings = std::make_shared<AovPassBindings>();
 
-    m_cyclesSession = new ccl::Session(m_sessionParams);
+    for (auto& aov : m_aovs) {
+        auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
+        if (!rb) {
+            continue;
+        }
 
-    m_cyclesSession->write_render_tile_cb
-        = std::bind(&HdCyclesRenderParam::_WriteRenderTile, this, ccl::_1);
-    m_cyclesSession->update_render_tile_cb
-        = std::bind(&HdCyclesRenderParam::_UpdateRenderTile, this, ccl::_1,
-                    ccl::_2);
+        const HdCyclesDefaultAov* cyclesAov = _FindDefaultAov(aov.aovName);
+        if (cyclesAov) {
+            bindings->push_back(
+                { rb, cyclesAov->name, cyclesAov->format,
+                  static_cast<int>(HdGetComponentCount(cyclesAov->format)) });
+        }
+    }
 
-    m_cyclesSession->progress.set_update_callback(
-        std::bind(&HdCyclesRenderParam::_SessionUpdateCallback, this));
+    std::atomic_store(&m_aovPassBindings,
+                      std::shared_ptr<const AovPassBindings>(
+                          std::move(bindings)));
+}
 
-    return true;
+std::vector<ccl::PassType>
+HdCyclesRenderParam::_GetBoundAovPasses() const
+{
+    std::vector<ccl::PassType> passes;
+    for (const HdCyclesDefaultAov& cyclesAov : DefaultAovs) {
+        for (const HdRenderPassAovBinding& aov : m_aovs) {
+            if (aov.aovName == cyclesAov.token) {
+                passes.push_back(cyclesAov.type);
+                break;
+            }
+        }
+    }
+    return passes;
 }
 
 void
-HdCyclesRenderParam::_WriteRenderTile(ccl::RenderTile& rtile)
+HdCyclesRenderParam::SetAovBindings(HdRenderPassAovBindingVector const& a_aovs)
 {
-    // No session, exit out
-    if (!m_cyclesSession)
-        return;
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
 
-    if (!m_useTiledRendering)
-        return;
+    // Every pass is resident unless only the bound ones are rendered, then
+    // the view only changes which pass is read back
+    const bool rebuild = m_useTiledRendering && !config.all_aov_passes.value
+                         && m_cyclesSession && m_cyclesScene;
 
-    const int x = rtile.x;
-    const int y = rtile.y;
-    const int w = rtile.w;
-    const int h = rtile.h;
+    std::vector<ccl::PassType> bound;
+    if (rebuild)
+        bound = _GetBoundAovPasses();
 
-    ccl::RenderBuffers* buffers = rtile.buffers;
+    m_aovs = a_aovs;
 
-    // copy data from device
-    if (!buffers->copy_from_device())
-        return;
+    if (rebuild && _GetBoundAovPasses() != bound) {
+        m_cyclesScene->mutex.lock();
+        _HandlePasses();
+        m_cyclesScene->mutex.unlock();
 
-    // Adjust absolute sample number to the range.
-    int sample = rtile.sample;
-    const int range_start_sample
-        = m_cyclesSession->tile_manager.range_start_sample;
-    if (range_start_sample != -1) {
-        sample -= range_start_sample;
+        RequestReset();
+        return;
     }
 
-    const float exposure = m_cyclesScene->film->exposure;
+    _ResolveAovPassBindings();
+}
 
-    if (!m_aovs.empty()) {
-        // Blit from the framebuffer to currently selected aovs...
-        for (auto& aov : m_aovs) {
-            if (!TF_VERIFY(aov.renderBuffer != nullptr)) {
-                continue;
-            }
+bool
+HdCyclesRenderParam::SetRenderSetting(const TfToken& key, const VtValue& value)
+{
+    // Solaris sends the whole settings map on every edit
+    std::lock_guard<std::mutex> lock(m_settingsMutex);
 
-            auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
+    auto applied = m_appliedSettings.find(key);
+    if (applied != m_appliedSettings.end() && applied->second == value) {
+        m_pendingSettings.erase(key);
+        return false;
+    }
 
-            if (rb == nullptr) {
-                continue;
-            }
+    m_pendingSettings[key] = value;
+    return true;
+}
 
-            if (rb->GetFormat() == HdFormatInvalid) {
-                continue;
+bool
+HdCyclesRenderParam::_ApplyRenderSetting(const TfToken& key,
+                                         const VtValue& value)
+{
+    using Handler = bool (HdCyclesRenderParam::*)(const TfToken&,
+                                                  const VtValue&);
+
+    static const std::pair<RenderSettingHandler, Handler> handlers[] = {
+        { HandlerDelegate, &HdCyclesRenderParam::_HandleDelegateRenderSetting },
+#ifdef USE_USD_CYCLES_SCHEMA
+        { HandlerSession, &HdCyclesRenderParam::_HandleSessionRenderSetting },
+        { HandlerScene, &HdCyclesRenderParam::_HandleSceneRenderSetting },
+        { HandlerIntegrator,
+          &HdCyclesRenderParam::_HandleIntegratorRenderSetting },
+        { HandlerFilm, &HdCyclesRenderParam::_HandleFilmRenderSetting },
+        { HandlerBackground,
+          &HdCyclesRenderParam::_HandleBackgroundRenderSetting },
+#endif
+    };
+
+    // Every key a handler compares against, some keys are handled by
+    // several of them, e.g. the shading system
+    using KeyHandlers = std::unordered_map<TfToken, int, TfToken::HashFunctor>;
+    static const KeyHandlers keyHandlers = [] {
+        KeyHandlers keys;
+        auto add = [&keys](int a_handler,
+                           std::initializer_list<TfToken> a_keys) {
+            for (const TfToken& key : a_keys)
+                keys[key] |= a_handler;
+        };
+
+        add(HandlerDelegate,
+            {
+                _tokens->cyclesDevice,
+                _tokens->dataWindowNDC,
+                _tokens->cyclesDicing_camera_threshold,
+                _tokens->cyclesSubdivision_face_budget,
+                _tokens->cyclesTile_output_file,
+                _tokens->cyclesBucket_count,
+                _tokens->cyclesBucket_index
+            });
+#ifdef USE_USD_CYCLES_SCHEMA
+        add(HandlerDelegate,
+            {
+                usdCyclesTokens->cyclesUse_square_samples,
+                usdCyclesTokens->cyclesDicing_camera
+            });
+        add(HandlerSession,
+            {
+                usdCyclesTokens->cyclesProgressive_refine,
+                usdCyclesTokens->cyclesProgressive,
+                usdCyclesTokens->cyclesProgressive_update_timeout,
+                usdCyclesTokens->cyclesExperimental,
+                usdCyclesTokens->cyclesSamples,
+                usdCyclesTokens->cyclesTile_size,
+                usdCyclesTokens->cyclesTile_order,
+                usdCyclesTokens->cyclesStart_resolution,
+                usdCyclesTokens->cyclesPixel_size,
+                usdCyclesTokens->cyclesThreads,
+                usdCyclesTokens->cyclesAdaptive_sampling,
+                _tokens->cyclesTime_limit,
+                usdCyclesTokens->cyclesUse_profiling,
+                usdCyclesTokens->cyclesDisplay_buffer_linear,
+                usdCyclesTokens->cyclesShading_system,
+                usdCyclesTokens->cyclesRun_denoising,
+                usdCyclesTokens->cyclesDenoising_start_sample
+            });
+        add(HandlerScene,
+            {
+                usdCyclesTokens->cyclesShading_system,
+                usdCyclesTokens->cyclesBvh_type,
+                usdCyclesTokens->cyclesCurve_subdivisions,
+                usdCyclesTokens->cyclesUse_bvh_spatial_split,
+                usdCyclesTokens->cyclesUse_bvh_unaligned_nodes,
+                usdCyclesTokens->cyclesNum_bvh_time_steps
+            });
+        add(HandlerIntegrator,
+            {
+                usdCyclesTokens->cyclesIntegratorSeed,
+                usdCyclesTokens->cyclesIntegratorMin_bounce,
+                usdCyclesTokens->cyclesIntegratorMax_bounce,
+                usdCyclesTokens->cyclesIntegratorMethod,
+                usdCyclesTokens->cyclesIntegratorSampling_method,
+                usdCyclesTokens->cyclesIntegratorMax_diffuse_bounce,
+                usdCyclesTokens->cyclesIntegratorMax_glossy_bounce,
+                usdCyclesTokens->cyclesIntegratorMax_transmission_bounce,
+                usdCyclesTokens->cyclesIntegratorMax_volume_bounce,
+                usdCyclesTokens->cyclesIntegratorTransparent_min_bounce,
+                usdCyclesTokens->cyclesIntegratorTransparent_max_bounce,
+                usdCyclesTokens->cyclesIntegratorAo_bounces,
+                usdCyclesTokens->cyclesIntegratorVolume_max_steps,
+                usdCyclesTokens->cyclesIntegratorVolume_step_size,
+                usdCyclesTokens->cyclesIntegratorAdaptive_threshold,
+                usdCyclesTokens->cyclesIntegratorAa_samples,
+                usdCyclesTokens->cyclesIntegratorAdaptive_min_samples,
+                usdCyclesTokens->cyclesIntegratorDiffuse_samples,
+                usdCyclesTokens->cyclesIntegratorGlossy_samples,
+                usdCyclesTokens->cyclesIntegratorTransmission_samples,
+                usdCyclesTokens->cyclesIntegratorAo_samples,
+                usdCyclesTokens->cyclesIntegratorMesh_light_samples,
+                usdCyclesTokens->cyclesIntegratorSubsurface_samples,
+                usdCyclesTokens->cyclesIntegratorVolume_samples,
+                usdCyclesTokens->cyclesIntegratorStart_sample,
+                usdCyclesTokens->cyclesIntegratorCaustics_reflective,
+                usdCyclesTokens->cyclesIntegratorCaustics_refractive,
+                usdCyclesTokens->cyclesIntegratorFilter_glossy,
+                usdCyclesTokens->cyclesIntegratorSample_clamp_direct,
+                usdCyclesTokens->cyclesIntegratorSample_clamp_indirect,
+                usdCyclesTokens->cyclesIntegratorMotion_blur,
+                usdCyclesTokens->cyclesIntegratorSample_all_lights_direct,
+                usdCyclesTokens->cyclesIntegratorSample_all_lights_indirect,
+                usdCyclesTokens->cyclesIntegratorLight_sampling_threshold
+            });
+        add(HandlerFilm,
+            {
+                usdCyclesTokens->cyclesFilmExposure,
+                usdCyclesTokens->cyclesFilmPass_alpha_threshold,
+                usdCyclesTokens->cyclesFilmFilter_type,
+                usdCyclesTokens->cyclesFilmFilter_width,
+                usdCyclesTokens->cyclesFilmMist_start,
+                usdCyclesTokens->cyclesFilmMist_depth,
+                usdCyclesTokens->cyclesFilmMist_falloff,
+                usdCyclesTokens->cyclesFilmUse_light_visibility,
+                usdCyclesTokens->cyclesFilmUse_adaptive_sampling
+            });
+        add(HandlerBackground,
+            {
+                usdCyclesTokens->cyclesBackgroundAo_factor,
+                usdCyclesTokens->cyclesBackgroundAo_distance,
+                usdCyclesTokens->cyclesBackgroundUse_shader,
+                usdCyclesTokens->cyclesBackgroundUse_ao,
+                usdCyclesTokens->cyclesBackgroundVisibilityCamera,
+                usdCyclesTokens->cyclesBackgroundVisibilityDiffuse,
+                usdCyclesTokens->cyclesBackgroundVisibilityGlossy,
+                usdCyclesTokens->cyclesBackgroundVisibilityTransmission,
+                usdCyclesTokens->cyclesBackgroundVisibilityScatter,
+                usdCyclesTokens->cyclesBackgroundTransparent,
+                usdCyclesTokens->cyclesBackgroundTransparent_glass,
+                usdCyclesTokens->cyclesBackgroundTransparent_roughness_threshold,
+                usdCyclesTokens->cyclesBackgroundVolume_step_size
+            });
+#endif
+        return keys;
+    }();
+
+    auto found = keyHandlers.find(key);
+    if (found == keyHandlers.end())
+        return false;
+
+    bool applied = false;
+    for (const auto& handler : handlers) {
+        if (found->second & handler.first)
+            applied |= (this->*handler.second)(key, value);
+    }
+    return applied;
+}
+
+bool
+HdCyclesRenderParam::_ApplyPendingRenderSettings()
+{
+    HD_TRACE_FUNCTION();
+
+    std::map<TfToken, VtValue> settings;
+    {
+        std::lock_guard<std::mutex> lock(m_settingsMutex);
+        settings.swap(m_pendingSettings);
+
+        for (const auto& entry : settings)
+            m_appliedSettings[entry.first] = entry.second;
+    }
+
+    if (settings.empty() || !m_cyclesSession || !m_cyclesScene)
+        return false;
+
+    const bool adaptive = m_cyclesSession->params.adaptive_sampling;
+
+    bool applied = false;
+
+    m_cyclesScene->mutex.lock();
+
+    for (const auto& entry : settings)
+        applied |= _ApplyRenderSetting(entry.first, entry.second);
+
+    // Toggling adaptive sampling adds or removes its passes
+    if (m_cyclesSession->params.adaptive_sampling != adaptive)
+        _HandlePasses();
+
+    m_cyclesScene->mutex.unlock();
+
+    return applied;
+}
+
+bool
+HdCyclesRenderParam::_CreateSession()
+{
+    HD_TRACE_FUNCTION();
+
+    bool foundDevice = SetDeviceType(m_deviceName, m_sessionParams);
+
+    if (!foundDevice)
+        return false;
+
+    _SelectDenoiser(m_sessionParams);
+
+    // Cycles runs its own task scheduler next to the TBB pool prims sync
+    // with. Without an explicit thread count it gets the budget of the host,
+    // so a limit set with PXR_WORK_THREAD_LIMIT or by the application holds
+    // for rendering too. Renders pause on the first edit of a sync and
+    // resume with the reset of the commit, so both pools don't run at once.
+    if (m_sessionParams.threads <= 0)
+        m_sessionParams.threads = static_cast<int>(WorkGetConcurrencyLimit());
+
+    m_cyclesSession = new ccl::Session(m_sessionParams);
+
+    m_defaultRangeStart   = m_cyclesSession->tile_manager.range_start_sample;
+    m_defaultRangeSamples = m_cyclesSession->tile_manager.range_num_samples;
+
+    m_cyclesSession->write_render_tile_cb
+        = std::bind(&HdCyclesRenderParam::_WriteRenderTile, this, ccl::_1,
+                    true);
+    m_cyclesSession->update_render_tile_cb
+        = std::bind(&HdCyclesRenderParam::_UpdateRenderTile, this, ccl::_1,
+                    ccl::_2);
+
+    m_cyclesSession->progress.set_update_callback(
+        std::bind(&HdCyclesRenderParam::_SessionUpdateCallback, this));
+
+    return true;
+}
+
+void
+HdCyclesRenderParam::_LoadKernelsAsync()
+{
+    // The requested features are read from the shader graphs, which
+    // materials and lights replace while they sync, so the scene stays
+    // locked. Prims keep syncing until they need the lock to commit. The
+    // session thread loads them again if the scene requests other kernel
+    // features.
+    m_kernelThread = std::thread([this]() {
+        HD_TRACE_SCOPE("LoadKernels");
+
+        const double start = ccl::time_dt();
+        m_cyclesSession->load_kernels(true);
+
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_kernelLoadTime = ccl::time_dt() - start;
+    });
+}
+
+void
+HdCyclesRenderParam::_WaitForKernels()
+{
+    HD_TRACE_FUNCTION();
+
+    if (m_kernelThread.joinable())
+        m_kernelThread.join();
+}
+
+void
+HdCyclesRenderParam::_OpenTileOutput()
+{
+    if (!m_useTiledRendering || m_tileOutputFile.empty())
+        return;
+
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+
+    // The passes of the frame under their DefaultAovs names
+    std::vector<HdCyclesTileWriter::Pass> passes;
+    for (const HdCyclesDefaultAov& aov : DefaultAovs) {
+        for (const ccl::Pass& pass : m_bufferParams.passes) {
+            if (pass.type == aov.type) {
+                passes.push_back(
+                    { aov.name,
+                      static_cast<int>(HdGetComponentCount(aov.format)) });
+                break;
             }
+        }
+    }
+
+    if (!m_tileWriter)
+        m_tileWriter.reset(new HdCyclesTileWriter());
+
+    m_tileWriter->Open(m_tileOutputFile, m_bufferParams,
+                       m_cyclesSession->params.tile_size, passes,
+                       config.tile_output_compression.value);
+}
+
+void
+HdCyclesRenderParam::_PrepareCheckpointResume()
+{
+    if (m_checkpointFile.empty() || m_useTiledRendering || !m_cyclesSession)
+        return;
 
-            for (HdCyclesDefaultAov& cyclesAov : DefaultAovs) {
-                if (aov.aovName == cyclesAov.token) {
-                    rb->SetConverged(IsConverged());
+    ccl::TileManager& tiles    = m_cyclesSession->tile_manager;
+    tiles.range_start_sample   = m_defaultRangeStart;
+    tiles.range_num_samples    = m_defaultRangeSamples;
+    m_resumeSample             = 0;
+    m_checkpointWrittenSamples = 0;
+    m_checkpointTime           = ccl::time_dt();
+
+    // A reset after resuming is an edit, the frame starts over
+    if (m_checkpointRestored) {
+        m_checkpointData    = std::vector<float>();
+        m_checkpointSamples = 0;
+        return;
+    }
 
-                    // Pixels we will use to get from cycles.
-                    int numComponents = HdGetComponentCount(cyclesAov.format);
+    if (!m_checkpointRead) {
+        m_checkpointRead = true;
+        _ReadCheckpoint();
+    }
 
-                    ccl::vector<float> tileData(w * h * numComponents);
+    if (m_checkpointSamples <= 0)
+        return;
 
-                    bool read = buffers->get_pass_rect(cyclesAov.name.c_str(),
-                                                       exposure, sample,
-                                                       numComponents,
-                                                       &tileData[0]);
+    // Resets before the viewport or the passes are set don't match yet
+    std::vector<int> passes;
+    for (const ccl::Pass& pass : m_bufferParams.passes)
+        passes.push_back(static_cast<int>(pass.type));
 
-                    if (!read) {
-                        memset(&tileData[0], 0,
-                               tileData.size() * sizeof(float));
-                    }
+    if (m_checkpointWidth != m_bufferParams.width
+        || m_checkpointHeight != m_bufferParams.height
+        || m_checkpointPasses != passes)
+        return;
 
-                    rb->BlitTile(cyclesAov.format, rtile.x, rtile.y, rtile.w,
-                                 rtile.h, 0, rtile.w,
-                                 reinterpret_cast<uint8_t*>(tileData.data()));
-                }
+    // The resumed samples are added on top of the first rendered one
+    const int samples = m_cyclesSession->params.samples;
+    if (m_checkpointSamples >= samples) {
+        TF_WARN("Checkpoint '%s' already has %d of %d samples, rendering "
+                "the frame again",
+                m_checkpointFile.c_str(), m_checkpointSamples, samples);
+        m_checkpointSamples = 0;
+        return;
+    }
+
+    tiles.range_start_sample = m_checkpointSamples;
+    tiles.range_num_samples  = samples - m_checkpointSamples;
+    m_resumeSample           = m_checkpointSamples;
+}
+
+void
+HdCyclesRenderParam::_UpdateCheckpoint(bool a_final)
+{
+    if (m_checkpointFile.empty() || m_useTiledRendering || !m_sessionStarted
+        || !m_cyclesSession->buffers)
+        return;
+
+    const bool restore = m_resumeSample > 0 && !m_checkpointRestored;
+
+    if (restore) {
+        if (a_final)
+            return;
+    } else if (!a_final
+               && (m_checkpointWrittenSamples >= m_cyclesSession->params.samples
+                   || (!IsConverged()
+                       && ccl::time_dt() - m_checkpointTime
+                              < m_checkpointInterval))) {
+        return;
+    }
+
+    // Locked in the order of the session thread between two samples. No
+    // sample starts while the buffers are locked, and the device wait lets
+    // the one being rendered finish, so no kernel accumulates into them
+    ccl::thread_scoped_lock resetLock(
+        _SessionAccess::ResetMutex(m_cyclesSession));
+    ccl::thread_scoped_lock buffersLock(
+        _SessionAccess::BuffersMutex(m_cyclesSession));
+    m_cyclesSession->device->task_wait();
+
+    // The pending reset clears the buffers
+    if (_SessionAccess::ResetPending(m_cyclesSession))
+        return;
+
+    // Samples in the buffers counting the resumed ones, every tile of the
+    // frame finished the last one
+    const int samples = m_cyclesSession->progress.get_current_sample();
+
+    // Cycles clears the buffers when the range starts at each preview
+    // resolution, the resumed samples are added once it rendered the full one
+    const ccl::TileManager& tiles = m_cyclesSession->tile_manager;
+    if (restore
+        && tiles.state.resolution_divider > m_cyclesSession->params.pixel_size)
+        return;
+
+    if (restore && samples > m_resumeSample) {
+        HD_TRACE_SCOPE("RestoreCheckpoint");
+
+        ccl::RenderBuffers* buffers = m_cyclesSession->buffers;
+        if (buffers->copy_from_device()) {
+            ccl::device_vector<float>& buffer = buffers->buffer;
+            if (buffer.size() == m_checkpointData.size()) {
+                float* data = buffer.data();
+                for (size_t i = 0; i < m_checkpointData.size(); ++i)
+                    data[i] += m_checkpointData[i];
+                buffer.copy_to_device();
+            } else {
+                TF_WARN("Checkpoint '%s' doesn't match the render buffers",
+                        m_checkpointFile.c_str());
             }
+
+            m_checkpointRestored = true;
+            m_checkpointData     = std::vector<float>();
+            m_checkpointTime     = ccl::time_dt();
+        }
+    } else if (!restore && samples > m_checkpointWrittenSamples) {
+        // The last checkpoint is written when the render stops, e.g. at the
+        // time limit, so a later render can continue it
+        if (_WriteCheckpoint(samples))
+            m_checkpointWrittenSamples = samples;
+        m_checkpointTime = ccl::time_dt();
+    }
+}
+
+bool
+HdCyclesRenderParam::_ReadCheckpoint()
+{
+    HD_TRACE_FUNCTION();
+
+    std::ifstream file(m_checkpointFile, std::ios::binary);
+    if (!file)
+        return false;
+
+    _CheckpointHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file
+        || std::memcmp(header.magic, _kCheckpointMagic, sizeof(header.magic))
+               != 0
+        || header.version != _kCheckpointVersion || header.numPasses < 0) {
+        TF_WARN("Ignoring checkpoint '%s', it is not a valid checkpoint",
+                m_checkpointFile.c_str());
+        return false;
+    }
+
+    // The sizes of the header are checked against the file before they are
+    // allocated, every pixel holds at least one value per pass
+    const std::streamoff dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(dataStart);
+
+    const uint64_t pixels = header.width > 0 && header.height > 0
+                                ? static_cast<uint64_t>(header.width)
+                                      * static_cast<uint64_t>(header.height)
+                                : 0;
+    const uint64_t passBytes = static_cast<uint64_t>(header.numPasses)
+                               * sizeof(int32_t);
+    if (!file || pixels == 0 || header.samples < 0 || header.numPasses == 0
+        || header.numValues % pixels != 0
+        || header.numValues / pixels < static_cast<uint64_t>(header.numPasses)
+        || header.numValues > fileSize / sizeof(float)
+        || fileSize
+               != sizeof(header) + passBytes
+                      + header.numValues * sizeof(float)) {
+        TF_WARN("Ignoring checkpoint '%s', its size doesn't match its header",
+                m_checkpointFile.c_str());
+        return false;
+    }
+
+    std::vector<int32_t> passes(header.numPasses);
+    std::vector<float> data(header.numValues);
+    file.read(reinterpret_cast<char*>(passes.data()),
+              passes.size() * sizeof(int32_t));
+    file.read(reinterpret_cast<char*>(data.data()),
+              data.size() * sizeof(float));
+    if (!file) {
+        TF_WARN("Ignoring checkpoint '%s', it is truncated",
+                m_checkpointFile.c_str());
+        return false;
+    }
+
+    m_checkpointPasses.assign(passes.begin(), passes.end());
+    m_checkpointData    = std::move(data);
+    m_checkpointWidth   = header.width;
+    m_checkpointHeight  = header.height;
+    m_checkpointSamples = header.samples;
+
+    return true;
+}
+
+bool
+HdCyclesRenderParam::_WriteCheckpoint(int a_samples)
+{
+    HD_TRACE_FUNCTION();
+
+    ccl::RenderBuffers* buffers = m_cyclesSession->buffers;
+    if (!buffers->copy_from_device())
+        return false;
+
+    const ccl::BufferParams& params         = buffers->params;
+    const ccl::device_vector<float>& buffer = buffers->buffer;
+
+    std::vector<int32_t> passes;
+    for (const ccl::Pass& pass : params.passes)
+        passes.push_back(static_cast<int32_t>(pass.type));
+
+    _CheckpointHeader header;
+    std::memcpy(header.magic, _kCheckpointMagic, sizeof(header.magic));
+    header.version   = _kCheckpointVersion;
+    header.width     = params.width;
+    header.height    = params.height;
+    header.samples   = a_samples;
+    header.numPasses = static_cast<int32_t>(passes.size());
+    header.numValues = buffer.size();
+
+    // Written next to the checkpoint and moved over it, a render killed
+    // while writing keeps the previous one
+    const std::string tmpPath = m_checkpointFile + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(passes.data()),
+                   passes.size() * sizeof(int32_t));
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   buffer.size() * sizeof(float));
+        file.close();
+        if (!file) {
+            TF_WARN("Couldn't write checkpoint to %s", tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), m_checkpointFile.c_str()) != 0) {
+        TF_WARN("Couldn't move checkpoint to %s", m_checkpointFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void
+HdCyclesRenderParam::_WriteRenderTile(ccl::RenderTile& rtile, bool a_finished)
+{
+    HD_TRACE_FUNCTION();
+
+    // No session, exit out
+    if (!m_cyclesSession)
+        return;
+
+    if (!m_useTiledRendering)
+        return;
+
+    const int x = rtile.x;
+    const int y = rtile.y;
+    const int w = rtile.w;
+    const int h = rtile.h;
+
+    ccl::RenderBuffers* buffers = rtile.buffers;
+
+    // copy data from device
+    if (!buffers->copy_from_device())
+        return;
+
+    // Adjust absolute sample number to the range.
+    int sample = rtile.sample;
+    const int range_start_sample
+        = m_cyclesSession->tile_manager.range_start_sample;
+    if (range_start_sample != -1) {
+        sample -= range_start_sample;
+    }
+
+    const float exposure = m_cyclesScene->film->exposure;
+
+    // Streamed to disk first, the host may not read the render buffers
+    if (a_finished && m_tileWriter)
+        m_tileWriter->WriteTile(rtile, exposure, sample);
+
+    std::shared_ptr<const AovPassBindings> bindings = std::atomic_load(
+        &m_aovPassBindings);
+    if (!bindings || bindings->empty())
+        return;
+
+    HdCyclesSyncTimer blitTimer(this, _tokens->blitTile);
+
+    // Tiles are written from the Cycles worker threads, each keeps one
+    // scratch buffer that only grows
+    thread_local ccl::vector<float> tileData;
+
+    for (const AovPassBinding& binding : *bindings) {
+        HdCyclesRenderBuffer* rb = binding.renderBuffer;
+
+        if (rb->GetFormat() == HdFormatInvalid) {
+            continue;
+        }
+
+        rb->SetConverged(IsConverged());
+
+        const size_t tileSize = static_cast<size_t>(w * h
+                                                    * binding.numComponents);
+        if (tileData.size() < tileSize) {
+            tileData.resize(tileSize);
+        }
+
+        bool read = buffers->get_pass_rect(binding.passName.c_str(), exposure,
+                                           sample, binding.numComponents,
+                                           tileData.data());
+
+        if (!read) {
+            memset(tileData.data(), 0, tileSize * sizeof(float));
         }
+
+        rb->BlitTile(binding.format, x, y, w, h, 0, w,
+                     reinterpret_cast<uint8_t*>(tileData.data()));
+        blitTimer.AddElements(static_cast<size_t>(w * h));
     }
 }
 
@@ -1402,16 +2547,28 @@ void
 HdCyclesRenderParam::_UpdateRenderTile(ccl::RenderTile& rtile, bool highlight)
 {
     if (m_cyclesSession->params.progressive_refine)
-        _WriteRenderTile(rtile);
+        _WriteRenderTile(rtile, false);
 }
 
 bool
 HdCyclesRenderParam::_CreateScene()
 {
+    HD_TRACE_FUNCTION();
+
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
 
     m_cyclesScene = new ccl::Scene(m_sceneParams, m_cyclesSession->device);
 
+    // OSL reads tiled and mipmapped textures on demand through the shared
+    // texture system, which its shader manager just set up with its own
+    // defaults. SVM loads whole images and never uses it.
+    if (m_sceneParams.shadingsystem == ccl::SHADINGSYSTEM_OSL
+        && config.texture_cache_size.value > 0) {
+        OIIO::TextureSystem* textureSystem = OIIO::TextureSystem::create(true);
+        textureSystem->attribute("max_memory_MB",
+                                 (float)config.texture_cache_size.value);
+    }
+
     m_width  = config.render_width.value;
     m_height = config.render_height.value;
 
@@ -1422,18 +2579,19 @@ HdCyclesRenderParam::_CreateScene()
 
     m_cyclesSession->scene = m_cyclesScene;
 
-    m_bufferParams.width       = m_width;
-    m_bufferParams.height      = m_height;
-    m_bufferParams.full_width  = m_width;
-    m_bufferParams.full_height = m_height;
+    _UpdateBufferParams();
 
     default_vcol_surface = HdCyclesCreateDefaultShader();
 
     default_vcol_surface->tag_update(m_cyclesScene);
     m_cyclesScene->shaders.push_back(default_vcol_surface);
 
+    m_defaultBackground = _CreateDefaultBackgroundShader(true);
+    m_emptyBackground   = _CreateDefaultBackgroundShader(false);
+
     SetBackgroundShader(nullptr);
 
+    _PrepareCheckpointResume();
     m_cyclesSession->reset(m_bufferParams, m_sessionParams.samples);
 
     return true;
@@ -1478,13 +2636,28 @@ HdCyclesRenderParam::ResumeRender()
 void
 HdCyclesRenderParam::Interrupt(bool a_forceUpdate)
 {
-    m_shouldUpdate = true;
-    PauseRender();
+    // Only the first interrupt between two commits needs to pause
+    if (!m_shouldUpdate.exchange(true))
+        PauseRender();
 }
 
 void
-HdCyclesRenderParam::CommitResources()
+HdCyclesRenderParam::CommitResources(HdChangeTracker* a_tracker)
 {
+    HD_TRACE_FUNCTION();
+
+    const double commitStart = ccl::time_dt();
+
+    _WaitForKernels();
+
+    if (_ApplyPendingEdits())
+        m_shouldUpdate = true;
+
+    if (_ApplyPendingRenderSettings())
+        m_shouldUpdate = true;
+
+    _UpdateDicing(a_tracker);
+
     if (m_shouldUpdate) {
         if (m_cyclesScene->lights.size() > 0) {
             if (m_numDomeLights <= 0)
@@ -1493,43 +2666,61 @@ HdCyclesRenderParam::CommitResources()
             SetBackgroundShader(nullptr, true);
         }
 
+        // Resumed by the reset the render pass flushes
         CyclesReset(false);
         m_shouldUpdate = false;
-        ResumeRender();
+    } else if (!m_resetPending) {
+        _UpdateCheckpoint(false);
     }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_lastCommitTime = ccl::time_dt() - commitStart;
+    m_commitTime += m_lastCommitTime;
+
+    if (m_firstSyncTime == 0.0)
+        m_firstSyncTime = ccl::time_dt() - m_createTime;
 }
 
 void
 HdCyclesRenderParam::SetBackgroundShader(ccl::Shader* a_shader, bool a_emissive)
 {
-    if (a_shader)
-        m_cyclesScene->default_background = a_shader;
-    else {
-        // TODO: These aren't properly destroyed from memory
-
-        // Create empty background shader
-        m_cyclesScene->default_background        = new ccl::Shader();
-        m_cyclesScene->default_background->name  = "default_background";
-        m_cyclesScene->default_background->graph = new ccl::ShaderGraph();
-        if (a_emissive) {
-            ccl::BackgroundNode* bgNode = new ccl::BackgroundNode();
-            bgNode->color               = ccl::make_float3(0.6f, 0.6f, 0.6f);
-
-            m_cyclesScene->default_background->graph->add(bgNode);
-
-            ccl::ShaderNode* out
-                = m_cyclesScene->default_background->graph->output();
-            m_cyclesScene->default_background->graph->connect(
-                bgNode->output("Background"), out->input("Surface"));
-        }
+    // The defaults are created once with the scene and owned by it
+    if (!a_shader)
+        a_shader = a_emissive ? m_defaultBackground : m_emptyBackground;
 
-        m_cyclesScene->default_background->tag_update(m_cyclesScene);
+    // Called on every commit, only a switch needs a background update
+    if (m_cyclesScene->default_background == a_shader)
+        return;
 
-        m_cyclesScene->shaders.push_back(m_cyclesScene->default_background);
-    }
+    m_cyclesScene->default_background = a_shader;
     m_cyclesScene->background->tag_update(m_cyclesScene);
 }
 
+ccl::Shader*
+HdCyclesRenderParam::_CreateDefaultBackgroundShader(bool a_emissive)
+{
+    ccl::Shader* shader = new ccl::Shader();
+    shader->name        = a_emissive ? "default_background"
+                                     : "default_background_empty";
+    shader->graph       = new ccl::ShaderGraph();
+
+    if (a_emissive) {
+        ccl::BackgroundNode* bgNode = new ccl::BackgroundNode();
+        bgNode->color               = ccl::make_float3(0.6f, 0.6f, 0.6f);
+
+        shader->graph->add(bgNode);
+
+        ccl::ShaderNode* out = shader->graph->output();
+        shader->graph->connect(bgNode->output("Background"),
+                               out->input("Surface"));
+    }
+
+    shader->tag_update(m_cyclesScene);
+    m_cyclesScene->shaders.push_back(shader);
+
+    return shader;
+}
+
 /* ======= Cycles Settings ======= */
 
 // -- Cycles render device
@@ -1553,8 +2744,22 @@ bool
 HdCyclesRenderParam::SetDeviceType(const std::string& a_deviceType,
                                    ccl::SessionParams& params)
 {
-    return SetDeviceType(ccl::Device::type_from_string(a_deviceType.c_str()),
-                         params);
+    if (a_deviceType.find_first_of("+:") == std::string::npos) {
+        return SetDeviceType(
+            ccl::Device::type_from_string(a_deviceType.c_str()), params);
+    }
+
+    std::vector<ccl::DeviceInfo> devices;
+    if (!_ParseDeviceSpec(a_deviceType, devices)) {
+        TF_RUNTIME_ERROR("No device available for '%s'.",
+                         a_deviceType.c_str());
+        return false;
+    }
+
+    m_deviceType = devices.front().type;
+    m_deviceName = a_deviceType;
+
+    return _SetDevices(devices, params);
 }
 
 bool
@@ -1571,14 +2776,28 @@ bool
 HdCyclesRenderParam::_SetDevice(const ccl::DeviceType& a_deviceType,
                                 ccl::SessionParams& params)
 {
-    std::vector<ccl::DeviceInfo> devices = ccl::Device::available_devices(
+    std::vector<ccl::DeviceInfo> devices = _AvailableDevices(
         (ccl::DeviceTypeMask)(1 << a_deviceType));
 
-    bool device_available = false;
+    if (devices.size() > 1) {
+        devices.resize(1);
+    }
+
+    return _SetDevices(devices, params);
+}
+
+bool
+HdCyclesRenderParam::_SetDevices(const std::vector<ccl::DeviceInfo>& a_devices,
+                                 ccl::SessionParams& params)
+{
+    bool device_available = !a_devices.empty();
 
-    if (!devices.empty()) {
-        params.device    = devices.front();
-        device_available = true;
+    if (a_devices.size() == 1) {
+        params.device = a_devices.front();
+    } else if (a_devices.size() > 1) {
+        params.device = ccl::Device::get_multi_device(a_devices,
+                                                      params.threads,
+                                                      params.background);
     }
 
     if (params.device.type == ccl::DEVICE_NONE || !device_available) {
@@ -1595,12 +2814,34 @@ HdCyclesRenderParam::_SetDevice(const ccl::DeviceType& a_deviceType,
 void
 HdCyclesRenderParam::_CyclesStart()
 {
+    _WaitForKernels();
+
+    if (!m_tileWriter || !m_tileWriter->IsOpen())
+        _OpenTileOutput();
+
     m_cyclesSession->start();
+    m_sessionStarted = true;
+}
+
+bool
+HdCyclesRenderParam::_JoinFinishedSession()
+{
+    if (!m_sessionStarted || !m_cyclesSession->params.background
+        || !IsConverged())
+        return false;
+
+    m_cyclesSession->wait();
+    return true;
 }
 
 void
 HdCyclesRenderParam::_CyclesExit()
 {
+    _WaitForKernels();
+
+    // Written before the session pauses, the sample being rendered is kept
+    _UpdateCheckpoint(true);
+
     m_cyclesSession->set_pause(true);
 
     m_cyclesScene->mutex.lock();
@@ -1613,39 +2854,187 @@ HdCyclesRenderParam::_CyclesExit()
 
     m_cyclesScene->mutex.unlock();
 
+    _FreePendingRemovals();
+
+    const std::string& statsFile
+        = HdCyclesConfig::GetInstance().render_stats_file;
+    if (!statsFile.empty()) {
+        WriteRenderStats(statsFile);
+    }
+
     if (m_cyclesSession) {
         delete m_cyclesSession;
         m_cyclesSession = nullptr;
     }
+    m_sessionStarted = false;
+
+    // No more tiles come in once the session is gone
+    if (m_tileWriter)
+        m_tileWriter->Close();
 }
 
-// TODO: Refactor these two resets
-void
-HdCyclesRenderParam::CyclesReset(bool a_forceUpdate)
+bool
+HdCyclesRenderParam::_ApplyPendingEdits()
 {
-    m_cyclesScene->mutex.lock();
+    HD_TRACE_FUNCTION();
 
-    m_cyclesSession->progress.reset();
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    if (m_curveUpdated || m_meshUpdated || m_geometryUpdated
-        || m_shadersUpdated) {
-        m_cyclesScene->geometry_manager->tag_update(m_cyclesScene);
-        m_geometryUpdated = false;
-        m_meshUpdated     = false;
+    if (m_pendingAddObjects.empty() && m_pendingRemoveObjects.empty()
+        && m_pendingAddGeometry.empty() && m_pendingRemoveGeometry.empty()
+        && m_pendingAddLights.empty() && m_pendingRemoveLights.empty()
+        && m_pendingAddShaders.empty() && m_pendingRemoveShaders.empty()) {
+        return false;
     }
 
-    if (m_curveUpdated) {
-        m_curveUpdated = false;
+    if (!m_cyclesScene) {
+        TF_WARN("Couldn't apply scene edits. Scene is null.");
+        return false;
     }
 
-    if (m_objectsUpdated || m_shadersUpdated) {
-        m_cyclesScene->object_manager->tag_update(m_cyclesScene);
-        m_objectsUpdated = false;
-        m_shadersUpdated = false;
+    m_cyclesScene->mutex.lock();
+
+    // Removals go first, an address can only be reused by a new add once
+    // the removed item has been freed below
+
+    for (ccl::Object* object : m_pendingRemoveObjects)
+        _IndexedRemove(m_cyclesScene->objects, m_objectSlots, object,
+                       true);
+    for (ccl::Geometry* geometry : m_pendingRemoveGeometry)
+        _IndexedRemove(m_cyclesScene->geometry, m_geometrySlots, geometry,
+                       true);
+    for (ccl::Light* light : m_pendingRemoveLights)
+        _IndexedRemove(m_cyclesScene->lights, m_lightSlots, light, true);
+
+    // Removing any but the last shader renumbers the ones after it
+    bool renumberedShaders = false;
+    for (ccl::Shader* shader : m_pendingRemoveShaders) {
+        const bool last = !m_cyclesScene->shaders.empty()
+                          && m_cyclesScene->shaders.back() == shader;
+        if (_OrderedRemove(m_cyclesScene->shaders, m_shaderSlots, shader)
+            && !last)
+            renumberedShaders = true;
+
+        // A removed dome light leaves a default in its place
+        if (shader == m_cyclesScene->default_background)
+            SetBackgroundShader(nullptr, m_cyclesScene->lights.empty());
+    }
+
+    m_cyclesScene->objects.reserve(m_cyclesScene->objects.size()
+                                   + m_pendingAddObjects.size());
+    for (ccl::Object* object : m_pendingAddObjects)
+        _IndexedAdd(m_cyclesScene->objects, m_objectSlots, object);
+
+    m_cyclesScene->geometry.reserve(m_cyclesScene->geometry.size()
+                                    + m_pendingAddGeometry.size());
+    for (ccl::Geometry* geometry : m_pendingAddGeometry)
+        _IndexedAdd(m_cyclesScene->geometry, m_geometrySlots, geometry);
+
+    for (ccl::Light* light : m_pendingAddLights)
+        _IndexedAdd(m_cyclesScene->lights, m_lightSlots, light);
+    for (ccl::Shader* shader : m_pendingAddShaders)
+        _IndexedAdd(m_cyclesScene->shaders, m_shaderSlots, shader);
+
+    if (!m_pendingAddObjects.empty() || !m_pendingRemoveObjects.empty())
+        TagSceneChange(SceneChangeObjects);
+    if (!m_pendingAddGeometry.empty() || !m_pendingRemoveGeometry.empty())
+        TagSceneChange(SceneChangeGeometry);
+    if (!m_pendingAddLights.empty() || !m_pendingRemoveLights.empty())
+        TagSceneChange(SceneChangeLights);
+    if (!m_pendingAddShaders.empty() || !m_pendingRemoveShaders.empty())
+        TagSceneChange(SceneChangeShaders);
+
+    // Geometry, lights and the background pack the shader ids
+    if (renumberedShaders) {
+        TagSceneChange(SceneChangeGeometry | SceneChangeLights);
+        m_cyclesScene->background->tag_update(m_cyclesScene);
     }
-    if (m_lightsUpdated) {
+
+    m_cyclesScene->mutex.unlock();
+
+    m_pendingAddObjects.clear();
+    m_pendingAddGeometry.clear();
+    m_pendingAddLights.clear();
+    m_pendingAddShaders.clear();
+    m_pendingObjectSlots.clear();
+    m_pendingGeometrySlots.clear();
+    m_pendingLightSlots.clear();
+    m_pendingShaderSlots.clear();
+
+    // Nothing in the scene references these anymore
+    _DeleteAll(m_pendingRemoveObjects);
+    _DeleteAll(m_pendingRemoveGeometry);
+    _DeleteAll(m_pendingRemoveLights);
+    _DeleteAll(m_pendingRemoveShaders);
+
+    return true;
+}
+
+void
+HdCyclesRenderParam::_FreePendingRemovals()
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    m_pendingAddObjects.clear();
+    m_pendingAddGeometry.clear();
+    m_pendingAddLights.clear();
+    m_pendingAddShaders.clear();
+    m_pendingObjectSlots.clear();
+    m_pendingGeometrySlots.clear();
+    m_pendingLightSlots.clear();
+    m_pendingShaderSlots.clear();
+
+    // The scene vectors have been cleared
+    m_objectSlots.clear();
+    m_geometrySlots.clear();
+    m_lightSlots.clear();
+    m_shaderSlots.clear();
+
+    _DeleteAll(m_pendingRemoveObjects);
+    _DeleteAll(m_pendingRemoveGeometry);
+    _DeleteAll(m_pendingRemoveLights);
+    _DeleteAll(m_pendingRemoveShaders);
+}
+
+// TODO: Refactor these two resets
+void
+HdCyclesRenderParam::CyclesReset(bool a_forceUpdate)
+{
+    m_cyclesScene->mutex.lock();
+
+    m_cyclesSession->progress.reset();
+
+    const uint32_t changes = m_sceneChanges.exchange(SceneChangeNone);
+
+    // BVH settings apply to every geometry, a refit would keep the old ones
+    if (changes & SceneChangeBvh) {
+        for (ccl::Geometry* geometry : m_cyclesScene->geometry) {
+            geometry->tag_update(m_cyclesScene, true);
+        }
+    }
+
+    // Prims tag their own geometry for rebuild or refit, the manager only
+    // needs a nudge when geometry changed. With the dynamic BVH type a
+    // transform only edit keeps the geometry BVHs and rebuilds just the top
+    // level over the objects. The static type bakes transforms into the
+    // geometry and is meant for final renders.
+    const uint32_t geometryChanges = SceneChangeGeometry | SceneChangeDeform
+                                     | SceneChangeBvh;
+    if (changes & geometryChanges) {
+        m_cyclesScene->geometry_manager->tag_update(m_cyclesScene);
+    }
+
+    if (changes & (SceneChangeObjects | SceneChangeTransform)) {
+        m_cyclesScene->object_manager->tag_update(m_cyclesScene);
+    }
+
+    // Shaders tag geometry themselves when their requested attributes change
+    if (changes & SceneChangeShaders) {
+        m_cyclesScene->shader_manager->need_update = true;
+    }
+
+    if (changes & SceneChangeLights) {
         m_cyclesScene->light_manager->tag_update(m_cyclesScene);
-        m_lightsUpdated = false;
     }
 
     if (a_forceUpdate) {
@@ -1654,8 +3043,62 @@ HdCyclesRenderParam::CyclesReset(bool a_forceUpdate)
         m_cyclesScene->film->tag_update(m_cyclesScene);
     }
 
-    m_cyclesSession->reset(m_bufferParams, m_cyclesSession->params.samples);
     m_cyclesScene->mutex.unlock();
+
+    RequestReset();
+}
+
+void
+HdCyclesRenderParam::FlushReset()
+{
+    HD_TRACE_FUNCTION();
+
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+
+    if (m_navigating
+        && ccl::time_dt() - m_navigationTime
+               >= config.navigation_debounce.value) {
+        // Keeps accumulating on top of the navigation samples
+        m_navigating = false;
+        m_cyclesSession->set_samples(m_navigationFullSamples);
+    }
+
+    if (!m_resetPending.exchange(false))
+        return;
+
+    DirectReset();
+    ResumeRender();
+}
+
+void
+HdCyclesRenderParam::BeginNavigation()
+{
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+
+    const int samples = config.navigation_samples.value;
+    if (samples <= 0 || m_cyclesSession->params.background)
+        return;
+
+    m_navigationTime = ccl::time_dt();
+
+    if (!m_navigating && samples < m_cyclesSession->params.samples) {
+        m_navigationFullSamples = m_cyclesSession->params.samples;
+        m_navigating            = true;
+        m_cyclesSession->set_samples(samples);
+    }
+}
+
+void
+HdCyclesRenderParam::_MarkReset()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_resetTime             = ccl::time_dt();
+    m_waitingForFirstSample = true;
+    m_statsWritten          = false;
+
+    // Otherwise the previous frame reads as converged until the session
+    // reports progress again
+    m_renderProgress = 0.0f;
 }
 
 void
@@ -1664,25 +3107,102 @@ HdCyclesRenderParam::SetViewport(int w, int h)
     m_width  = w;
     m_height = h;
 
-    m_bufferParams.width          = m_width;
-    m_bufferParams.height         = m_height;
-    m_bufferParams.full_width     = m_width;
-    m_bufferParams.full_height    = m_height;
+    _UpdateBufferParams();
+
     m_cyclesScene->camera->width  = m_width;
     m_cyclesScene->camera->height = m_height;
     m_cyclesScene->camera->compute_auto_viewplane();
     m_cyclesScene->camera->need_update        = true;
     m_cyclesScene->camera->need_device_update = true;
 
-    m_aovBindingsNeedValidation = true;
+    RequestReset();
+}
 
-    m_cyclesSession->reset(m_bufferParams, m_cyclesSession->params.samples);
+void
+HdCyclesRenderParam::SetRenderRegion(const GfVec4f& a_region)
+{
+    GfVec4f region(std::max(a_region[0], 0.0f), std::max(a_region[1], 0.0f),
+                   std::min(a_region[2], 1.0f), std::min(a_region[3], 1.0f));
+
+    // An empty region renders the whole viewport
+    if (region[2] <= region[0] || region[3] <= region[1])
+        region = GfVec4f(0.0f, 0.0f, 1.0f, 1.0f);
+
+    if (region == m_renderRegion)
+        return;
+
+    m_renderRegion = region;
+
+    _UpdateBufferParams();
+
+    RequestReset();
+}
+
+void
+HdCyclesRenderParam::_UpdateBufferParams()
+{
+    // The camera keeps framing the full viewport, Cycles only renders the
+    // pixels of the region
+    const int x0 = static_cast<int>(std::floor(m_renderRegion[0] * m_width));
+    int y0       = static_cast<int>(std::floor(m_renderRegion[1] * m_height));
+    const int x1 = static_cast<int>(std::ceil(m_renderRegion[2] * m_width));
+    int y1       = static_cast<int>(std::ceil(m_renderRegion[3] * m_height));
+
+    // Each bucket takes a band of whole tile rows, so the tiles are the same
+    // as in a single render and the bands of all buckets add up to the frame.
+    // Progressive renders display the whole region and aren't split.
+    if (m_useTiledRendering && m_bucketCount > 1) {
+        const int height = std::max(y1 - y0, 1);
+        const int tileH  = std::max(m_cyclesSession
+                                        ? m_cyclesSession->params.tile_size.y
+                                        : m_sessionParams.tile_size.y,
+                                    1);
+
+        // Bands fall back to pixel rows when there are fewer tile rows
+        int rowHeight = tileH;
+        int numRows   = (height + tileH - 1) / tileH;
+        if (numRows < m_bucketCount) {
+            rowHeight = 1;
+            numRows   = height;
+        }
+
+        if (m_bucketIndex < 0 || m_bucketIndex >= m_bucketCount
+            || numRows < m_bucketCount) {
+            TF_WARN("Can't render bucket %d of %d over %d rows, rendering the "
+                    "whole frame",
+                    m_bucketIndex, m_bucketCount, height);
+        } else {
+            const int rowStart = m_bucketIndex * numRows / m_bucketCount;
+            const int rowEnd   = (m_bucketIndex + 1) * numRows / m_bucketCount;
+
+            const int bandY0 = y0 + rowStart * rowHeight;
+            y1               = std::min(y0 + rowEnd * rowHeight, y1);
+            y0               = bandY0;
+        }
+    }
+
+    m_bufferParams.full_x      = x0;
+    m_bufferParams.full_y      = y0;
+    m_bufferParams.width       = std::max(x1 - x0, 1);
+    m_bufferParams.height      = std::max(y1 - y0, 1);
+    m_bufferParams.full_width  = m_width;
+    m_bufferParams.full_height = m_height;
 }
 
 void
 HdCyclesRenderParam::DirectReset()
 {
+    HD_TRACE_FUNCTION();
+
+    const bool restart = _JoinFinishedSession();
+
+    _PrepareCheckpointResume();
     m_cyclesSession->reset(m_bufferParams, m_cyclesSession->params.samples);
+    _MarkReset();
+    _OpenTileOutput();
+
+    if (restart)
+        _CyclesStart();
 }
 
 void
@@ -1693,9 +3213,9 @@ HdCyclesRenderParam::AddLight(ccl::Light* a_light)
         return;
     }
 
-    m_lightsUpdated = true;
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->lights.push_back(a_light);
+    _IndexedAdd(m_pendingAddLights, m_pendingLightSlots, a_light);
 
     if (a_light->type == ccl::LIGHT_BACKGROUND) {
         m_numDomeLights += 1;
@@ -1710,9 +3230,11 @@ HdCyclesRenderParam::AddObject(ccl::Object* a_object)
         return;
     }
 
-    m_objectsUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->objects.push_back(a_object);
+        _IndexedAdd(m_pendingAddObjects, m_pendingObjectSlots, a_object);
+    }
 
     Interrupt();
 }
@@ -1725,9 +3247,12 @@ HdCyclesRenderParam::AddGeometry(ccl::Geometry* a_geometry)
         return;
     }
 
-    m_geometryUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->geometry.push_back(a_geometry);
+        _IndexedAdd(m_pendingAddGeometry, m_pendingGeometrySlots,
+                    a_geometry);
+    }
 
     Interrupt();
 }
@@ -1740,9 +3265,12 @@ HdCyclesRenderParam::AddMesh(ccl::Mesh* a_mesh)
         return;
     }
 
-    m_meshUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->geometry.push_back(a_mesh);
+        ccl::Geometry* geometry = a_mesh;
+        _IndexedAdd(m_pendingAddGeometry, m_pendingGeometrySlots, geometry);
+    }
 
     Interrupt();
 }
@@ -1755,9 +3283,12 @@ HdCyclesRenderParam::AddCurve(ccl::Geometry* a_curve)
         return;
     }
 
-    m_curveUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->geometry.push_back(a_curve);
+        ccl::Geometry* geometry = a_curve;
+        _IndexedAdd(m_pendingAddGeometry, m_pendingGeometrySlots, geometry);
+    }
 
     Interrupt();
 }
@@ -1770,143 +3301,414 @@ HdCyclesRenderParam::AddShader(ccl::Shader* a_shader)
         return;
     }
 
-    m_shadersUpdated = true;
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-    m_cyclesScene->shaders.push_back(a_shader);
+    _IndexedAdd(m_pendingAddShaders, m_pendingShaderSlots, a_shader);
 }
 
 void
 HdCyclesRenderParam::RemoveObject(ccl::Object* a_object)
 {
-    for (ccl::vector<ccl::Object*>::iterator it = m_cyclesScene->objects.begin();
-         it != m_cyclesScene->objects.end();) {
-        if (a_object == *it) {
-            it = m_cyclesScene->objects.erase(it);
+    if (!a_object)
+        return;
 
-            m_objectsUpdated = true;
-            break;
-        } else {
-            ++it;
-        }
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+        _IndexedRemove(m_pendingAddObjects, m_pendingObjectSlots, a_object);
+        m_pendingRemoveObjects.push_back(a_object);
     }
 
-    if (m_objectsUpdated)
-        Interrupt();
+    Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveLight(ccl::Light* a_light)
 {
-    for (ccl::vector<ccl::Light*>::iterator it = m_cyclesScene->lights.begin();
-         it != m_cyclesScene->lights.end();) {
-        if (a_light == *it) {
-            it = m_cyclesScene->lights.erase(it);
-
-            // TODO: This doesnt respect multiple dome lights
-            if (a_light->type == ccl::LIGHT_BACKGROUND) {
-                m_numDomeLights = std::max(0, m_numDomeLights - 1);
-            }
+    if (!a_light)
+        return;
 
-            m_lightsUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-            break;
-        } else {
-            ++it;
+        // TODO: This doesnt respect multiple dome lights
+        if (a_light->type == ccl::LIGHT_BACKGROUND) {
+            m_numDomeLights = std::max(0, m_numDomeLights - 1);
         }
-    }
 
+        _IndexedRemove(m_pendingAddLights, m_pendingLightSlots, a_light);
+        m_pendingRemoveLights.push_back(a_light);
+    }
 
-    if (m_lightsUpdated)
-        Interrupt();
+    Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveMesh(ccl::Mesh* a_mesh)
 {
-    for (ccl::vector<ccl::Geometry*>::iterator it
-         = m_cyclesScene->geometry.begin();
-         it != m_cyclesScene->geometry.end();) {
-        if (a_mesh == *it) {
-            it = m_cyclesScene->geometry.erase(it);
+    if (!a_mesh)
+        return;
 
-            m_meshUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-            break;
-        } else {
-            ++it;
-        }
+        ccl::Geometry* geometry = a_mesh;
+        _IndexedRemove(m_pendingAddGeometry, m_pendingGeometrySlots, geometry);
+        m_pendingRemoveGeometry.push_back(a_mesh);
     }
 
-    if (m_geometryUpdated)
-        Interrupt();
+    Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveCurve(ccl::Hair* a_hair)
 {
-    for (ccl::vector<ccl::Geometry*>::iterator it
-         = m_cyclesScene->geometry.begin();
-         it != m_cyclesScene->geometry.end();) {
-        if (a_hair == *it) {
-            it = m_cyclesScene->geometry.erase(it);
+    if (!a_hair)
+        return;
 
-            m_curveUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-            break;
-        } else {
-            ++it;
-        }
+        ccl::Geometry* geometry = a_hair;
+        _IndexedRemove(m_pendingAddGeometry, m_pendingGeometrySlots, geometry);
+        m_pendingRemoveGeometry.push_back(a_hair);
     }
 
-    if (m_geometryUpdated)
-        Interrupt();
+    Interrupt();
+}
+
+void
+HdCyclesRenderParam::RemoveGeometry(ccl::Geometry* a_geometry)
+{
+    if (!a_geometry)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+        _IndexedRemove(m_pendingAddGeometry, m_pendingGeometrySlots,
+                       a_geometry);
+        m_pendingRemoveGeometry.push_back(a_geometry);
+    }
+
+    Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveShader(ccl::Shader* a_shader)
 {
-    for (ccl::vector<ccl::Shader*>::iterator it = m_cyclesScene->shaders.begin();
-         it != m_cyclesScene->shaders.end();) {
-        if (a_shader == *it) {
-            it = m_cyclesScene->shaders.erase(it);
+    if (!a_shader)
+        return;
 
-            m_shadersUpdated = true;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
 
-            break;
-        } else {
-            ++it;
+        _IndexedRemove(m_pendingAddShaders, m_pendingShaderSlots, a_shader);
+        m_pendingRemoveShaders.push_back(a_shader);
+    }
+
+    Interrupt();
+}
+
+ccl::Shader*
+HdCyclesRenderParam::AcquireShader(size_t a_hash, ccl::Shader* a_current,
+                                   bool* a_needsBuild)
+{
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+
+    *a_needsBuild = true;
+
+    auto it      = m_sharedShaderHashes.find(a_hash);
+    auto current = m_sharedShaders.find(a_current);
+    if (current != m_sharedShaders.end()) {
+        // Nothing else uses it and no other shader was built for the new
+        // network, rebuilding in place keeps the pointer the rprims already
+        // hold valid
+        if (current->second.refCount == 1
+            && (it == m_sharedShaderHashes.end() || it->second == a_current)) {
+            if (current->second.hash != a_hash) {
+                _UnlistShared(m_sharedShaderHashes, current->second.hash,
+                              a_current);
+
+                current->second.hash = a_hash;
+                const bool listed
+                    = m_sharedShaderHashes.emplace(a_hash, a_current).second;
+                TF_VERIFY(listed);
+            }
+            return a_current;
         }
+
+        // Otherwise it moves over to the shader of the new network
+        _ReleaseShader(a_current);
+        it = m_sharedShaderHashes.find(a_hash);
     }
 
-    if (m_shadersUpdated)
-        Interrupt();
+    if (it == m_sharedShaderHashes.end())
+        return nullptr;
+
+    m_sharedShaders[it->second].refCount += 1;
+    *a_needsBuild = false;
+    return it->second;
 }
 
-VtDictionary
-HdCyclesRenderParam::GetRenderStats() const
+ccl::Shader*
+HdCyclesRenderParam::RegisterShader(size_t a_hash, ccl::Shader* a_shader)
 {
-    // Currently, collect_statistics errors seemingly during render,
-    // we probably need to only access these when the render is complete
-    // however this codeflow is currently undefined...
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
 
-    //ccl::RenderStats stats;
-    //m_cyclesSession->collect_statistics(&stats);
+        auto it = m_sharedShaderHashes.find(a_hash);
+        if (it != m_sharedShaderHashes.end()) {
+            m_sharedShaders[it->second].refCount += 1;
+            return it->second;
+        }
 
-    return {
-        { "hdcycles:version", VtValue(HD_CYCLES_VERSION) },
+        m_sharedShaderHashes.emplace(a_hash, a_shader);
+        m_sharedShaders[a_shader] = { a_hash, 1 };
+    }
+
+    AddShader(a_shader);
+    return a_shader;
+}
+
+void
+HdCyclesRenderParam::ReleaseShader(ccl::Shader* a_shader)
+{
+    if (!a_shader)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+    _ReleaseShader(a_shader);
+}
+
+void
+HdCyclesRenderParam::_ReleaseShader(ccl::Shader* a_shader)
+{
+    auto shared = m_sharedShaders.find(a_shader);
+    if (shared == m_sharedShaders.end()) {
+        RemoveShader(a_shader);
+        return;
+    }
+
+    if (--shared->second.refCount > 0)
+        return;
+
+    _UnlistShared(m_sharedShaderHashes, shared->second.hash, a_shader);
+    m_sharedShaders.erase(shared);
+
+    RemoveShader(a_shader);
+}
+
+void
+HdCyclesRenderParam::RegisterGeometry(ccl::Geometry* a_geometry)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        m_sharedGeometry[a_geometry] = { 0, 1 };
+    }
+
+    AddGeometry(a_geometry);
+}
+
+ccl::Geometry*
+HdCyclesRenderParam::ShareGeometry(size_t a_hash, ccl::Geometry* a_geometry)
+{
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+
+    auto it = m_sharedGeometryHashes.find(a_hash);
+    if (it != m_sharedGeometryHashes.end() && it->second != a_geometry) {
+        ccl::Geometry* shared = it->second;
+        m_sharedGeometry[shared].refCount += 1;
+        _ReleaseGeometry(a_geometry);
+        return shared;
+    }
+
+    auto current = m_sharedGeometry.find(a_geometry);
+    if (current != m_sharedGeometry.end()) {
+        _UnlistShared(m_sharedGeometryHashes, current->second.hash,
+                      a_geometry);
+        current->second.hash = a_hash;
+    } else {
+        m_sharedGeometry[a_geometry] = { a_hash, 1 };
+    }
+    m_sharedGeometryHashes[a_hash] = a_geometry;
+
+    return a_geometry;
+}
+
+bool
+HdCyclesRenderParam::UnshareGeometry(ccl::Geometry* a_geometry)
+{
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+
+    auto current = m_sharedGeometry.find(a_geometry);
+    if (current == m_sharedGeometry.end())
+        return true;
+
+    if (current->second.refCount > 1)
+        return false;
+
+    // Its content is about to change, nobody may pick it up meanwhile
+    _UnlistShared(m_sharedGeometryHashes, current->second.hash, a_geometry);
+    return true;
+}
+
+void
+HdCyclesRenderParam::ReleaseGeometry(ccl::Geometry* a_geometry)
+{
+    if (!a_geometry)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_sharedMutex);
+    _ReleaseGeometry(a_geometry);
+}
+
+void
+HdCyclesRenderParam::_ReleaseGeometry(ccl::Geometry* a_geometry)
+{
+    auto shared = m_sharedGeometry.find(a_geometry);
+    if (shared != m_sharedGeometry.end()) {
+        if (--shared->second.refCount > 0)
+            return;
+
+        _UnlistShared(m_sharedGeometryHashes, shared->second.hash,
+                      a_geometry);
+        m_sharedGeometry.erase(shared);
+    }
+
+    RemoveGeometry(a_geometry);
+}
+
+void
+HdCyclesRenderParam::UpdateDicingCamera(const ccl::Camera* a_renderCamera)
+{
+    if (!m_cyclesScene)
+        return;
+
+    ccl::Camera* dicing = m_cyclesScene->dicing_camera;
+
+    if (a_renderCamera) {
+        if (!m_dicingCamera.IsEmpty())
+            return;
+
+        // Only what decides the screen size of a patch
+        dicing->matrix                 = a_renderCamera->matrix;
+        dicing->type                   = a_renderCamera->type;
+        dicing->panorama_type          = a_renderCamera->panorama_type;
+        dicing->fov                    = a_renderCamera->fov;
+        dicing->fisheye_fov            = a_renderCamera->fisheye_fov;
+        dicing->fisheye_lens           = a_renderCamera->fisheye_lens;
+        dicing->latitude_min           = a_renderCamera->latitude_min;
+        dicing->latitude_max           = a_renderCamera->latitude_max;
+        dicing->longitude_min          = a_renderCamera->longitude_min;
+        dicing->longitude_max          = a_renderCamera->longitude_max;
+        dicing->nearclip               = a_renderCamera->nearclip;
+        dicing->farclip                = a_renderCamera->farclip;
+        dicing->offscreen_dicing_scale = a_renderCamera->offscreen_dicing_scale;
+    }
+
+    // Dicing rates are in pixels of the render resolution
+    dicing->width  = m_width;
+    dicing->height = m_height;
+    dicing->compute_auto_viewplane();
+    dicing->need_update = true;
+}
+
+void
+HdCyclesRenderParam::RegisterSubdivMesh(const SdfPath& a_id,
+                                        ccl::Mesh* a_mesh, int a_maxLevel)
+{
+    if (!a_mesh || !a_mesh->subd_params)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_subdivMutex);
+
+    SubdivMesh& subdiv = m_subdivMeshes[a_id];
+    subdiv.mesh        = a_mesh;
+    subdiv.maxLevel    = a_maxLevel;
+    subdiv.dicedLevel  = a_maxLevel;
+    subdiv.diced       = false;
+}
+
+void
+HdCyclesRenderParam::UnregisterSubdivMesh(const SdfPath& a_id)
+{
+    std::lock_guard<std::mutex> lock(m_subdivMutex);
+    m_subdivMeshes.erase(a_id);
+}
+
+void
+HdCyclesRenderParam::_UpdateDicing(HdChangeTracker* a_tracker)
+{
+    std::lock_guard<std::mutex> lock(m_subdivMutex);
+
+    if (m_subdivMeshes.empty())
+        return;
+
+    // Every edge dices into at most 2^max_level segments, so a face into
+    // at most 4^max_level. Shared meshes are only diced once.
+    int levelCap = std::numeric_limits<int>::max();
+    if (m_subdivFaceBudget > 0) {
+        std::unordered_set<ccl::Mesh*> meshes;
+        size_t numFaces = 0;
+        for (const auto& entry : m_subdivMeshes) {
+            if (meshes.insert(entry.second.mesh).second)
+                numFaces += entry.second.mesh->subd_faces.size();
+        }
 
-        // - Cycles specific
+        const size_t budget = static_cast<size_t>(m_subdivFaceBudget);
+        levelCap            = 0;
+        while (levelCap < 16 && numFaces * 4 <= budget) {
+            numFaces *= 4;
+            ++levelCap;
+        }
+    }
+
+    ccl::Camera* camera = m_cyclesScene->dicing_camera;
+    const ccl::float3 position = ccl::transform_get_column(&camera->matrix,
+                                                           3);
+
+    m_cyclesScene->mutex.lock();
+
+    for (auto& entry : m_subdivMeshes) {
+        SubdivMesh& subdiv = entry.second;
+        const int level    = std::min(subdiv.maxLevel, levelCap);
+
+        // Rebuilt during this sync, Cycles dices it with the next update
+        if (!subdiv.diced) {
+            subdiv.mesh->subd_params->max_level = level;
+
+            subdiv.dicedLevel     = level;
+            subdiv.diced          = true;
+            subdiv.camera         = m_dicingCamera;
+            subdiv.cameraPosition = position;
+            continue;
+        }
 
-        // These error out currently, kept for future reference
-        /*{ "hdcycles:geometry:total_memory",
-          VtValue(ccl::string_human_readable_size(stats.mesh.geometry.total_size)
-                      .c_str()) },*/
-        /*{ "hdcycles:textures:total_memory",
-          VtValue(
-              ccl::string_human_readable_size(stats.image.textures.total_size)
-                  .c_str()) },*/
-        { "hdcycles:scene:num_objects", VtValue(m_cyclesScene->objects.size()) },
-        { "hdcycles:scene:num_shaders", VtValue(m_cyclesScene->shaders.size()) },
+        // Otherwise the dice is kept until the camera moved far enough,
+        // the prim re-registers when it rebuilt for the new dice
+        bool redice = level != subdiv.dicedLevel
+                      || subdiv.camera != m_dicingCamera;
+        if (m_dicingThreshold >= 0.0f
+            && ccl::len(position - subdiv.cameraPosition) > m_dicingThreshold)
+            redice = true;
+
+        if (redice && a_tracker)
+            a_tracker->MarkRprimDirty(entry.first,
+                                      HdChangeTracker::DirtyTopology);
+    }
+
+    m_cyclesScene->mutex.unlock();
+}
+
+VtDictionary
+HdCyclesRenderParam::GetRenderStats() const
+{
+    // collect_statistics errors during a render, so only counters that
+    // are safe to read from another thread are used here
+
+    VtDictionary stats = {
+        { "hdcycles:version", VtValue(HD_CYCLES_VERSION) },
 
         // - Solaris, husk specific
 
@@ -1917,12 +3719,158 @@ HdCyclesRenderParam::GetRenderStats() const
         { "rendererVersion", VtValue(HD_CYCLES_VERSION) },
         { "percentDone", VtValue(m_renderPercent) },
         { "fractionDone", VtValue(m_renderProgress) },
-        { "lightCounts", VtValue(m_cyclesScene->lights.size()) },
         { "totalClockTime", VtValue(m_totalTime) },
         { "cameraRays", VtValue(0) },
-        { "numCompletedSamples", VtValue(0) }
-
     };
+
+    // - Scene
+
+    if (m_cyclesScene) {
+        stats["hdcycles:scene:num_objects"] = VtValue(
+            m_cyclesScene->objects.size());
+        stats["hdcycles:scene:num_shaders"] = VtValue(
+            m_cyclesScene->shaders.size());
+        stats["hdcycles:scene:num_geometry"] = VtValue(
+            m_cyclesScene->geometry.size());
+        stats["lightCounts"] = VtValue(m_cyclesScene->lights.size());
+    }
+
+    // - Render
+
+    int currentSample = 0;
+    if (m_cyclesSession) {
+        currentSample = m_cyclesSession->progress.get_current_sample();
+
+        const double pixelSamples = double(m_bufferParams.width)
+                                    * double(m_bufferParams.height)
+                                    * double(currentSample);
+
+        stats["hdcycles:render:time"]           = VtValue(m_renderTime);
+        stats["hdcycles:render:current_sample"] = VtValue(currentSample);
+        stats["hdcycles:render:time_per_sample"] = VtValue(
+            currentSample > 0 ? m_renderTime / currentSample : 0.0);
+        stats["hdcycles:render:pixel_samples_per_second"] = VtValue(
+            m_renderTime > 0.0 ? pixelSamples / m_renderTime : 0.0);
+
+        // - Memory
+
+        const ccl::Stats& deviceStats = m_cyclesSession->device->stats;
+        stats["hdcycles:memory:device_used"] = VtValue(deviceStats.mem_used);
+        stats["hdcycles:memory:device_peak"] = VtValue(deviceStats.mem_peak);
+    }
+    stats["numCompletedSamples"] = VtValue(currentSample);
+
+    stats["hdcycles:memory:host_used"] = VtValue(
+        ccl::util_guarded_get_mem_used());
+    stats["hdcycles:memory:host_peak"] = VtValue(
+        ccl::util_guarded_get_mem_peak());
+
+#ifndef _WIN32
+    // Includes what is allocated outside of Cycles, e.g. by USD
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#    ifdef __APPLE__
+        const size_t peakRss = static_cast<size_t>(usage.ru_maxrss);
+#    else
+        const size_t peakRss = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#    endif
+        stats["hdcycles:memory:process_peak"] = VtValue(peakRss);
+    }
+#endif
+
+    // - Timings, in seconds
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+
+    stats["hdcycles:time:commit"]       = VtValue(m_commitTime);
+    stats["hdcycles:time:last_commit"]  = VtValue(m_lastCommitTime);
+    stats["hdcycles:time:scene_update"] = VtValue(m_sceneUpdateTime);
+    stats["hdcycles:time:first_sync"]   = VtValue(m_firstSyncTime);
+    stats["hdcycles:time:first_pixel"]  = VtValue(m_firstPixelTime);
+    stats["hdcycles:time:kernel_load"]  = VtValue(m_kernelLoadTime);
+
+    for (const auto& entry : m_syncStats) {
+        const std::string prefix = "hdcycles:sync:" + entry.first;
+        const SyncStat& stat     = entry.second;
+
+        stats[prefix + ":time"]  = VtValue(stat.time);
+        stats[prefix + ":count"] = VtValue(stat.count);
+        stats[prefix + ":prims_per_second"] = VtValue(
+            stat.time > 0.0 ? stat.count / stat.time : 0.0);
+
+        if (stat.elements > 0) {
+            stats[prefix + ":elements"] = VtValue(stat.elements);
+            stats[prefix + ":elements_per_second"] = VtValue(
+                stat.time > 0.0 ? stat.elements / stat.time : 0.0);
+        }
+    }
+
+    return stats;
+}
+
+bool
+HdCyclesRenderParam::WriteRenderStats(const std::string& a_path) const
+{
+    JsObject object;
+
+    for (const auto& entry : GetRenderStats()) {
+        const VtValue& value = entry.second;
+
+        if (value.IsHolding<double>()) {
+            object[entry.first] = JsValue(value.UncheckedGet<double>());
+        } else if (value.IsHolding<float>()) {
+            object[entry.first] = JsValue(
+                static_cast<double>(value.UncheckedGet<float>()));
+        } else if (value.IsHolding<int>()) {
+            object[entry.first] = JsValue(value.UncheckedGet<int>());
+        } else if (value.IsHolding<size_t>()) {
+            object[entry.first] = JsValue(
+                static_cast<uint64_t>(value.UncheckedGet<size_t>()));
+        } else if (value.IsHolding<std::string>()) {
+            object[entry.first] = JsValue(value.UncheckedGet<std::string>());
+        }
+    }
+
+    std::ofstream file(a_path);
+    if (!file) {
+        TF_WARN("Couldn't write render stats to %s", a_path.c_str());
+        return false;
+    }
+
+    JsWriteToStream(JsValue(object), file);
+    file << std::endl;
+
+    return true;
+}
+
+void
+HdCyclesRenderParam::AddSyncTime(const TfToken& a_primType, double a_seconds,
+                                 size_t a_elements)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+
+    SyncStat& stat = m_syncStats.emplace(a_primType.GetString(),
+                                         SyncStat { 0.0, 0, 0 })
+                         .first->second;
+    stat.time += a_seconds;
+    stat.count += 1;
+    stat.elements += a_elements;
+}
+
+HdCyclesSyncTimer::HdCyclesSyncTimer(HdCyclesRenderParam* a_param,
+                                     const TfToken& a_primType)
+    : m_param(a_param)
+    , m_primType(a_primType)
+    , m_start(ccl::time_dt())
+    , m_elements(0)
+{
+}
+
+HdCyclesSyncTimer::~HdCyclesSyncTimer()
+{
+    if (m_param)
+        m_param->AddSyncTime(m_primType, ccl::time_dt() - m_start,
+                             m_elements);
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -22,25 +22,45 @@
 
 #include "api.h"
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <device/device.h>
 #include <render/buffers.h>
 #include <render/camera.h>
 #include <render/session.h>
 #include <render/tile.h>
 
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/imaging/hd/changeTracker.h>
 #include <pxr/imaging/hd/renderDelegate.h>
 #include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
 
 namespace ccl {
 class Session;
 class Scene;
 class Mesh;
+class Hair;
+class Geometry;
+class Light;
+class Object;
 class RenderTile;
 class Shader;
 }  // namespace ccl
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+class HdCyclesGeometryCache;
+class HdCyclesRenderBuffer;
+class HdCyclesTileWriter;
+
 /**
  * @brief The proposed main interface to the cycles session and scene
  * Very much under construction.
@@ -58,7 +78,7 @@ public:
      * @brief Destroy the HdCycles Render Param object
      * 
      */
-    ~HdCyclesRenderParam() = default;
+    ~HdCyclesRenderParam();
 
     /**
      * @brief Start cycles render session
@@ -121,13 +141,12 @@ public:
      * @brief Key access point to set a HdCycles render setting via key and value
      * Handles SessionParams, SceneParams, Integrator, Film, and Background intelligently.
      * 
-     * This has some inherent performance overheads (runs multiple times, unecessary)
-     * however for now, this works the most clearly due to Cycles restrictions
+     * Values equal to the applied ones are ignored, changes are queued and
+     * applied together in CommitResources, followed by a single reset.
      * 
      * @param key 
      * @param value 
-     * @return true 
-     * @return false 
+     * @return Returns true if the setting changed
      */
     bool SetRenderSetting(const TfToken& key, const VtValue& valuekey);
 
@@ -145,13 +164,30 @@ protected:
      */
     void _CyclesExit();
 
+    /**
+     * @brief Join the session thread if it already finished its frame.
+     * Background sessions end their thread once all tiles are rendered,
+     * the next frame restarts it on the same session so the device,
+     * kernels, images and unchanged BVHs carry over. Must be called without
+     * the scene mutex held.
+     * 
+     * @return Returns true if the session has to be started again after
+     * the reset
+     */
+    bool _JoinFinishedSession();
+
     /**
      * @brief Callback when cycles session updated
      * 
      */
     void _SessionUpdateCallback();
 
-    void _WriteRenderTile(ccl::RenderTile& rtile);
+    /**
+     * @brief Copy a tile into the bound render buffers, only finished tiles
+     * are streamed to the tile output file
+     *
+     */
+    void _WriteRenderTile(ccl::RenderTile& rtile, bool a_finished);
     void _UpdateRenderTile(ccl::RenderTile& rtile, bool highlight);
 
 public:
@@ -162,21 +198,87 @@ public:
     };
 
     /**
-     * @brief Cycles general reset
+     * @brief Kinds of scene change, decides which Cycles managers
+     * CyclesReset tags and whether geometry BVHs are rebuilt or refit
+     *
+     */
+    enum SceneChange : uint32_t {
+        SceneChangeNone      = 0,
+        SceneChangeGeometry  = 1 << 0,  ///< Geometry added, removed or remeshed
+        SceneChangeDeform    = 1 << 1,  ///< Geometry points moved, BVH refit
+        SceneChangeTransform = 1 << 2,  ///< Object transforms or flags only
+        SceneChangeObjects   = 1 << 3,  ///< Objects added or removed
+        SceneChangeLights    = 1 << 4,
+        SceneChangeShaders   = 1 << 5,
+        SceneChangeBvh       = 1 << 6,  ///< BVH settings, rebuild everything
+    };
+
+    /**
+     * @brief Record the kind of change a prim made to the Cycles scene,
+     * consumed by the next CyclesReset
+     *
+     * @param a_changes Bitmask of SceneChange
+     */
+    void TagSceneChange(uint32_t a_changes)
+    {
+        m_sceneChanges.fetch_or(a_changes);
+    }
+
+    /**
+     * @brief Tag the Cycles managers for the accumulated scene changes and
+     * request a session reset
      * 
      * @param a_forceUpdate Should force update of cycles managers
      */
     void CyclesReset(bool a_forceUpdate = false);
 
     /**
-     * @brief Set "viewport" based on width and height
-     * TODO: Add support for render regions
+     * @brief Request a session reset. All requests of a Hydra frame are
+     * applied together by FlushReset, so Cycles restarts from the first
+     * sample once instead of once per change.
+     * 
+     */
+    void RequestReset() { m_resetPending = true; }
+
+    /**
+     * @brief Apply a pending reset and resume the render, called once per
+     * render pass execution. Also leaves navigation mode once the camera
+     * rested for long enough.
+     * 
+     */
+    void FlushReset();
+
+    /**
+     * @brief Enter navigation mode, interactive sessions only render the
+     * progressive start resolution passes and the navigation samples until
+     * the camera rests, then refine to the full sample count without
+     * another reset
+     * 
+     */
+    void BeginNavigation();
+
+    /**
+     * @brief Set "viewport" based on width and height, requests a reset
      * 
      * @param w Width of new render
      * @param h Height of new render
      */
     void SetViewport(int w, int h);
 
+    /**
+     * @brief Only render a region of the viewport, requests a reset
+     * 
+     * @param a_region Normalized (xmin, ymin, xmax, ymax) of the region,
+     * (0, 0, 1, 1) renders everything
+     */
+    void SetRenderRegion(const GfVec4f& a_region);
+
+    /**
+     * @brief Get the normalized region being rendered
+     * 
+     */
+    const GfVec4f& GetRenderRegion() const { return m_renderRegion; }
+
     /**
      * @brief Slightly hacky workaround to directly reset the session
      * 
@@ -207,6 +309,12 @@ public:
     /**
      * @brief Set Cycles render device type
      * 
+     * Accepts a single device type ("CPU", "CUDA", ...) which uses the first
+     * device of that type, or device terms joined by '+'. A term can select
+     * devices with ':' followed by '*' for all of them or a comma separated
+     * list of indices, e.g. "CUDA:*", "OPTIX:0,1" or "CUDA:*+CPU". Several
+     * devices are combined into a Cycles multi device.
+     * 
      * @param a_deviceType Device type as string
      * @param params Specific params
      * @return Returns true if could set the device type
@@ -224,6 +332,12 @@ public:
 
     /* ====== HdCycles Settings ====== */
 
+    // Scene edits are not applied immediately. They are queued, and can
+    // safely be queued from parallel prim syncs. CommitResources applies
+    // them in one batch. Removed items are owned by the render param from
+    // then on and are freed once they have been taken out of the scene, so
+    // callers must not delete them.
+
     /**
      * @brief Add light to scene
      * 
@@ -267,40 +381,176 @@ public:
     void AddObject(ccl::Object* a_object);
 
     /**
-     * @brief Remove hair geometry from cycles scene
+     * @brief Remove hair geometry from cycles scene, takes ownership
      * 
      * @param a_hair Hair to remove
      */
     void RemoveCurve(ccl::Hair* a_hair);
 
     /**
-     * @brief Remove light from cycles scene
+     * @brief Remove light from cycles scene, takes ownership
      * 
      * @param a_light Light to remove
      */
     void RemoveLight(ccl::Light* a_light);
 
     /**
-     * @brief Remove shader from cycles scene
+     * @brief Remove shader from cycles scene, takes ownership
      * 
      * @param a_shader Shader to remove
      */
     void RemoveShader(ccl::Shader* a_shader);
 
     /**
-     * @brief Remove mesh geometry from cycles scene
+     * @brief Resolve the shared shader for a material network hash
+     *
+     * If a_current is only used by the caller and no other shader was built
+     * for a_hash it is rekeyed to a_hash and returned for an in place
+     * rebuild. Otherwise the reference to a_current is dropped and a shader
+     * already built for an identical network is returned with a reference
+     * taken. Returns nullptr when no such shader
+     * exists, the caller then builds one and passes it to RegisterShader.
+     *
+     * @param a_hash Content hash of the material network and settings
+     * @param a_current Shader currently held by the caller, can be null
+     * @param a_needsBuild Set when the returned shader needs its graph built
+     * @return Shader to use or nullptr
+     */
+    ccl::Shader* AcquireShader(size_t a_hash, ccl::Shader* a_current,
+                               bool* a_needsBuild);
+
+    /**
+     * @brief Register a newly built shader for a material network hash and
+     * add it to the scene. If an identical shader was registered meanwhile
+     * a reference to that one is returned instead and the caller keeps
+     * ownership of a_shader.
+     *
+     * @param a_hash Content hash of the material network and settings
+     * @param a_shader Shader built by the caller
+     * @return Shader to use
+     */
+    ccl::Shader* RegisterShader(size_t a_hash, ccl::Shader* a_shader);
+
+    /**
+     * @brief Drop a reference from AcquireShader or RegisterShader, the
+     * shader is removed from the scene with its last reference
+     *
+     * @param a_shader Shader to release
+     */
+    void ReleaseShader(ccl::Shader* a_shader);
+
+    /**
+     * @brief Remove mesh geometry from cycles scene, takes ownership
      * 
      * @param a_mesh Mesh to remove
      */
     void RemoveMesh(ccl::Mesh* a_mesh);
 
     /**
-     * @brief Remove object from cycles scene
+     * @brief Remove object from cycles scene, takes ownership
      * 
      * @param a_object Object to remove
      */
     void RemoveObject(ccl::Object* a_object);
 
+    /**
+     * @brief Remove geometry of any type from cycles scene, takes ownership
+     * 
+     * @param a_geometry Geometry to remove
+     */
+    void RemoveGeometry(ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Add geometry to the scene that can later be shared with other
+     * prims through ShareGeometry, holds one reference for the caller
+     *
+     * @param a_geometry Geometry to add
+     */
+    void RegisterGeometry(ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Share geometry with prims that built identical content
+     *
+     * a_geometry must only be held by the caller. If a geometry with the
+     * same content hash exists a reference to it is returned and a_geometry
+     * is released, otherwise a_geometry is listed under a_hash.
+     *
+     * @param a_hash Content hash of a_geometry
+     * @param a_geometry Geometry the caller just built
+     * @return Geometry to use
+     */
+    ccl::Geometry* ShareGeometry(size_t a_hash, ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Prepare geometry for an in place edit
+     *
+     * @param a_geometry Geometry the caller wants to edit
+     * @return False when other prims share it, the caller must then register
+     * and switch to its own copy instead
+     */
+    bool UnshareGeometry(ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Drop a reference from RegisterGeometry or ShareGeometry, the
+     * geometry is removed from the scene with its last reference
+     *
+     * @param a_geometry Geometry to release
+     */
+    void ReleaseGeometry(ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Cache of converted meshes, null when disabled
+     *
+     */
+    const HdCyclesGeometryCache* GetGeometryCache() const
+    {
+        return m_geometryCache.get();
+    }
+
+    /**
+     * @brief Camera prim subdivision is diced from, empty when dicing
+     * follows the render camera
+     *
+     */
+    const SdfPath& GetDicingCamera() const { return m_dicingCamera; }
+
+    /**
+     * @brief Distance the dicing camera or a mesh has to move before the
+     * mesh is diced again, negative never re-dices for movement
+     *
+     */
+    float GetDicingThreshold() const { return m_dicingThreshold; }
+
+    /**
+     * @brief Sync the scene dicing camera after a camera changed
+     *
+     * The fixed dicing camera applies its settings to the scene dicing
+     * camera and passes null. The render camera is passed in and only
+     * followed when no dicing camera is set.
+     *
+     * @param a_renderCamera Render camera, can be null
+     */
+    void UpdateDicingCamera(const ccl::Camera* a_renderCamera = nullptr);
+
+    /**
+     * @brief Track a mesh that was just diced, so it is diced again when
+     * the dicing camera moves or the face budget changes. Safe to call from
+     * parallel prim syncs.
+     *
+     * @param a_id Prim the mesh belongs to
+     * @param a_mesh Mesh with subdivision params
+     * @param a_maxLevel Max subdivision level the prim asks for
+     */
+    void RegisterSubdivMesh(const SdfPath& a_id, ccl::Mesh* a_mesh,
+                            int a_maxLevel);
+
+    /**
+     * @brief Stop tracking the subdivided mesh of a prim
+     *
+     * @param a_id Prim the mesh belongs to
+     */
+    void UnregisterSubdivMesh(const SdfPath& a_id);
+
 private:
     bool _CreateSession();
 
@@ -346,8 +596,127 @@ private:
     bool _HandleBackgroundRenderSetting(const TfToken& key,
                                         const VtValue& value);
 
+    /**
+     * @brief Route a setting to the handlers listed for its key
+     *
+     * @return Returns true if any handler applied the setting
+     */
+    bool _ApplyRenderSetting(const TfToken& key, const VtValue& value);
+
+    /**
+     * @brief Apply the settings queued by SetRenderSetting
+     *
+     * @return Returns true if anything was applied
+     */
+    bool _ApplyPendingRenderSettings();
+
+    enum RenderSettingHandler {
+        HandlerDelegate   = 1 << 0,
+        HandlerSession    = 1 << 1,
+        HandlerScene      = 1 << 2,
+        HandlerIntegrator = 1 << 3,
+        HandlerFilm       = 1 << 4,
+        HandlerBackground = 1 << 5,
+    };
+
+    // Guards the settings below, which Hydra sets between syncs
+    std::mutex m_settingsMutex;
+    std::map<TfToken, VtValue> m_pendingSettings;
+    std::unordered_map<TfToken, VtValue, TfToken::HashFunctor>
+        m_appliedSettings;
+
     void _HandlePasses();
 
+    /**
+     * @brief Sync the film and integrator with the session adaptive sampling
+     *
+     */
+    void _HandleAdaptiveSampling();
+
+    /**
+     * @brief Pick the interactive denoiser for the session device,
+     * disables denoising when the device supports none
+     *
+     * @param a_params Session params with the device set
+     */
+    void _SelectDenoiser(ccl::SessionParams& a_params);
+
+    /**
+     * @brief Load the render kernels of the new session on a background
+     * thread, so device bring-up overlaps with the first scene sync
+     *
+     */
+    void _LoadKernelsAsync();
+
+    /**
+     * @brief Wait until the kernels started by _LoadKernelsAsync are loaded.
+     * Must be called before the session starts.
+     *
+     */
+    void _WaitForKernels();
+
+    std::thread m_kernelThread;
+
+    /**
+     * @brief Start the tile output file for the frame about to render, when
+     * tiled rendering streams to one
+     *
+     */
+    void _OpenTileOutput();
+
+    std::string m_tileOutputFile;
+    std::unique_ptr<HdCyclesTileWriter> m_tileWriter;
+
+    std::unique_ptr<HdCyclesGeometryCache> m_geometryCache;
+
+    /**
+     * @brief Resume the frame about to be reset from the checkpoint when
+     * it matches, otherwise render it from the first sample
+     *
+     */
+    void _PrepareCheckpointResume();
+
+    /**
+     * @brief Add the resumed samples once the session rendered its first
+     * sample and write a checkpoint when one is due. Called from the Hydra
+     * thread, it waits for the sample being rendered and holds the session
+     * between two samples while it reads or adds to the buffers.
+     *
+     * @param a_final Write the last checkpoint, when the render stops
+     */
+    void _UpdateCheckpoint(bool a_final);
+
+    bool _ReadCheckpoint();
+    bool _WriteCheckpoint(int a_samples);
+
+    // Progressive renders only, the accumulated buffers of tiled renders
+    // are released with their tiles
+    std::string m_checkpointFile;
+    double m_checkpointInterval;
+    double m_checkpointTime;
+    bool m_checkpointRead;
+
+    // Checkpoint read from disk and whether its samples were added
+    std::vector<int> m_checkpointPasses;
+    std::vector<float> m_checkpointData;
+    int m_checkpointWidth;
+    int m_checkpointHeight;
+    int m_checkpointSamples;
+    bool m_checkpointRestored;
+
+    // Sample the current frame resumed at, and the last one written
+    int m_resumeSample;
+    int m_checkpointWrittenSamples;
+    int m_defaultRangeStart;
+    int m_defaultRangeSamples;
+
+    /**
+     * @brief Resolve the bound AOVs to the Cycles passes they are read from,
+     * so tile writes don't search for them
+     * 
+     */
+    void _ResolveAovPassBindings();
+
     /**
      * @brief Initialize member values based on config
      * TODO: Refactor this
@@ -358,6 +727,28 @@ private:
     bool _SetDevice(const ccl::DeviceType& a_deviceType,
                     ccl::SessionParams& params);
 
+    /**
+     * @brief Use the given devices, several are combined into a multi device
+     * 
+     * @return Returns true if there was at least one device
+     */
+    bool _SetDevices(const std::vector<ccl::DeviceInfo>& a_devices,
+                     ccl::SessionParams& params);
+
+    /**
+     * @brief Apply all queued scene edits under a single scene lock and
+     * free removed items
+     * 
+     * @return true if any edits were applied
+     */
+    bool _ApplyPendingEdits();
+
+    /**
+     * @brief Free queued removals without touching the scene
+     * 
+     */
+    void _FreePendingRemovals();
+
     ccl::SessionParams m_sessionParams;
     ccl::SceneParams m_sceneParams;
     ccl::BufferParams m_bufferParams;
@@ -373,22 +764,143 @@ private:
 
     bool m_useTiledRendering;
 
-    bool m_aovBindingsNeedValidation;
-
     int m_width;
     int m_height;
 
-    bool m_objectsUpdated;
-    bool m_geometryUpdated;
-    bool m_curveUpdated;
-    bool m_meshUpdated;
-    bool m_lightsUpdated;
-    bool m_shadersUpdated;
+    // SceneChange bits accumulated since the last CyclesReset
+    std::atomic<uint32_t> m_sceneChanges;
+
+    std::atomic<bool> m_shouldUpdate;
+
+    bool m_sessionStarted;
+
+    std::atomic<bool> m_resetPending;
+
+    // Navigation mode, the full sample count is restored once the camera
+    // rested for navigation_debounce seconds
+    std::atomic<bool> m_navigating;
+    double m_navigationTime;
+    int m_navigationFullSamples;
+
+    std::mutex m_pendingMutex;
+    std::vector<ccl::Object*> m_pendingAddObjects;
+    std::vector<ccl::Object*> m_pendingRemoveObjects;
+    std::vector<ccl::Geometry*> m_pendingAddGeometry;
+    std::vector<ccl::Geometry*> m_pendingRemoveGeometry;
+    std::vector<ccl::Light*> m_pendingAddLights;
+    std::vector<ccl::Light*> m_pendingRemoveLights;
+    std::vector<ccl::Shader*> m_pendingAddShaders;
+    std::vector<ccl::Shader*> m_pendingRemoveShaders;
+
+    // Item to slot index for the pending adds and for the Cycles scene
+    // vectors, so removal is a swap with the last item instead of a scan.
+    // Only items added through the render param are tracked.
+    std::unordered_map<ccl::Object*, size_t> m_pendingObjectSlots;
+    std::unordered_map<ccl::Geometry*, size_t> m_pendingGeometrySlots;
+    std::unordered_map<ccl::Light*, size_t> m_pendingLightSlots;
+    std::unordered_map<ccl::Shader*, size_t> m_pendingShaderSlots;
+
+    std::unordered_map<ccl::Object*, size_t> m_objectSlots;
+    std::unordered_map<ccl::Geometry*, size_t> m_geometrySlots;
+    std::unordered_map<ccl::Light*, size_t> m_lightSlots;
+    std::unordered_map<ccl::Shader*, size_t> m_shaderSlots;
+
+    // Material shaders and geometry shared between prims with identical
+    // content, keyed by the content hash they were built from. Items not
+    // in the hash map are only tracked for their references.
+    struct SharedItem {
+        size_t hash;
+        int refCount;
+    };
+    std::mutex m_sharedMutex;
+    std::unordered_map<ccl::Shader*, SharedItem> m_sharedShaders;
+    std::unordered_map<size_t, ccl::Shader*> m_sharedShaderHashes;
+    std::unordered_map<ccl::Geometry*, SharedItem> m_sharedGeometry;
+    std::unordered_map<size_t, ccl::Geometry*> m_sharedGeometryHashes;
+
+    void _ReleaseShader(ccl::Shader* a_shader);
+    void _ReleaseGeometry(ccl::Geometry* a_geometry);
+
+    /**
+     * @brief Fit the registered meshes into the face budget and mark the
+     * ones whose dice is out of date for a re-sync
+     *
+     */
+    void _UpdateDicing(HdChangeTracker* a_tracker);
+
+    // Subdivided meshes with the state their dice was made with. Entries
+    // are re-registered undiced whenever the prim rebuilds its mesh.
+    struct SubdivMesh {
+        ccl::Mesh* mesh;
+        int maxLevel;
+        int dicedLevel;
+        bool diced;
+        SdfPath camera;
+        ccl::float3 cameraPosition;
+    };
+    std::mutex m_subdivMutex;
+    std::unordered_map<SdfPath, SubdivMesh, SdfPath::Hash> m_subdivMeshes;
 
-    bool m_shouldUpdate;
+    SdfPath m_dicingCamera;
+    float m_dicingThreshold;
+    int m_subdivFaceBudget;
+
+    /**
+     * @brief Restart the per render timings after a session reset
+     * 
+     */
+    void _MarkReset();
+
+    struct SyncStat {
+        double time;
+        size_t count;
+        size_t elements;
+    };
+
+    // Guards everything below, written from prim syncs, CommitResources
+    // and the session thread
+    mutable std::mutex m_statsMutex;
+    std::map<std::string, SyncStat> m_syncStats;
+    double m_commitTime;
+    double m_lastCommitTime;
+    double m_resetTime;
+    double m_sceneUpdateTime;
+    // Since the render param was created, 0 until reached
+    double m_createTime;
+    double m_firstSyncTime;
+    double m_firstPixelTime;
+    double m_kernelLoadTime;
+    bool m_waitingForFirstSample;
+    bool m_statsWritten;
 
     int m_numDomeLights;
 
+    // Backgrounds without dome lights, with and without other lights
+    ccl::Shader* m_defaultBackground;
+    ccl::Shader* m_emptyBackground;
+
+    /**
+     * @brief Create a default background shader and add it to the scene
+     *
+     * @param a_emissive Grey emissive background, black otherwise
+     * @return The shader, owned by the scene
+     */
+    ccl::Shader* _CreateDefaultBackgroundShader(bool a_emissive);
+
+    // Normalized (xmin, ymin, xmax, ymax) of the viewport being rendered
+    GfVec4f m_renderRegion;
+
+    /**
+     * @brief Map the viewport size and render region to the buffer params
+     * 
+     */
+    void _UpdateBufferParams();
+
+    // Band of the render region this process renders in distributed tiled
+    // renders
+    int m_bucketCount;
+    int m_bucketIndex;
+
     bool m_useSquareSamples;
 
     UpAxis m_upAxis;
@@ -396,7 +908,7 @@ private:
 public:
     const bool& IsTiledRender() const { return m_useTiledRendering; }
 
-    void CommitResources();
+    void CommitResources(HdChangeTracker* a_tracker);
     /**
      * @brief Get the active Cycles Session 
      * 
@@ -418,8 +930,31 @@ public:
      */
     ccl::Shader* default_vcol_surface;
 
+    /**
+     * @brief Snapshot of the render stats, safe to call during a render
+     * 
+     */
     VtDictionary GetRenderStats() const;
 
+    /**
+     * @brief Write GetRenderStats as JSON
+     * 
+     * @param a_path File to write
+     * @return Returns true if the file was written
+     */
+    bool WriteRenderStats(const std::string& a_path) const;
+
+    /**
+     * @brief Add time spent syncing one prim, safe to call from parallel
+     * syncs. See HdCyclesSyncTimer.
+     * 
+     * @param a_primType Type of the synced prim
+     * @param a_seconds Time spent
+     * @param a_elements Elements processed, e.g. triangles or pixels
+     */
+    void AddSyncTime(const TfToken& a_primType, double a_seconds,
+                     size_t a_elements = 0);
+
     /**
      * @brief Get the up-axis that is set.
      * 
@@ -433,11 +968,25 @@ private:
 
     HdRenderPassAovBindingVector m_aovs;
 
+    struct AovPassBinding {
+        HdCyclesRenderBuffer* renderBuffer;
+        std::string passName;
+        HdFormat format;
+        int numComponents;
+    };
+    using AovPassBindings = std::vector<AovPassBinding>;
+
+    // Swapped atomically, tile callbacks keep the bindings they started with
+    std::shared_ptr<const AovPassBindings> m_aovPassBindings;
+
+    /**
+     * @brief Passes of the supported AOVs that are bound, in pass order
+     *
+     */
+    std::vector<ccl::PassType> _GetBoundAovPasses() const;
+
 public:
-    void SetAovBindings(HdRenderPassAovBindingVector const& a_aovs)
-    {
-        m_aovs = a_aovs;
-    }
+    void SetAovBindings(HdRenderPassAovBindingVector const& a_aovs);
 
     HdRenderPassAovBindingVector const& GetAovBindings() const
     {
@@ -445,6 +994,32 @@ public:
     }
 };
 
+/**
+ * @brief Adds the time until it goes out of scope to the sync time of a
+ * prim type
+ * 
+ */
+class HdCyclesSyncTimer {
+public:
+    HdCyclesSyncTimer(HdCyclesRenderParam* a_param, const TfToken& a_primType);
+    ~HdCyclesSyncTimer();
+
+    /**
+     * @brief Count elements processed in this scope, reported as throughput
+     * next to the time: triangles for meshes, segments for curves, points,
+     * instances and pixels for blits
+     * 
+     * @param a_count Number of elements
+     */
+    void AddElements(size_t a_count) { m_elements += a_count; }
+
+private:
+    HdCyclesRenderParam* m_param;
+    TfToken m_primType;
+    double m_start;
+    size_t m_elements;
+};
+
 PXR_NAMESPACE_CLOSE_SCOPE
 
 #endif  // HD_CYCLES_RENDER_PARAM_H
@@ -24,6 +24,8 @@
 #include "renderParam.h"
 #include "utils.h"
 
+#include <cmath>
+
 #include <render/camera.h>
 #include <render/scene.h>
 #include <render/session.h>
@@ -39,6 +41,7 @@ PXR_NAMESPACE_OPEN_SCOPE
 TF_DEFINE_PRIVATE_TOKENS(_tokens, 
     (color)
     (depth)
+    (blit)
 );
 // clang-format on
 
@@ -107,9 +110,12 @@ HdCyclesRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState,
             active_camera->type = ccl::CameraType::CAMERA_PERSPECTIVE;
 
         active_camera->tag_update();
+        renderParam->UpdateDicingCamera(active_camera);
 
-        // DirectReset here instead of Interrupt for faster IPR camera orbits
-        renderParam->DirectReset();
+        // Reset directly instead of Interrupt for faster IPR camera orbits,
+        // without waiting for the next commit
+        renderParam->BeginNavigation();
+        renderParam->RequestReset();
     }
 
     const auto width     = static_cast<int>(vp[2]);
@@ -134,13 +140,15 @@ HdCyclesRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState,
             renderParam->StartRender();
         }
 
-        renderParam->Interrupt();
-
         if (numPixels != oldNumPixels) {
             resized = true;
         }
     }
 
+    // One reset for the scene edits of this frame, the camera and the
+    // viewport together
+    renderParam->FlushReset();
+
     // Tiled renders early out because we do the blitting on render tile callback
     if (renderParam->IsTiledRender())
         return;
@@ -189,8 +197,22 @@ HdCyclesRenderPass::_Execute(HdRenderPassStateSharedPtr const& renderPassState,
             // fail (Probably can be fixed with proper render thread management)
             if (!rb->WasUpdated()) {
                 if (aov.aovName == HdAovTokens->color) {
-                    rb->Blit(colorFormat, w, h, 0, w,
-                             reinterpret_cast<uint8_t*>(hpixels));
+                    // The display only holds the render region
+                    const GfVec4f& region = renderParam->GetRenderRegion();
+                    const float rbWidth   = float(rb->GetWidth());
+                    const float rbHeight  = float(rb->GetHeight());
+
+                    const unsigned int x0 = std::floor(region[0] * rbWidth);
+                    const unsigned int y0 = std::floor(region[1] * rbHeight);
+                    const unsigned int x1 = std::ceil(region[2] * rbWidth);
+                    const unsigned int y1 = std::ceil(region[3] * rbHeight);
+
+                    HdCyclesSyncTimer blitTimer(renderParam, _tokens->blit);
+                    blitTimer.AddElements(size_t(x1 - x0) * (y1 - y0));
+
+                    rb->BlitRegion(colorFormat, x0, y0, x1 - x0, y1 - y0, w,
+                                   h, 0, w,
+                                   reinterpret_cast<uint8_t*>(hpixels));
                 }
             } else {
                 rb->SetWasUpdated(false);
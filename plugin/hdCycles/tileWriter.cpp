@@ -0,0 +1,340 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "tileWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <render/buffers.h>
+
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/imaging/hd/perfLog.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Tiles finished ahead of the writer before the Cycles threads wait
+constexpr size_t _kMaxQueuedTiles = 32;
+
+std::vector<std::string>
+_ChannelNames(const std::vector<HdCyclesTileWriter::Pass>& a_passes)
+{
+    static const char* components[] = { "R", "G", "B", "A" };
+
+    std::vector<std::string> names;
+    for (const HdCyclesTileWriter::Pass& pass : a_passes) {
+        if (pass.numComponents == 1) {
+            names.push_back(pass.name);
+            continue;
+        }
+
+        // The beauty is the unlayered RGBA a viewer shows first
+        const bool beauty = pass.name == "Combined";
+
+        for (int c = 0; c < pass.numComponents && c < 4; ++c) {
+            names.push_back(beauty ? components[c]
+                                   : pass.name + "." + components[c]);
+        }
+    }
+    return names;
+}
+
+}  // namespace
+
+HdCyclesTileWriter::HdCyclesTileWriter()
+    : m_stopping(false)
+    , m_numChannels(0)
+    , m_padRows(0)
+    , m_numWritten(0)
+{
+}
+
+HdCyclesTileWriter::~HdCyclesTileWriter() { Close(); }
+
+bool
+HdCyclesTileWriter::Open(const std::string& a_path,
+                         const ccl::BufferParams& a_params,
+                         const ccl::int2& a_tileSize,
+                         const std::vector<Pass>& a_passes,
+                         const std::string& a_compression)
+{
+    HD_TRACE_FUNCTION();
+
+    Close();
+
+    if (a_passes.empty() || a_tileSize.x <= 0 || a_tileSize.y <= 0)
+        return false;
+
+    std::unique_ptr<OIIO::ImageOutput> output = OIIO::ImageOutput::create(
+        a_path);
+    if (!output) {
+        TF_RUNTIME_ERROR("Can't write tiles to '%s': %s", a_path.c_str(),
+                         OIIO::geterror().c_str());
+        return false;
+    }
+
+    if (!output->supports("tiles") || !output->supports("random_access")) {
+        TF_RUNTIME_ERROR("Can't write tiles to '%s': %s doesn't support tiles "
+                         "in any order",
+                         a_path.c_str(), output->format_name());
+        return false;
+    }
+
+    const std::vector<std::string> channelNames = _ChannelNames(a_passes);
+
+    OIIO::ImageSpec spec(a_params.width, a_params.height,
+                         static_cast<int>(channelNames.size()),
+                         OIIO::TypeDesc::FLOAT);
+    spec.channelnames = channelNames;
+    spec.alpha_channel = -1;
+    if (channelNames.size() >= 4 && channelNames[3] == "A")
+        spec.alpha_channel = 3;
+
+    // Cycles counts rows from the bottom and clips its top tile row, EXR
+    // counts from the top and clips its bottom one. The data window is
+    // padded above the region, so flipped Cycles tiles land on EXR tiles.
+    const int padRows = (a_tileSize.y - a_params.height % a_tileSize.y)
+                        % a_tileSize.y;
+
+    spec.height      = a_params.height + padRows;
+    spec.x           = a_params.full_x;
+    spec.y           = a_params.full_height - a_params.full_y
+                       - a_params.height - padRows;
+    spec.full_x      = 0;
+    spec.full_y      = 0;
+    spec.full_width  = a_params.full_width;
+    spec.full_height = a_params.full_height;
+
+    spec.tile_width  = a_tileSize.x;
+    spec.tile_height = a_tileSize.y;
+    spec.tile_depth  = 1;
+
+    spec.attribute("compression", a_compression);
+    spec.attribute("openexr:lineOrder", "randomY");
+
+    if (!output->open(a_path, spec)) {
+        TF_RUNTIME_ERROR("Can't write tiles to '%s': %s", a_path.c_str(),
+                         output->geterror().c_str());
+        return false;
+    }
+
+    const size_t tilesX = (spec.width + spec.tile_width - 1) / spec.tile_width;
+    const size_t tilesY = (spec.height + spec.tile_height - 1)
+                          / spec.tile_height;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_output      = std::move(output);
+    m_path        = a_path;
+    m_spec        = spec;
+    m_params      = a_params;
+    m_passes      = a_passes;
+    m_numChannels = static_cast<int>(channelNames.size());
+    m_padRows     = padRows;
+    m_written.assign(tilesX * tilesY, false);
+    m_numWritten = 0;
+    m_stopping   = false;
+
+    m_thread = std::thread(&HdCyclesTileWriter::_WriterLoop, this);
+
+    return true;
+}
+
+bool
+HdCyclesTileWriter::IsOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_output != nullptr;
+}
+
+void
+HdCyclesTileWriter::WriteTile(const ccl::RenderTile& a_tile, float a_exposure,
+                              int a_sample)
+{
+    HD_TRACE_FUNCTION();
+
+    std::vector<Pass> passes;
+    int numChannels = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_output || m_stopping)
+            return;
+        passes      = m_passes;
+        numChannels = m_numChannels;
+    }
+
+    Tile tile;
+    tile.x = a_tile.x;
+    tile.y = a_tile.y;
+    tile.w = a_tile.w;
+    tile.h = a_tile.h;
+
+    const size_t numPixels = static_cast<size_t>(tile.w * tile.h);
+    tile.pixels.resize(numPixels * numChannels);
+
+    // Passes are read one at a time and interleaved into the channels
+    thread_local std::vector<float> passData;
+
+    int channel = 0;
+    for (const Pass& pass : passes) {
+        const int numComponents = std::min(pass.numComponents, 4);
+        passData.resize(numPixels * numComponents);
+
+        if (!a_tile.buffers->get_pass_rect(pass.name.c_str(), a_exposure,
+                                           a_sample, numComponents,
+                                           passData.data())) {
+            std::fill(passData.begin(), passData.end(), 0.0f);
+        }
+
+        for (size_t i = 0; i < numPixels; ++i) {
+            std::memcpy(&tile.pixels[i * numChannels + channel],
+                        &passData[i * numComponents],
+                        numComponents * sizeof(float));
+        }
+        channel += numComponents;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_dequeued.wait(lock, [this]() {
+        return m_stopping || m_queue.size() < _kMaxQueuedTiles;
+    });
+    if (m_stopping || !m_output)
+        return;
+
+    m_queue.push_back(std::move(tile));
+    m_queued.notify_one();
+}
+
+void
+HdCyclesTileWriter::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queued.notify_all();
+    m_dequeued.notify_all();
+
+    // Drains the queue before it exits
+    if (m_thread.joinable())
+        m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_output) {
+        if (m_numWritten > 0 && m_numWritten < m_written.size()) {
+            TF_WARN("Closing '%s' with %zu of %zu tiles written",
+                    m_path.c_str(), m_numWritten, m_written.size());
+        }
+        m_output->close();
+        m_output.reset();
+    }
+    m_queue.clear();
+}
+
+void
+HdCyclesTileWriter::_WriterLoop()
+{
+    for (;;) {
+        Tile tile;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.wait(lock,
+                          [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+
+            tile = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_dequeued.notify_one();
+
+        _WriteTile(tile);
+    }
+}
+
+void
+HdCyclesTileWriter::_WriteTile(const Tile& a_tile)
+{
+    HD_TRACE_FUNCTION();
+
+    // Only the writer thread touches the output until Close joins it
+    if (!m_output)
+        return;
+
+    const int tileW = m_spec.tile_width;
+    const int tileH = m_spec.tile_height;
+
+    // Top row of the tile counted from the top of the padded data window,
+    // only the clipped top tile row starts below its EXR tile
+    const int localX    = a_tile.x - m_params.full_x;
+    const int localY    = m_params.height - (a_tile.y - m_params.full_y)
+                          - a_tile.h + m_padRows;
+    const int rowOffset = localY % tileH;
+    const int tileY     = localY - rowOffset;
+
+    if (localX % tileW != 0 || localY < 0 || rowOffset + a_tile.h > tileH) {
+        TF_WARN("Skipping tile at %d %d, it is not on the tile grid of '%s'",
+                a_tile.x, a_tile.y, m_path.c_str());
+        return;
+    }
+
+    const size_t tilesX    = (m_spec.width + tileW - 1) / tileW;
+    const size_t pixelSize = m_numChannels * sizeof(float);
+
+    m_scratch.resize(static_cast<size_t>(tileW * tileH * m_numChannels));
+
+    for (int tx = 0; tx < a_tile.w; tx += tileW) {
+        const size_t index = (tileY / tileH) * tilesX + (localX + tx) / tileW;
+        if (index >= m_written.size() || m_written[index])
+            continue;
+
+        // Pixels past the tile edge and the rows above the region are padding
+        std::fill(m_scratch.begin(), m_scratch.end(), 0.0f);
+
+        const int cols = std::min(tileW, a_tile.w - tx);
+        for (int row = 0; row < a_tile.h; ++row) {
+            const int srcRow = a_tile.h - 1 - row;
+            std::memcpy(&m_scratch[(rowOffset + row) * tileW * m_numChannels],
+                        &a_tile.pixels[(srcRow * a_tile.w + tx)
+                                       * m_numChannels],
+                        cols * pixelSize);
+        }
+
+        if (!m_output->write_tile(m_spec.x + localX + tx, m_spec.y + tileY, 0,
+                                  OIIO::TypeDesc::FLOAT, m_scratch.data())) {
+            TF_RUNTIME_ERROR("Can't write tile to '%s': %s", m_path.c_str(),
+                             m_output->geterror().c_str());
+            continue;
+        }
+
+        m_written[index] = true;
+        ++m_numWritten;
+    }
+
+    // The frame is complete once every tile is in
+    if (m_numWritten == m_written.size()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_output->close();
+        m_output.reset();
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
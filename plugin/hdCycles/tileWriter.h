@@ -0,0 +1,133 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef HD_CYCLES_TILE_WRITER_H
+#define HD_CYCLES_TILE_WRITER_H
+
+#include "api.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <render/buffers.h>
+
+#include <OpenImageIO/imageio.h>
+
+#include <pxr/pxr.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * @brief Streams finished render tiles into a tiled EXR file
+ *
+ * Tiles are read from the Cycles buffers on the thread that finished them
+ * and queued. A single writer thread flips them to the top down EXR layout
+ * and compresses them, so memory is bounded by the queue and not the frame.
+ * All passes go into one part as layered channels. EXR tiles are as large
+ * as the Cycles tiles.
+ *
+ */
+class HdCyclesTileWriter {
+public:
+    struct Pass {
+        std::string name;
+        int numComponents;
+    };
+
+    HdCyclesTileWriter();
+    ~HdCyclesTileWriter();
+
+    /**
+     * @brief Start a new file for the frame of a_params, a file still open
+     * is closed first
+     *
+     * @param a_path File to write, the format must support tiles
+     * @param a_params Buffer of the frame
+     * @param a_tileSize Size of the Cycles tiles
+     * @param a_passes Passes to write, in channel order
+     * @param a_compression OpenImageIO compression name
+     * @return Returns true if the file was opened
+     */
+    bool Open(const std::string& a_path, const ccl::BufferParams& a_params,
+              const ccl::int2& a_tileSize, const std::vector<Pass>& a_passes,
+              const std::string& a_compression);
+
+    /**
+     * @brief Queue a finished tile, safe to call from the Cycles threads.
+     * Blocks while the queue is full.
+     *
+     * @param a_tile Finished tile with its buffers on the host
+     * @param a_exposure Film exposure
+     * @param a_sample Number of samples in the tile
+     */
+    void WriteTile(const ccl::RenderTile& a_tile, float a_exposure,
+                   int a_sample);
+
+    /**
+     * @brief Write the queued tiles and close the file. Tiles that were not
+     * rendered stay empty.
+     *
+     */
+    void Close();
+
+    bool IsOpen() const;
+
+private:
+    struct Tile {
+        int x, y, w, h;
+        std::vector<float> pixels;
+    };
+
+    void _WriterLoop();
+    void _WriteTile(const Tile& a_tile);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_dequeued;
+    std::deque<Tile> m_queue;
+    bool m_stopping;
+
+    std::thread m_thread;
+
+    std::unique_ptr<OIIO::ImageOutput> m_output;
+    std::string m_path;
+    OIIO::ImageSpec m_spec;
+    ccl::BufferParams m_params;
+    std::vector<Pass> m_passes;
+    int m_numChannels;
+
+    // Rows the data window extends above the region to keep the Cycles
+    // tiles on the EXR grid
+    int m_padRows;
+
+    // EXR tiles already written, a tile can't be written twice
+    std::vector<bool> m_written;
+    size_t m_numWritten;
+
+    std::vector<float> m_scratch;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif  // HD_CYCLES_TILE_WRITER_H
@@ -22,12 +22,21 @@
 #include "config.h"
 #include "mesh.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
 #include <render/nodes.h>
 #include <subd/subd_dice.h>
 #include <subd/subd_split.h>
 #include <util/util_path.h>
 
+#include <pxr/base/arch/fileSystem.h>
 #include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/work/loops.h>
 #include <pxr/imaging/hd/extComputationUtils.h>
 #include <pxr/usd/sdf/assetPath.h>
 
@@ -61,6 +70,30 @@ HdCyclesPathIsUDIM(const ccl::string& a_filepath)
 void
 HdCyclesParseUDIMS(const ccl::string& a_filepath, ccl::vector<int>& a_tiles)
 {
+    // Every material using a UDIM set scans its directory, on texture heavy
+    // assets that is thousands of scans of the same few directories. The
+    // result is kept until the directory changes.
+    struct TileEntry {
+        double modificationTime;
+        ccl::vector<int> tiles;
+    };
+    static std::mutex s_tileMutex;
+    static std::unordered_map<std::string, TileEntry> s_tileCache;
+
+    double modificationTime = 0.0;
+    ArchGetModificationTime(ccl::path_dirname(a_filepath).c_str(),
+                            &modificationTime);
+
+    {
+        std::lock_guard<std::mutex> lock(s_tileMutex);
+        auto it = s_tileCache.find(a_filepath);
+        if (it != s_tileCache.end()
+            && it->second.modificationTime == modificationTime) {
+            a_tiles = it->second.tiles;
+            return;
+        }
+    }
+
     BOOST_NS::filesystem::path filepath(a_filepath);
 
     size_t offset            = filepath.stem().string().find("<UDIM>");
@@ -87,6 +120,9 @@ HdCyclesParseUDIMS(const ccl::string& a_filepath, ccl::vector<int>& a_tiles)
     for (std::string file : files) {
         a_tiles.push_back(atoi(file.substr(offset, offset + 3).c_str()));
     }
+
+    std::lock_guard<std::mutex> lock(s_tileMutex);
+    s_tileCache[a_filepath] = { modificationTime, a_tiles };
 }
 
 void
@@ -107,6 +143,60 @@ HdCyclesMeshTextureSpace(ccl::Geometry* a_geom, ccl::float3& a_loc,
     a_loc = a_loc * a_size - ccl::make_float3(0.5f, 0.5f, 0.5f);
 }
 
+size_t
+HdCyclesHashMesh(const ccl::Mesh* a_mesh)
+{
+    size_t hash = 0;
+
+    auto hashVector = [&hash](const auto& a_vector) {
+        HdCyclesHashCombine(hash, a_vector.size());
+        if (!a_vector.empty()) {
+            hash = HdCyclesHashBytes(a_vector.data(),
+                                     a_vector.size() * sizeof(a_vector[0]),
+                                     hash);
+        }
+    };
+
+    auto hashAttributes = [&](const ccl::AttributeSet& a_attributes) {
+        for (const ccl::Attribute& attr : a_attributes.attributes) {
+            HdCyclesHashCombine(hash, attr.name.hash());
+            HdCyclesHashCombine(hash, attr.std);
+            HdCyclesHashCombine(hash, attr.element);
+            HdCyclesHashCombine(hash, attr.type.basetype);
+            HdCyclesHashCombine(hash, attr.type.aggregate);
+            HdCyclesHashCombine(hash, attr.type.vecsemantics);
+            hashVector(attr.buffer);
+        }
+    };
+
+    hashVector(a_mesh->verts);
+    hashVector(a_mesh->triangles);
+    hashVector(a_mesh->shader);
+    hashVector(a_mesh->smooth);
+    hashVector(a_mesh->subd_faces);
+    hashVector(a_mesh->subd_face_corners);
+    hashVector(a_mesh->subd_creases);
+    hashVector(a_mesh->used_shaders);
+    hashAttributes(a_mesh->attributes);
+    hashAttributes(a_mesh->subd_attributes);
+
+    HdCyclesHashCombine(hash, a_mesh->num_ngons);
+    HdCyclesHashCombine(hash, a_mesh->subdivision_type);
+    HdCyclesHashCombine(hash, a_mesh->use_motion_blur);
+    HdCyclesHashCombine(hash, a_mesh->motion_steps);
+
+    if (a_mesh->subd_params) {
+        const ccl::SubdParams& params = *a_mesh->subd_params;
+        hash = HdCyclesHashBytes(&params.dicing_rate,
+                                 sizeof(params.dicing_rate), hash);
+        HdCyclesHashCombine(hash, params.max_level);
+        hash = HdCyclesHashBytes(&params.objecttoworld,
+                                 sizeof(params.objecttoworld), hash);
+    }
+
+    return hash;
+}
+
 /* ========== Material ========== */
 
 ccl::Shader*
@@ -154,86 +244,177 @@ _DumpGraph(ccl::ShaderGraph* shaderGraph, const char* name)
     return false;
 }
 
-/* ========= Conversion ========= */
+/* ========== Hashing ========== */
 
-// TODO: Make this function more robust
-// Along with making point sampling more robust
-// UPDATE:
-// This causes a known slowdown to deforming motion blur renders
-// This will be addressed in an upcoming PR
-HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>
-HdCyclesSetTransform(ccl::Object* object, HdSceneDelegate* delegate,
-                     const SdfPath& id, bool use_motion)
+void
+HdCyclesHashCombine(size_t& a_seed, size_t a_value)
 {
-    if (!object)
-        return {};
+    a_seed ^= a_value + 0x9e3779b9 + (a_seed << 6) + (a_seed >> 2);
+}
 
-    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> xf {};
+size_t
+HdCyclesHashBytes(const void* a_data, size_t a_size, size_t a_seed)
+{
+    // MurmurHash64A
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r      = 47;
 
-    delegate->SampleTransform(id, &xf);
+    uint64_t h = a_seed ^ (a_size * m);
 
-    int sampleCount = xf.count;
+    const unsigned char* bytes = static_cast<const unsigned char*>(a_data);
+    const size_t numWords      = a_size / sizeof(uint64_t);
 
-    if (sampleCount == 0) {
-        object->tfm = ccl::transform_identity();
-        return xf;
-    }
+    for (size_t i = 0; i < numWords; ++i) {
+        uint64_t k;
+        memcpy(&k, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
 
-    if (sampleCount > 1) {
-        bool foundCenter = false;
-        for (int i = 0; i < sampleCount; i++) {
-            if (xf.times.data()[i] == 0.0f) {
-                object->tfm = mat4d_to_transform(xf.values.data()[i]);
-                foundCenter = true;
-            }
-        }
-        if (!foundCenter)
-            object->tfm = mat4d_to_transform(xf.values.data()[0]);
-    } else {
-        object->tfm = mat4d_to_transform(xf.values.data()[0]);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
     }
 
-    if (!use_motion) {
-        return xf;
+    const unsigned char* tail = bytes + numWords * sizeof(uint64_t);
+    const size_t numTail      = a_size & (sizeof(uint64_t) - 1);
+    if (numTail > 0) {
+        uint64_t k = 0;
+        memcpy(&k, tail, numTail);
+        h ^= k;
+        h *= m;
     }
 
-    object->motion.clear();
-    if (object->geometry) {
-        if (object->geometry->use_motion_blur
-            && object->geometry->motion_steps != sampleCount) {
-            object->motion.resize(object->geometry->motion_steps, object->tfm);
-            return xf;
-        }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return static_cast<size_t>(h);
+}
+
+/* ========== Motion ========== */
+
+std::vector<float>
+HdCyclesMotionStepOffsets(ccl::Scene* a_scene, int a_motionSteps)
+{
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+
+    // Cycles needs a center step, which holds the frame itself
+    int numSteps = std::max(a_motionSteps, 3);
+    if (numSteps % 2 == 0)
+        numSteps += 1;
+
+    // The shutter is in frames while USD velocities are per second
+    const float fps     = std::max(config.frames_per_second.value, 1.0f);
+    const float shutter = a_scene ? a_scene->motion_shutter_time() : 1.0f;
+    const int center    = (numSteps - 1) / 2;
+
+    std::vector<float> offsets;
+    offsets.reserve(numSteps - 1);
+    for (int step = 0; step < numSteps; ++step) {
+        if (step == center)
+            continue;
+
+        // Same spread as ccl::Geometry::motion_time, -1 to 1 over the shutter
+        const float time = 2.0f * step / (numSteps - 1) - 1.0f;
+        offsets.push_back(0.5f * time * shutter / fps);
     }
 
-    // TODO: This might still be wrong on some edge cases...
-    // The order of point sampling and transform sampling is the only reason
-    // that this works
-    if (object->geometry && object->geometry->motion_steps == sampleCount) {
-        object->geometry->use_motion_blur = true;
+    return offsets;
+}
 
-        if (object->geometry->type == ccl::Geometry::MESH) {
-            ccl::Mesh* mesh = (ccl::Mesh*)object->geometry;
-            if (mesh->transform_applied)
-                mesh->need_update = true;
+void
+HdCyclesExtrapolatePoints(const VtVec3fArray& a_points,
+                          const VtVec3fArray& a_velocities,
+                          const VtVec3fArray& a_accelerations, float a_offset,
+                          ccl::float3* a_out)
+{
+    const bool useAccelerations = a_accelerations.size() == a_points.size();
+    const float halfOffsetSq    = 0.5f * a_offset * a_offset;
+
+    WorkParallelForN(a_points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            GfVec3f p = a_points[i] + a_velocities[i] * a_offset;
+            if (useAccelerations)
+                p += a_accelerations[i] * halfOffsetSq;
+            a_out[i] = vec3f_to_float3(p);
         }
+    });
+}
 
-        object->motion.resize(sampleCount, ccl::transform_empty());
+/* ========= Conversion ========= */
 
-        for (int i = 0; i < sampleCount; i++) {
-            if (xf.times.data()[i] == 0.0f) {
-                object->tfm = mat4d_to_transform(xf.values.data()[i]);
-            }
+bool
+HdCyclesSampleTransform(
+    HdSceneDelegate* delegate, const SdfPath& id,
+    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>* a_samples)
+{
+    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> xf {};
 
-            int idx = i;
-            if (object->geometry)
-                object->geometry->motion_step(xf.times.data()[i]);
+    delegate->SampleTransform(id, &xf);
 
-            object->motion[idx] = mat4d_to_transform(xf.values.data()[i]);
+    if (xf.count == a_samples->count) {
+        bool changed = false;
+        for (size_t i = 0; i < xf.count && !changed; ++i) {
+            changed = xf.times[i] != a_samples->times[i]
+                      || xf.values[i] != a_samples->values[i];
         }
+        if (!changed)
+            return false;
     }
 
-    return xf;
+    *a_samples = xf;
+    return true;
+}
+
+void
+HdCyclesApplyTransform(
+    ccl::Object* object,
+    const HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& xf,
+    bool use_motion)
+{
+    if (!object)
+        return;
+
+    const size_t sampleCount = xf.count;
+
+    object->motion.clear();
+
+    if (sampleCount == 0) {
+        object->tfm = ccl::transform_identity();
+        return;
+    }
+
+    // The frame itself, or the first sample when it wasn't sampled
+    size_t center = 0;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        if (xf.times[i] == 0.0f)
+            center = i;
+    }
+    object->tfm = mat4d_to_transform(xf.values[center]);
+
+    if (!use_motion || sampleCount < 2)
+        return;
+
+    // Static samples would only add motion overhead to the object
+    bool isStatic = true;
+    for (size_t i = 1; i < sampleCount && isStatic; ++i) {
+        isStatic = xf.values[i] == xf.values[0];
+    }
+    if (isStatic)
+        return;
+
+    // Cycles spreads object motion evenly over the shutter and needs a
+    // center step, resample to an odd count over the sampled interval
+    const size_t numSteps = (sampleCount % 2) ? sampleCount : sampleCount + 1;
+    const float start     = xf.times[0];
+    const float end       = xf.times[sampleCount - 1];
+
+    object->motion.resize(numSteps, ccl::transform_empty());
+    for (size_t step = 0; step < numSteps; ++step) {
+        const float time = start + (end - start) * step / (numSteps - 1);
+        object->motion[step] = mat4d_to_transform(xf.Resample(time));
+    }
 }
 
 ccl::Transform
@@ -651,20 +832,53 @@ to_cycles<GfVec4i>(const GfVec4i& v) noexcept
 }
 
 
+// Primvar types stored exactly like their Cycles type
+template<typename T, typename U> struct _HdCyclesSameLayout : std::false_type {
+};
+template<> struct _HdCyclesSameLayout<float, float> : std::true_type {
+};
+template<>
+struct _HdCyclesSameLayout<GfVec2f, ccl::float2>
+    : std::integral_constant<bool, sizeof(GfVec2f) == sizeof(ccl::float2)> {
+};
+template<>
+struct _HdCyclesSameLayout<GfVec4f, ccl::float4>
+    : std::integral_constant<bool, sizeof(GfVec4f) == sizeof(ccl::float4)> {
+};
+
+// Converts primvar elements straight into attribute storage. Matching
+// layouts are copied as one block, everything else is converted in parallel.
+template<typename T, typename U>
+void
+_ConvertPrimvarArray(const T* a_src, size_t a_count, U* a_dst)
+{
+    if (_HdCyclesSameLayout<T, U>::value) {
+        memcpy(a_dst, a_src, a_count * sizeof(U));
+        return;
+    }
+
+    WorkParallelForN(a_count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            a_dst[i] = to_cycles<T, U>(a_src[i]);
+    });
+}
+
 template<typename T, typename U>
 bool
 _PopulateAttribte_Vertex(const VtValue& value, ccl::Attribute* attr)
 {
-    VtArray<T> usd_data = value.UncheckedGet<VtArray<T>>();
-    size_t arr_size     = value.GetArraySize();
+    // Const access, a mutable VtArray would detach from the scene delegate
+    const VtArray<T>& usd_data = value.UncheckedGet<VtArray<T>>();
+    size_t arr_size            = value.GetArraySize();
 
     if (arr_size <= 0)
         return false;
 
-    char* data = attr->data();
+    // Extra primvar elements have no attribute storage
+    const size_t count = std::min(arr_size, attr->buffer.size() / sizeof(U));
 
-    for (int i = 0; i < arr_size; i++)
-        ((U*)data)[i] = to_cycles<T, U>(usd_data[i]);
+    _ConvertPrimvarArray(usd_data.cdata(), count,
+                         reinterpret_cast<U*>(attr->data()));
 
     return true;
 }
@@ -674,18 +888,26 @@ bool
 _PopulateAttribte_Uniform(const VtValue& value, ccl::Attribute* attr,
                           HdCyclesMesh* mesh)
 {
-    VtArray<T> usd_data = value.UncheckedGet<VtArray<T>>();
-    size_t arr_size     = value.GetArraySize();
+    const VtArray<T>& usd_data = value.UncheckedGet<VtArray<T>>();
+    size_t arr_size            = value.GetArraySize();
 
     if (arr_size <= 0)
         return false;
 
-    char* data = attr->data();
+    U* data                 = reinterpret_cast<U*>(attr->data());
+    const VtIntArray& faces = mesh->GetTriangleFaces();
+
+    // Triangles dropped by the mesh have no attribute storage
+    const size_t count = std::min(faces.size(),
+                                  attr->buffer.size() / sizeof(U));
 
-    int idx = 0;
-    for (size_t i = 0; i < arr_size; i++)
-        for (size_t j = 0; j < (mesh->GetFaceVertexCounts()[i] - 2); j++, idx++)
-            ((U*)data)[idx] = to_cycles<T, U>(usd_data[i]);
+    WorkParallelForN(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t face = faces[i];
+            if (face < arr_size)
+                data[i] = to_cycles<T, U>(usd_data[face]);
+        }
+    });
 
     return true;
 }
@@ -695,37 +917,26 @@ bool
 _PopulateAttribte_FaceVarying(const VtValue& value, ccl::Attribute* attr,
                               HdCyclesMesh* mesh)
 {
-    VtArray<T> usd_data = value.UncheckedGet<VtArray<T>>();
-    size_t arr_size     = value.GetArraySize();
-    size_t data_size    = sizeof(U);
+    const VtArray<T>& usd_data = value.UncheckedGet<VtArray<T>>();
+    size_t arr_size            = value.GetArraySize();
 
     if (arr_size <= 0)
         return false;
 
-    char* data = attr->data();
-
-    int count = 0;
-    for (int i = 0; i < mesh->GetFaceVertexCounts().size(); i++) {
-        const int vCount = mesh->GetFaceVertexCounts()[i];
-
-        for (int j = 1; j < vCount - 1; ++j) {
-            int v0 = count;
-            int v1 = (count + j + 0);
-            int v2 = (count + j + 1);
+    U* data                   = reinterpret_cast<U*>(attr->data());
+    const VtIntArray& corners = mesh->GetTriangleCorners();
 
-            if (mesh->GetOrientation() == HdTokens->leftHanded) {
-                v1 = (count + ((vCount - 1) - j) + 0);
-                v2 = (count + ((vCount - 1) - j) + 1);
-            }
+    // Triangles dropped by the mesh have no attribute storage
+    const size_t count = std::min(corners.size(),
+                                  attr->buffer.size() / sizeof(U));
 
-            ((U*)data)[0] = to_cycles<T, U>(usd_data[v0]);
-            ((U*)data)[1] = to_cycles<T, U>(usd_data[v1]);
-            ((U*)data)[2] = to_cycles<T, U>(usd_data[v2]);
-
-            data += 3 * data_size;
+    WorkParallelForN(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t corner = corners[i];
+            if (corner < arr_size)
+                data[i] = to_cycles<T, U>(usd_data[corner]);
         }
-        count += vCount;
-    }
+    });
 
     return true;
 }
@@ -734,8 +945,8 @@ template<typename T, typename U>
 bool
 _PopulateAttribte_Constant(const VtValue& value, ccl::Attribute* attr)
 {
-    VtArray<T> usd_data = value.UncheckedGet<VtArray<T>>();
-    size_t arr_size     = value.GetArraySize();
+    const VtArray<T>& usd_data = value.UncheckedGet<VtArray<T>>();
+    size_t arr_size            = value.GetArraySize();
     if (arr_size != 1) {
         std::cout << "Constant attribute, incompatible size: " << arr_size
                   << '\n';
@@ -770,6 +981,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Vertex<GfVec2d, ccl::float2>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec2i>>()) {
             _PopulateAttribte_Vertex<GfVec2i, ccl::float2>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec2h>>()) {
+            _PopulateAttribte_Vertex<GfVec2h, ccl::float2>(value, attr);
         }
 
         else if (value.IsHolding<VtArray<GfVec3f>>()) {
@@ -778,6 +991,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Vertex<GfVec3d, ccl::float3>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec3i>>()) {
             _PopulateAttribte_Vertex<GfVec3i, ccl::float3>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec3h>>()) {
+            _PopulateAttribte_Vertex<GfVec3h, ccl::float3>(value, attr);
         }
 
         else if (value.IsHolding<VtArray<GfVec4f>>()) {
@@ -786,6 +1001,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Vertex<GfVec4d, ccl::float4>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec4i>>()) {
             _PopulateAttribte_Vertex<GfVec4i, ccl::float4>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec4h>>()) {
+            _PopulateAttribte_Vertex<GfVec4h, ccl::float4>(value, attr);
         }
 
     } else if (interpolation == HdInterpolationUniform) {
@@ -808,6 +1025,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Uniform<GfVec2d, ccl::float2>(value, attr, mesh);
         } else if (value.IsHolding<VtArray<GfVec2i>>()) {
             _PopulateAttribte_Uniform<GfVec2i, ccl::float2>(value, attr, mesh);
+        } else if (value.IsHolding<VtArray<GfVec2h>>()) {
+            _PopulateAttribte_Uniform<GfVec2h, ccl::float2>(value, attr, mesh);
         }
 
         else if (value.IsHolding<VtArray<GfVec3f>>()) {
@@ -816,6 +1035,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Uniform<GfVec3d, ccl::float3>(value, attr, mesh);
         } else if (value.IsHolding<VtArray<GfVec3i>>()) {
             _PopulateAttribte_Uniform<GfVec3i, ccl::float3>(value, attr, mesh);
+        } else if (value.IsHolding<VtArray<GfVec3h>>()) {
+            _PopulateAttribte_Uniform<GfVec3h, ccl::float3>(value, attr, mesh);
         }
 
         else if (value.IsHolding<VtArray<GfVec4f>>()) {
@@ -824,6 +1045,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Uniform<GfVec4d, ccl::float4>(value, attr, mesh);
         } else if (value.IsHolding<VtArray<GfVec4i>>()) {
             _PopulateAttribte_Uniform<GfVec4i, ccl::float4>(value, attr, mesh);
+        } else if (value.IsHolding<VtArray<GfVec4h>>()) {
+            _PopulateAttribte_Uniform<GfVec4h, ccl::float4>(value, attr, mesh);
         }
     } else if (interpolation == HdInterpolationFaceVarying) {
         if (value.IsHolding<VtArray<float>>()) {
@@ -843,6 +1066,9 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
         } else if (value.IsHolding<VtArray<GfVec2i>>()) {
             _PopulateAttribte_FaceVarying<GfVec2i, ccl::float2>(value, attr,
                                                                 mesh);
+        } else if (value.IsHolding<VtArray<GfVec2h>>()) {
+            _PopulateAttribte_FaceVarying<GfVec2h, ccl::float2>(value, attr,
+                                                                mesh);
         }
 
         else if (value.IsHolding<VtArray<GfVec3f>>()) {
@@ -854,6 +1080,9 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
         } else if (value.IsHolding<VtArray<GfVec3i>>()) {
             _PopulateAttribte_FaceVarying<GfVec3i, ccl::float3>(value, attr,
                                                                 mesh);
+        } else if (value.IsHolding<VtArray<GfVec3h>>()) {
+            _PopulateAttribte_FaceVarying<GfVec3h, ccl::float3>(value, attr,
+                                                                mesh);
         }
 
         else if (value.IsHolding<VtArray<GfVec4f>>()) {
@@ -865,6 +1094,9 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
         } else if (value.IsHolding<VtArray<GfVec4i>>()) {
             _PopulateAttribte_FaceVarying<GfVec4i, ccl::float4>(value, attr,
                                                                 mesh);
+        } else if (value.IsHolding<VtArray<GfVec4h>>()) {
+            _PopulateAttribte_FaceVarying<GfVec4h, ccl::float4>(value, attr,
+                                                                mesh);
         }
     } else if (interpolation == HdInterpolationConstant) {
         if (value.IsHolding<VtArray<float>>()) {
@@ -881,6 +1113,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Constant<GfVec2d, ccl::float2>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec2i>>()) {
             _PopulateAttribte_Constant<GfVec2i, ccl::float2>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec2h>>()) {
+            _PopulateAttribte_Constant<GfVec2h, ccl::float2>(value, attr);
         }
 
         else if (value.IsHolding<VtArray<GfVec3f>>()) {
@@ -889,6 +1123,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Constant<GfVec3d, ccl::float3>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec3i>>()) {
             _PopulateAttribte_Constant<GfVec3i, ccl::float3>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec3h>>()) {
+            _PopulateAttribte_Constant<GfVec3h, ccl::float3>(value, attr);
         }
 
         else if (value.IsHolding<VtArray<GfVec4f>>()) {
@@ -897,6 +1133,8 @@ _PopulateAttribute(const TfToken& name, const TfToken& role,
             _PopulateAttribte_Constant<GfVec4d, ccl::float4>(value, attr);
         } else if (value.IsHolding<VtArray<GfVec4i>>()) {
             _PopulateAttribte_Constant<GfVec4i, ccl::float4>(value, attr);
+        } else if (value.IsHolding<VtArray<GfVec4h>>()) {
+            _PopulateAttribte_Constant<GfVec4h, ccl::float4>(value, attr);
         }
     } else {
         std::cout << "HdCycles WARNING: Interpolation unsupported: "
@@ -1064,14 +1302,13 @@ mikk_set_tangent_space(const SMikkTSpaceContext* context, const float T[],
 }
 
 void
-mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
-                      bool active_render)
+mikk_add_tangents(const char* layer_name, ccl::Mesh* mesh, bool active_render,
+                  ccl::Attribute** tangent, ccl::Attribute** tangent_sign)
 {
     /* Create tangent attributes. */
     ccl::AttributeSet& attributes = (mesh->subd_faces.size())
                                         ? mesh->subd_attributes
                                         : mesh->attributes;
-    ccl::Attribute* attr;
     ccl::ustring name;
 
     if (layer_name != NULL) {
@@ -1081,16 +1318,13 @@ mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
     }
 
     if (active_render) {
-        attr = attributes.add(ccl::ATTR_STD_UV_TANGENT, name);
+        *tangent = attributes.add(ccl::ATTR_STD_UV_TANGENT, name);
     } else {
-        attr = attributes.add(name, ccl::TypeDesc::TypeVector,
-                              ccl::ATTR_ELEMENT_CORNER);
+        *tangent = attributes.add(name, ccl::TypeDesc::TypeVector,
+                                  ccl::ATTR_ELEMENT_CORNER);
     }
-    ccl::float3* tangent = attr->data_float3();
     /* Create bitangent sign attribute. */
-    float* tangent_sign = NULL;
-    if (need_sign) {
-        ccl::Attribute* attr_sign;
+    if (tangent_sign != NULL) {
         ccl::ustring name_sign;
 
         if (layer_name != NULL) {
@@ -1101,14 +1335,19 @@ mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
         }
 
         if (active_render) {
-            attr_sign = attributes.add(ccl::ATTR_STD_UV_TANGENT_SIGN,
-                                       name_sign);
+            *tangent_sign = attributes.add(ccl::ATTR_STD_UV_TANGENT_SIGN,
+                                           name_sign);
         } else {
-            attr_sign = attributes.add(name_sign, ccl::TypeDesc::TypeFloat,
-                                       ccl::ATTR_ELEMENT_CORNER);
+            *tangent_sign = attributes.add(name_sign, ccl::TypeDesc::TypeFloat,
+                                           ccl::ATTR_ELEMENT_CORNER);
         }
-        tangent_sign = attr_sign->data_float();
     }
+}
+
+void
+mikk_generate_tangents(const char* layer_name, ccl::Mesh* mesh,
+                       ccl::float3* tangent, float* tangent_sign)
+{
     /* Setup userdata. */
     MikkUserData userdata(layer_name, mesh, tangent, tangent_sign);
     /* Setup interface. */
@@ -1129,6 +1368,54 @@ mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
     genTangSpaceDefault(&context);
 }
 
+void
+mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
+                      bool active_render)
+{
+    ccl::Attribute* attr      = NULL;
+    ccl::Attribute* attr_sign = NULL;
+    mikk_add_tangents(layer_name, mesh, active_render, &attr,
+                      need_sign ? &attr_sign : NULL);
+
+    mikk_generate_tangents(layer_name, mesh, attr->data_float3(),
+                           attr_sign ? attr_sign->data_float() : NULL);
+}
+
+bool
+HdCyclesShadersNeedTangents(const ccl::vector<ccl::Shader*>& a_shaders,
+                            const std::string& a_layerName, bool a_isDefault,
+                            bool* a_needSign)
+{
+    const ccl::ustring name(a_layerName + ".tangent");
+    const ccl::ustring name_sign(a_layerName + ".tangent_sign");
+
+    bool needTangent = false;
+    bool needSign    = false;
+
+    for (ccl::Shader* shader : a_shaders) {
+        if (!shader || !shader->graph)
+            continue;
+
+        // Requests of the uncompiled graph, shader->attributes is only
+        // filled once the shader compiled for the device
+        ccl::AttributeRequestSet requests;
+        for (ccl::ShaderNode* node : shader->graph->nodes) {
+            node->attributes(shader, &requests);
+        }
+
+        needTangent |= requests.find(name);
+        needSign |= requests.find(name_sign);
+        if (a_isDefault) {
+            needTangent |= requests.find(ccl::ATTR_STD_UV_TANGENT);
+            needSign |= requests.find(ccl::ATTR_STD_UV_TANGENT_SIGN);
+        }
+    }
+
+    if (a_needSign)
+        *a_needSign = needSign;
+    return needTangent || needSign;
+}
+
 template<>
 bool
 _HdCyclesGetVtValue<bool>(VtValue a_value, bool a_default, bool* a_hasChanged,
@@ -52,6 +52,7 @@
 #include <pxr/pxr.h>
 
 #include <iostream>
+#include <vector>
 
 namespace ccl {
 class Mesh;
@@ -84,6 +85,17 @@ void
 HdCyclesMeshTextureSpace(ccl::Geometry* a_geom, ccl::float3& a_loc,
                          ccl::float3& a_size);
 
+/**
+ * @brief Content hash of a Cycles mesh: faces, vertices, attributes,
+ * shaders, motion and subdivision settings. Meshes with equal hashes can
+ * share one BVH.
+ *
+ * @param a_mesh Mesh to hash
+ * @return Hash of the mesh content
+ */
+size_t
+HdCyclesHashMesh(const ccl::Mesh* a_mesh);
+
 /* ========== Material ========== */
 
 ccl::Shader*
@@ -100,19 +112,97 @@ HdCyclesCreateDefaultShader();
 bool
 _DumpGraph(ccl::ShaderGraph* shaderGraph, const char* name);
 
+/* ========== Hashing ========== */
+
+/**
+ * @brief Mix a value into a running hash
+ *
+ * @param a_seed Running hash
+ * @param a_value Value to mix in
+ */
+void
+HdCyclesHashCombine(size_t& a_seed, size_t a_value);
+
+/**
+ * @brief Hash a block of memory
+ *
+ * @param a_data Data to hash
+ * @param a_size Size in bytes
+ * @param a_seed Running hash to continue from
+ * @return Hash of the data
+ */
+size_t
+HdCyclesHashBytes(const void* a_data, size_t a_size, size_t a_seed = 0);
+
+/* ========== Motion ========== */
+
+/**
+ * @brief Time offsets of the Cycles motion steps from the frame, in seconds.
+ * The step count is rounded up to an odd number of at least three and the
+ * center step is left out, matching the layout of the motion vertex
+ * attribute.
+ *
+ * @param a_scene Scene to read the shutter time from
+ * @param a_motionSteps Requested number of motion steps
+ * @return One offset per non center step
+ */
+HDCYCLES_API
+std::vector<float>
+HdCyclesMotionStepOffsets(ccl::Scene* a_scene, int a_motionSteps);
+
+/**
+ * @brief Move points along their velocities and accelerations by a time
+ * offset, used for motion blur from a single point sample
+ *
+ * @param a_points Positions at the frame
+ * @param a_velocities Velocities in units per second, one per point
+ * @param a_accelerations Accelerations in units per second squared, one per
+ * point or empty
+ * @param a_offset Time offset from the frame in seconds
+ * @param a_out Receives one position per point
+ */
+HDCYCLES_API
+void
+HdCyclesExtrapolatePoints(const VtVec3fArray& a_points,
+                          const VtVec3fArray& a_velocities,
+                          const VtVec3fArray& a_accelerations, float a_offset,
+                          ccl::float3* a_out);
+
 /* ========= Conversion ========= */
 
 /**
- * @brief Create Cycles Transform from given HdSceneDelegate and SdfPath
+ * @brief Sample the transform of a prim into its cached samples. Prims
+ * call this on every DirtyTransform, which deforming prims get along with
+ * their points even when the transform itself is unchanged.
  *
- * @param delegate
- * @param id
- * @return Cycles Transform
+ * @param delegate Scene delegate to sample from
+ * @param id Prim to sample
+ * @param a_samples Cached samples of the prim, updated when they differ
+ * @return true if the samples changed and need to be applied
  */
 HDCYCLES_API
-HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>
-HdCyclesSetTransform(ccl::Object* object, HdSceneDelegate* delegate,
-                     const SdfPath& id, bool use_motion);
+bool
+HdCyclesSampleTransform(
+    HdSceneDelegate* delegate, const SdfPath& id,
+    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>* a_samples);
+
+/**
+ * @brief Apply already sampled transforms to a Cycles Object.
+ * This does not touch the scene delegate, so samples can be pulled
+ * outside of the Cycles scene lock and applied inside it. Object motion
+ * is independent from the motion steps of the geometry, and is only
+ * populated when the samples actually move.
+ *
+ * @param object Object to apply the transform to
+ * @param xf Transform samples, usually from SampleTransform
+ * @param use_motion Populate object motion from the samples
+ */
+HDCYCLES_API
+void
+HdCyclesApplyTransform(
+    ccl::Object* object,
+    const HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& xf,
+    bool use_motion);
 
 ccl::Transform
 HdCyclesExtractTransform(HdSceneDelegate* delegate, const SdfPath& id);
@@ -636,10 +726,39 @@ mikk_set_tangent_space(const SMikkTSpaceContext* context, const float T[],
                        const float sign, const int face_num,
                        const int vert_num);
 
+void
+mikk_add_tangents(const char* layer_name, ccl::Mesh* mesh, bool active_render,
+                  ccl::Attribute** tangent, ccl::Attribute** tangent_sign);
+
+/**
+ * @brief Generate the tangents of a uv layer into attributes created by
+ * mikk_add_tangents. Only reads the mesh as long as it has vertex normals,
+ * so layers can be generated in parallel.
+ */
+void
+mikk_generate_tangents(const char* layer_name, ccl::Mesh* mesh,
+                       ccl::float3* tangent, float* tangent_sign);
+
 void
 mikk_compute_tangents(const char* layer_name, ccl::Mesh* mesh, bool need_sign,
                       bool active_render);
 
+/**
+ * @brief Check whether any of the shaders uses tangents of a uv layer, e.g.
+ * through a tangent space normal map. Reads the shader graphs, so must be
+ * called with the scene mutex held.
+ *
+ * @param a_shaders Shaders bound to the mesh
+ * @param a_layerName Name of the uv layer
+ * @param a_isDefault Layer is the one the standard uv attributes resolve to
+ * @param a_needSign Set when the bitangent sign is used as well
+ * @return Returns true if the tangents of the layer are needed
+ */
+bool
+HdCyclesShadersNeedTangents(const ccl::vector<ccl::Shader*>& a_shaders,
+                            const std::string& a_layerName, bool a_isDefault,
+                            bool* a_needSign);
+
 PXR_NAMESPACE_CLOSE_SCOPE
 
 #endif  // HD_CYCLES_UTILS_H
@@ -77,14 +77,13 @@ HdCyclesVolume::HdCyclesVolume(SdfPath const& id, SdfPath const& instancerId,
 
 HdCyclesVolume::~HdCyclesVolume()
 {
+    // The render param takes ownership of removed items
     if (m_cyclesObject) {
         m_renderDelegate->GetCyclesRenderParam()->RemoveObject(m_cyclesObject);
-        delete m_cyclesObject;
     }
 
     if (m_cyclesVolume) {
         m_renderDelegate->GetCyclesRenderParam()->RemoveMesh(m_cyclesVolume);
-        delete m_cyclesVolume;
     }
 }
 
@@ -146,6 +145,9 @@ HdCyclesVolume::_PopulateVolume(const SdfPath& id, HdSceneDelegate* delegate,
             continue;
         }
 
+        // Edits to the file path of the asset re-populate this volume
+        openvdbAsset->TrackVolumePrimitive(id);
+
         const auto vv = delegate->Get(field.fieldId, _tokens->filePath);
 
         if (vv.IsHolding<SdfAssetPath>()) {
@@ -197,6 +199,8 @@ HdCyclesVolume::_PopulateVolume(const SdfPath& id, HdSceneDelegate* delegate,
                                                name, ccl::TypeDesc::TypeFloat,
                                                ccl::ATTR_ELEMENT_VOXEL);
 
+                // Grids come from the shared cache, fields of one file open
+                // it once and unchanged paths reuse the loaded grid
                 ccl::ImageLoader* loader
                     = new HdCyclesVolumeLoader(filepath.c_str(), name.c_str());
                 ccl::ImageParams params;
@@ -232,11 +236,14 @@ HdCyclesVolume::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
     HdCyclesRenderParam* param = (HdCyclesRenderParam*)renderParam;
 
+    HdCyclesSyncTimer syncTimer(param, HdPrimTypeTokens->volume);
+
     ccl::Scene* scene = param->GetCyclesScene();
 
     HdCyclesPDPIMap pdpi;
     bool generate_new_curve = false;
     bool update_volumes     = false;
+    bool update_transform   = false;
 
     ccl::vector<int> old_voxel_slots = get_voxel_image_slots(m_cyclesVolume);
 
@@ -256,10 +263,12 @@ HdCyclesVolume::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        m_transformSamples = HdCyclesSetTransform(m_cyclesObject, sceneDelegate,
-                                                  id, m_useMotionBlur);
-
-        update_volumes = true;
+        update_transform = HdCyclesSampleTransform(sceneDelegate, id,
+                                                   &m_transformSamples);
+        if (update_transform) {
+            HdCyclesApplyTransform(m_cyclesObject, m_transformSamples,
+                                   m_useMotionBlur);
+        }
     }
 
     if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
@@ -284,11 +293,18 @@ HdCyclesVolume::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
                     sceneDelegate->GetRenderIndex().GetSprim(
                         HdPrimTypeTokens->material, materialId));
 
+            ccl::Shader* shader = scene->default_volume;
             if (material && material->GetCyclesShader()) {
-                m_usedShaders.push_back(material->GetCyclesShader());
-                material->GetCyclesShader()->tag_update(scene);
+                shader = material->GetCyclesShader();
+                shader->tag_update(scene);
+            }
+
+            // Volumes only use the first slot, rebind it as materials can
+            // hand out a different shared shader after an edit
+            if (m_usedShaders.empty()) {
+                m_usedShaders.push_back(shader);
             } else {
-                m_usedShaders.push_back(scene->default_volume);
+                m_usedShaders[0] = shader;
             }
             m_cyclesVolume->used_shaders = m_usedShaders;
             update_volumes               = true;
@@ -301,8 +317,17 @@ HdCyclesVolume::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
 
         m_cyclesVolume->tag_update(scene, rebuild);
         m_cyclesObject->tag_update(scene);
+        param->TagSceneChange((rebuild
+                                   ? HdCyclesRenderParam::SceneChangeGeometry
+                                   : HdCyclesRenderParam::SceneChangeDeform)
+                              | HdCyclesRenderParam::SceneChangeTransform);
 
         param->Interrupt();
+    } else if (update_transform) {
+        // Object only, the volume mesh is left alone
+        m_cyclesObject->tag_update(scene);
+        param->TagSceneChange(HdCyclesRenderParam::SceneChangeTransform);
+        param->Interrupt();
     }
 
     *dirtyBits = HdChangeTracker::Clean;
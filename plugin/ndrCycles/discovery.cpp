@@ -39,6 +39,73 @@ TF_DEFINE_PRIVATE_TOKENS(_tokens,
 
 NDR_REGISTER_DISCOVERY_PLUGIN(NdrCyclesDiscoveryPlugin);
 
+namespace {
+
+// TODO: Store these in proper USD Schema and read at runtime...
+const char* _nodeNames[] = {
+    "output",
+    "diffuse_bsdf",
+    "principled_bsdf",
+    "glossy_bsdf",
+    "principled_hair_bsdf",
+    "anisotropic_bsdf",
+    "glass_bsdf",
+    "refraction_bsdf",
+    "toon_bsdf",
+    "velvet_bsdf",
+    "translucent_bsdf",
+    "transparent_bsdf",
+    "subsurface_scattering",
+    "mix_closure",
+    "add_closure",
+    "hair_bsdf",
+    "principled_volume",
+    "scatter_volume",
+    "absorption_volume",
+    "emission",
+};
+
+void
+_AppendNode(const std::string& a_identifier, const std::string& a_name,
+            const TfToken& a_uri, NdrNodeDiscoveryResultVec& a_results)
+{
+    a_results.emplace_back(NdrIdentifier(a_identifier),  // identifier
+                           NdrVersion(1, 0),             // version
+                           a_name,                       // name
+                           _tokens->shader,              // family
+                           _tokens->cycles,              // discoveryType
+                           _tokens->cycles,              // sourceType
+                           a_uri,                        // uri
+                           a_uri                         // resolvedUri
+    );
+}
+
+// The nodes are built in, they only have to be assembled once per process.
+// Their properties are parsed by Ndr when a node is first requested.
+const NdrNodeDiscoveryResultVec&
+_GetDiscoveredNodes()
+{
+    static const NdrNodeDiscoveryResultVec result = []() {
+        const TfToken filename("<built-in>");
+
+        NdrNodeDiscoveryResultVec ret;
+        ret.reserve(2 * sizeof(_nodeNames) / sizeof(_nodeNames[0]));
+        for (const char* name : _nodeNames) {
+            const std::string n(name);
+            _AppendNode("cycles_" + n, n, filename, ret);
+
+            // DEPRECATED:
+            // Added for backwards support whilst we transition to new
+            // identifier
+            _AppendNode("cycles:" + n, n, filename, ret);
+        }
+        return ret;
+    }();
+    return result;
+}
+
+}  // namespace
+
 NdrCyclesDiscoveryPlugin::NdrCyclesDiscoveryPlugin() {}
 
 NdrCyclesDiscoveryPlugin::~NdrCyclesDiscoveryPlugin() {}
@@ -46,61 +113,7 @@ NdrCyclesDiscoveryPlugin::~NdrCyclesDiscoveryPlugin() {}
 NdrNodeDiscoveryResultVec
 NdrCyclesDiscoveryPlugin::DiscoverNodes(const Context& context)
 {
-    TfToken filename("<built-in>");
-    NdrNodeDiscoveryResultVec ret;
-
-    // TODO: Store these in proper USD Schema and read at runtime...
-    std::vector<std::string> temp_nodes;
-    temp_nodes.push_back("output");
-    temp_nodes.push_back("diffuse_bsdf");
-    temp_nodes.push_back("principled_bsdf");
-    temp_nodes.push_back("glossy_bsdf");
-    temp_nodes.push_back("principled_hair_bsdf");
-    temp_nodes.push_back("anisotropic_bsdf");
-    temp_nodes.push_back("glass_bsdf");
-    temp_nodes.push_back("refraction_bsdf");
-    temp_nodes.push_back("toon_bsdf");
-    temp_nodes.push_back("velvet_bsdf");
-    temp_nodes.push_back("translucent_bsdf");
-    temp_nodes.push_back("transparent_bsdf");
-    temp_nodes.push_back("subsurface_scattering");
-    temp_nodes.push_back("mix_closure");
-    temp_nodes.push_back("add_closure");
-    temp_nodes.push_back("hair_bsdf");
-    temp_nodes.push_back("principled_volume");
-    temp_nodes.push_back("scatter_volume");
-    temp_nodes.push_back("absorption_volume");
-    temp_nodes.push_back("emission");
-
-    for (const std::string& n : temp_nodes) {
-        std::string cycles_id = std::string("cycles_" + n);
-        ret.emplace_back(NdrIdentifier(
-                             TfStringPrintf(cycles_id.c_str())),  // identifier
-                         NdrVersion(1, 0),                        // version
-                         n.c_str(),                               // name
-                         _tokens->shader,                         // family
-                         _tokens->cycles,  // discoveryType
-                         _tokens->cycles,  // sourceType
-                         filename,         // uri
-                         filename          // resolvedUri
-        );
-
-        // DEPRECATED:
-        // Added for backwards support whilst we transition to new identifier
-        cycles_id = std::string("cycles:" + n);
-        ret.emplace_back(NdrIdentifier(
-                             TfStringPrintf(cycles_id.c_str())),  // identifier
-                         NdrVersion(1, 0),                        // version
-                         n.c_str(),                               // name
-                         _tokens->shader,                         // family
-                         _tokens->cycles,  // discoveryType
-                         _tokens->cycles,  // sourceType
-                         filename,         // uri
-                         filename          // resolvedUri
-        );
-    }
-
-    return ret;
+    return _GetDiscoveredNodes();
 }
 
 const NdrStringVec&
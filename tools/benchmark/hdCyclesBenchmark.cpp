@@ -0,0 +1,492 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Syncs synthetic scenes through the hdCycles render delegate and reports
+// the throughput of each prim type and of the render buffer blits, so two
+// builds can be compared without a USD stage or a render.
+//
+//     hdCyclesBenchmark [--prims N] [--elements N] [--iterations N]
+//                       [--width N] [--height N] [--tile N]
+
+#include <hdCycles/renderBuffer.h>
+#include <hdCycles/renderDelegate.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <pxr/base/gf/matrix4f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/base/tf/stopwatch.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/imaging/hd/changeTracker.h>
+#include <pxr/imaging/hd/engine.h>
+#include <pxr/imaging/hd/material.h>
+#include <pxr/imaging/hd/renderIndex.h>
+#include <pxr/imaging/hd/renderPass.h>
+#include <pxr/imaging/hd/rprimCollection.h>
+#include <pxr/imaging/hd/task.h>
+#include <pxr/imaging/hd/tokens.h>
+#include <pxr/imaging/hd/unitTestDelegate.h>
+#include <pxr/pxr.h>
+#include <pxr/usdImaging/usdImaging/tokens.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+struct _Options {
+    int prims      = 1000;
+    int elements   = 1024;
+    int iterations = 5;
+    int width      = 1920;
+    int height     = 1080;
+    int tile       = 64;
+};
+
+// What a scene was populated with, in prims and in the unit its
+// throughput is reported in
+struct _Counts {
+    size_t prims    = 0;
+    size_t elements = 0;
+};
+
+using _PopulateFn = std::function<_Counts(HdUnitTestDelegate*)>;
+using _DirtyFn    = std::function<void(HdChangeTracker&, HdRenderIndex*)>;
+
+// Syncs the prims of the render pass collection. The render pass is never
+// executed, so the session doesn't start rendering while it is timed.
+class _SyncTask final : public HdTask {
+public:
+    explicit _SyncTask(HdRenderPassSharedPtr const& a_renderPass)
+        : HdTask(SdfPath::EmptyPath())
+        , m_renderPass(a_renderPass)
+        , m_renderTags({ HdTokens->geometry })
+    {
+    }
+
+    void Sync(HdSceneDelegate* a_delegate, HdTaskContext* a_ctx,
+              HdDirtyBits* a_dirtyBits) override
+    {
+        m_renderPass->Sync();
+        *a_dirtyBits = HdChangeTracker::Clean;
+    }
+
+    void Prepare(HdTaskContext* a_ctx, HdRenderIndex* a_renderIndex) override
+    {
+    }
+
+    void Execute(HdTaskContext* a_ctx) override {}
+
+    const TfTokenVector& GetRenderTags() const override
+    {
+        return m_renderTags;
+    }
+
+private:
+    HdRenderPassSharedPtr m_renderPass;
+    TfTokenVector m_renderTags;
+};
+
+void
+_PrintRate(const char* a_label, double a_seconds, const _Counts& a_counts,
+           const char* a_unit)
+{
+    const double seconds = std::max(a_seconds, 1e-9);
+    std::printf("  %-8s %10.4f s %14.0f prims/s", a_label, a_seconds,
+                a_counts.prims / seconds);
+    if (a_unit)
+        std::printf(" %16.0f %s/s", a_counts.elements / seconds, a_unit);
+    std::printf("\n");
+}
+
+// First sync of a new scene, then resyncs with a_dirty marking what an
+// edit or a new frame would
+void
+_RunSync(HdCyclesRenderDelegate* a_renderDelegate, const _Options& a_options,
+         const char* a_name, const char* a_unit, const _PopulateFn& a_populate,
+         const _DirtyFn& a_dirty)
+{
+    std::unique_ptr<HdRenderIndex> renderIndex(
+#if PXR_VERSION >= 2008
+        HdRenderIndex::New(a_renderDelegate, HdDriverVector()));
+#else
+        HdRenderIndex::New(a_renderDelegate));
+#endif
+    if (!renderIndex) {
+        std::fprintf(stderr, "Couldn't create the render index\n");
+        return;
+    }
+
+    HdUnitTestDelegate sceneDelegate(renderIndex.get(),
+                                     SdfPath::AbsoluteRootPath());
+    const _Counts counts = a_populate(&sceneDelegate);
+
+    HdRprimCollection collection(HdTokens->geometry,
+                                 HdReprSelector(HdReprTokens->smoothHull));
+    HdRenderPassSharedPtr renderPass
+        = a_renderDelegate->CreateRenderPass(renderIndex.get(), collection);
+    HdTaskSharedPtrVector tasks = { std::make_shared<_SyncTask>(renderPass) };
+
+    HdEngine engine;
+
+    TfStopwatch sync;
+    sync.Start();
+    engine.Execute(renderIndex.get(), &tasks);
+    sync.Stop();
+
+    HdChangeTracker& tracker = renderIndex->GetChangeTracker();
+
+    TfStopwatch resync;
+    for (int i = 0; i < a_options.iterations; ++i) {
+        a_dirty(tracker, renderIndex.get());
+
+        resync.Start();
+        engine.Execute(renderIndex.get(), &tasks);
+        resync.Stop();
+    }
+
+    std::printf("%s: %zu prims", a_name, counts.prims);
+    if (a_unit)
+        std::printf(", %zu %s", counts.elements, a_unit);
+    std::printf("\n");
+
+    _PrintRate("sync", sync.GetSeconds(), counts, a_unit);
+    if (a_options.iterations > 0)
+        _PrintRate("resync", resync.GetSeconds() / a_options.iterations,
+                   counts, a_unit);
+}
+
+void
+_DirtyRprims(HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex,
+             HdDirtyBits a_bits)
+{
+    for (const SdfPath& id : a_renderIndex->GetRprimIds())
+        a_tracker.MarkRprimDirty(id, a_bits);
+}
+
+SdfPath
+_PrimPath(const char* a_prefix, int a_index)
+{
+    return SdfPath(TfStringPrintf("/%s_%d", a_prefix, a_index));
+}
+
+GfMatrix4f
+_PrimTransform(int a_index)
+{
+    GfMatrix4f transform(1.0f);
+    transform.SetTranslateOnly(GfVec3f(static_cast<float>(a_index % 100),
+                                       static_cast<float>(a_index / 100),
+                                       0.0f));
+    return transform;
+}
+
+void
+_RunMeshes(HdCyclesRenderDelegate* a_renderDelegate, const _Options& a_options)
+{
+    const double elements = static_cast<double>(a_options.elements);
+    const int side = std::max(1, static_cast<int>(std::sqrt(elements)));
+
+    _RunSync(
+        a_renderDelegate, a_options, "Mesh", "tris",
+        [&](HdUnitTestDelegate* a_delegate) {
+            _Counts counts;
+            for (int i = 0; i < a_options.prims; ++i) {
+                a_delegate->AddGrid(_PrimPath("mesh", i), side, side,
+                                    _PrimTransform(i));
+                counts.elements += 2 * side * side;
+            }
+            counts.prims = a_options.prims;
+            return counts;
+        },
+        [](HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex) {
+            _DirtyRprims(a_tracker, a_renderIndex,
+                         HdChangeTracker::DirtyPoints);
+        });
+}
+
+void
+_RunBasisCurves(HdCyclesRenderDelegate* a_renderDelegate,
+                const _Options& a_options)
+{
+    _RunSync(
+        a_renderDelegate, a_options, "BasisCurves", "segments",
+        [&](HdUnitTestDelegate* a_delegate) {
+            // One cubic bezier segment per curve
+            VtVec3fArray points(a_options.elements * 4);
+            VtIntArray vertexCounts(a_options.elements, 4);
+            for (size_t i = 0; i < points.size(); ++i) {
+                points[i] = GfVec3f(static_cast<float>(i / 4),
+                                    static_cast<float>(i % 4), 0.0f);
+            }
+
+            _Counts counts;
+            for (int i = 0; i < a_options.prims; ++i) {
+                a_delegate->AddBasisCurves(_PrimPath("curves", i), points,
+                                           vertexCounts, VtIntArray(),
+                                           VtVec3fArray(), HdTokens->cubic,
+                                           HdTokens->bezier);
+                counts.elements += vertexCounts.size();
+            }
+            counts.prims = a_options.prims;
+            return counts;
+        },
+        [](HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex) {
+            _DirtyRprims(a_tracker, a_renderIndex,
+                         HdChangeTracker::DirtyPoints);
+        });
+}
+
+void
+_RunPoints(HdCyclesRenderDelegate* a_renderDelegate, const _Options& a_options)
+{
+    _RunSync(
+        a_renderDelegate, a_options, "Points", "points",
+        [&](HdUnitTestDelegate* a_delegate) {
+            VtVec3fArray points(a_options.elements);
+            for (size_t i = 0; i < points.size(); ++i)
+                points[i] = GfVec3f(static_cast<float>(i), 0.0f, 0.0f);
+
+            _Counts counts;
+            for (int i = 0; i < a_options.prims; ++i) {
+                a_delegate->AddPoints(_PrimPath("points", i), points);
+                counts.elements += points.size();
+            }
+            counts.prims = a_options.prims;
+            return counts;
+        },
+        [](HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex) {
+            _DirtyRprims(a_tracker, a_renderIndex,
+                         HdChangeTracker::DirtyPoints);
+        });
+}
+
+void
+_RunInstancer(HdCyclesRenderDelegate* a_renderDelegate,
+              const _Options& a_options)
+{
+    const SdfPath instancerId("/instancer");
+
+    _RunSync(
+        a_renderDelegate, a_options, "Instancer", "instances",
+        [&](HdUnitTestDelegate* a_delegate) {
+            // Every prim is one instance of a cube
+            const size_t numInstances = a_options.prims;
+            VtIntArray prototypeIndex(numInstances, 0);
+            VtVec3fArray scale(numInstances, GfVec3f(1.0f));
+            VtVec4fArray rotate(numInstances, GfVec4f(1.0f, 0.0f, 0.0f, 0.0f));
+            VtVec3fArray translate(numInstances);
+            for (size_t i = 0; i < numInstances; ++i)
+                translate[i] = _PrimTransform(i).ExtractTranslation();
+
+            a_delegate->AddInstancer(instancerId);
+            a_delegate->SetInstancerProperties(instancerId, prototypeIndex,
+                                               scale, rotate, translate);
+            a_delegate->AddCube(SdfPath("/instancer/prototype"),
+                                GfMatrix4f(1.0f), false, instancerId);
+
+            _Counts counts;
+            counts.prims    = 1;
+            counts.elements = numInstances;
+            return counts;
+        },
+        [&](HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex) {
+            a_tracker.MarkInstancerDirty(instancerId,
+                                         HdChangeTracker::DirtyPrimvar);
+            _DirtyRprims(a_tracker, a_renderIndex,
+                         HdChangeTracker::DirtyInstancer
+                             | HdChangeTracker::DirtyInstanceIndex);
+        });
+}
+
+void
+_RunMaterials(HdCyclesRenderDelegate* a_renderDelegate,
+              const _Options& a_options)
+{
+    std::vector<SdfPath> materialIds;
+
+    _RunSync(
+        a_renderDelegate, a_options, "Material", nullptr,
+        [&](HdUnitTestDelegate* a_delegate) {
+            // One preview surface per material, each bound to a small grid
+            for (int i = 0; i < a_options.prims; ++i) {
+                const SdfPath materialId = _PrimPath("material", i);
+                const SdfPath meshId     = _PrimPath("mesh", i);
+
+                HdMaterialNode node;
+                node.path       = materialId.AppendChild(TfToken("Surface"));
+                node.identifier = UsdImagingTokens->UsdPreviewSurface;
+                node.parameters[TfToken("diffuseColor")] = VtValue(
+                    GfVec3f(static_cast<float>(i % 10) / 10.0f, 0.5f, 0.5f));
+
+                HdMaterialNetwork network;
+                network.nodes.push_back(node);
+
+                HdMaterialNetworkMap networkMap;
+                networkMap.map[HdMaterialTerminalTokens->surface] = network;
+                networkMap.terminals.push_back(node.path);
+
+                a_delegate->AddMaterialResource(materialId,
+                                                VtValue(networkMap));
+                a_delegate->AddGrid(meshId, 1, 1, _PrimTransform(i));
+                a_delegate->BindMaterial(meshId, materialId);
+                materialIds.push_back(materialId);
+            }
+
+            _Counts counts;
+            counts.prims = materialIds.size();
+            return counts;
+        },
+        [&](HdChangeTracker& a_tracker, HdRenderIndex* a_renderIndex) {
+            for (const SdfPath& id : materialIds)
+                a_tracker.MarkSprimDirty(id, HdMaterial::DirtyResource);
+        });
+}
+
+void
+_RunBlit(HdCyclesRenderDelegate* a_renderDelegate, const _Options& a_options)
+{
+    const int width  = a_options.width;
+    const int height = a_options.height;
+    const int blits  = std::max(a_options.iterations, 1);
+
+    // What the render pass hands over from the Cycles display
+    std::vector<float> pixels(static_cast<size_t>(width) * height * 4, 0.5f);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(pixels.data());
+
+    _Counts counts;
+    counts.prims    = 1;
+    counts.elements = static_cast<size_t>(width) * height;
+
+    std::printf("Blit: %dx%d\n", width, height);
+
+    // What tiled renders hand over for each finished Cycles tile
+    const int tile = a_options.tile;
+    std::vector<float> tilePixels(static_cast<size_t>(tile) * tile * 4, 0.5f);
+    const uint8_t* tileData = reinterpret_cast<const uint8_t*>(
+        tilePixels.data());
+
+    _Counts tileCounts;
+    tileCounts.prims = static_cast<size_t>((width + tile - 1) / tile)
+                       * ((height + tile - 1) / tile);
+    tileCounts.elements = counts.elements;
+
+    const HdFormat formats[] = { HdFormatFloat32Vec4, HdFormatFloat16Vec4,
+                                 HdFormatUNorm8Vec4 };
+    const char* labels[]     = { "float32", "float16", "unorm8" };
+    const char* tileLabels[] = { "f32 tile", "f16 tile", "u8 tile" };
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        HdCyclesRenderBuffer buffer(a_renderDelegate,
+                                    SdfPath("/benchmark/color"));
+        if (!buffer.Allocate(GfVec3i(width, height, 1), formats[f], false))
+            continue;
+
+        TfStopwatch blit;
+        blit.Start();
+        for (int i = 0; i < blits; ++i)
+            buffer.Blit(HdFormatFloat32Vec4, width, height, 0, width, data);
+        blit.Stop();
+
+        _PrintRate(labels[f], blit.GetSeconds() / blits, counts, "pixels");
+
+        TfStopwatch blitTiles;
+        blitTiles.Start();
+        for (int i = 0; i < blits; ++i) {
+            for (int y = 0; y < height; y += tile) {
+                for (int x = 0; x < width; x += tile) {
+                    const int w = std::min(tile, width - x);
+                    const int h = std::min(tile, height - y);
+                    buffer.BlitTile(HdFormatFloat32Vec4, x, y, w, h, 0, w,
+                                    tileData);
+                }
+            }
+        }
+        blitTiles.Stop();
+
+        _PrintRate(tileLabels[f], blitTiles.GetSeconds() / blits, tileCounts,
+                   "pixels");
+    }
+}
+
+bool
+_ParseOptions(int argc, char** argv, _Options* a_options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+
+        const int value = std::atoi(argv[++i]);
+        if (std::strcmp(arg, "--prims") == 0) {
+            a_options->prims = value;
+        } else if (std::strcmp(arg, "--elements") == 0) {
+            a_options->elements = value;
+        } else if (std::strcmp(arg, "--iterations") == 0) {
+            a_options->iterations = value;
+        } else if (std::strcmp(arg, "--width") == 0) {
+            a_options->width = value;
+        } else if (std::strcmp(arg, "--height") == 0) {
+            a_options->height = value;
+        } else if (std::strcmp(arg, "--tile") == 0) {
+            a_options->tile = value;
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+    }
+
+    return a_options->prims > 0 && a_options->elements > 0
+           && a_options->iterations >= 0 && a_options->width > 0
+           && a_options->height > 0 && a_options->tile > 0;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    _Options options;
+    if (!_ParseOptions(argc, argv, &options)) {
+        std::fprintf(stderr,
+                     "Usage: %s [--prims N] [--elements N] [--iterations N] "
+                     "[--width N] [--height N] [--tile N]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    HdCyclesRenderDelegate renderDelegate;
+
+    _RunMeshes(&renderDelegate, options);
+    _RunBasisCurves(&renderDelegate, options);
+    _RunPoints(&renderDelegate, options);
+    _RunInstancer(&renderDelegate, options);
+    _RunMaterials(&renderDelegate, options);
+    _RunBlit(&renderDelegate, options);
+
+    return 0;
+}
@@ -0,0 +1,360 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Renders a USD stage headless through the hdCycles renderer plugin, render
+// delegate and render pass, then reports the time to the first sync and
+// pixel, the BVH build, samples/s and the peak memory. The full render
+// stats and a Chrome trace are written with --stats and --trace.
+//
+//     hdCyclesStageBenchmark <stage> [--camera PATH] [--samples N]
+//                            [--width N] [--height N] [--timeout S]
+//                            [--stats FILE] [--trace FILE]
+//
+// The hdCycles plugin is found through PXR_PLUGINPATH_NAME.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <pxr/base/gf/vec3i.h>
+#include <pxr/base/gf/vec4d.h>
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/base/tf/setenv.h>
+#include <pxr/base/tf/stopwatch.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/imaging/hd/camera.h>
+#include <pxr/imaging/hd/engine.h>
+#include <pxr/imaging/hd/renderBuffer.h>
+#include <pxr/imaging/hd/renderDelegate.h>
+#include <pxr/imaging/hd/renderIndex.h>
+#include <pxr/imaging/hd/renderPass.h>
+#include <pxr/imaging/hd/renderPassState.h>
+#include <pxr/imaging/hd/rendererPlugin.h>
+#include <pxr/imaging/hd/rendererPluginRegistry.h>
+#include <pxr/imaging/hd/rprimCollection.h>
+#include <pxr/imaging/hd/task.h>
+#include <pxr/imaging/hd/tokens.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/primRange.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/camera.h>
+#include <pxr/usdImaging/usdImaging/delegate.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+struct _Options {
+    std::string stage;
+    std::string camera;
+    std::string statsFile;
+    std::string traceFile;
+    int samples    = 0;
+    int width      = 1280;
+    int height     = 720;
+    double timeout = 0.0;
+};
+
+// Syncs and executes the render pass like the render task of a viewer
+class _RenderTask final : public HdTask {
+public:
+    _RenderTask(HdRenderPassSharedPtr const& a_renderPass,
+                HdRenderPassStateSharedPtr const& a_renderPassState)
+        : HdTask(SdfPath::EmptyPath())
+        , m_renderPass(a_renderPass)
+        , m_renderPassState(a_renderPassState)
+        , m_renderTags({ HdTokens->geometry, HdTokens->render })
+    {
+    }
+
+    void Sync(HdSceneDelegate* a_delegate, HdTaskContext* a_ctx,
+              HdDirtyBits* a_dirtyBits) override
+    {
+        m_renderPass->Sync();
+        *a_dirtyBits = HdChangeTracker::Clean;
+    }
+
+    void Prepare(HdTaskContext* a_ctx, HdRenderIndex* a_renderIndex) override
+    {
+    }
+
+    void Execute(HdTaskContext* a_ctx) override
+    {
+        m_renderPass->Execute(m_renderPassState, m_renderTags);
+    }
+
+    const TfTokenVector& GetRenderTags() const override
+    {
+        return m_renderTags;
+    }
+
+private:
+    HdRenderPassSharedPtr m_renderPass;
+    HdRenderPassStateSharedPtr m_renderPassState;
+    TfTokenVector m_renderTags;
+};
+
+double
+_GetStat(const VtDictionary& a_stats, const char* a_key)
+{
+    auto it = a_stats.find(a_key);
+    if (it == a_stats.end() || !it->second.CanCast<double>())
+        return 0.0;
+    return it->second.Cast<double>().UncheckedGet<double>();
+}
+
+SdfPath
+_FindCamera(const UsdStageRefPtr& a_stage, const std::string& a_camera)
+{
+    if (!a_camera.empty())
+        return SdfPath(a_camera);
+
+    for (const UsdPrim& prim : a_stage->Traverse()) {
+        if (prim.IsA<UsdGeomCamera>())
+            return prim.GetPath();
+    }
+    return SdfPath();
+}
+
+bool
+_ParseOptions(int argc, char** argv, _Options* a_options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (arg[0] != '-') {
+            a_options->stage = arg;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--camera") == 0) {
+            a_options->camera = value;
+        } else if (std::strcmp(arg, "--samples") == 0) {
+            a_options->samples = std::atoi(value);
+        } else if (std::strcmp(arg, "--width") == 0) {
+            a_options->width = std::atoi(value);
+        } else if (std::strcmp(arg, "--height") == 0) {
+            a_options->height = std::atoi(value);
+        } else if (std::strcmp(arg, "--timeout") == 0) {
+            a_options->timeout = std::atof(value);
+        } else if (std::strcmp(arg, "--stats") == 0) {
+            a_options->statsFile = value;
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            a_options->traceFile = value;
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+    }
+
+    return !a_options->stage.empty() && a_options->samples >= 0
+           && a_options->width > 0 && a_options->height > 0;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    _Options options;
+    if (!_ParseOptions(argc, argv, &options)) {
+        std::fprintf(stderr,
+                     "Usage: %s <stage> [--camera PATH] [--samples N] "
+                     "[--width N] [--height N] [--timeout S] [--stats FILE] "
+                     "[--trace FILE]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    // Read by the delegate config when the render delegate is created
+    if (options.samples > 0)
+        TfSetenv("HD_CYCLES_MAX_SAMPLES", TfStringify(options.samples));
+    if (!options.statsFile.empty())
+        TfSetenv("HD_CYCLES_RENDER_STATS_FILE", options.statsFile);
+    if (!options.traceFile.empty())
+        TfSetenv("HD_CYCLES_TRACE_FILE", options.traceFile);
+
+    TfStopwatch open;
+    open.Start();
+    UsdStageRefPtr stage = UsdStage::Open(options.stage);
+    open.Stop();
+    if (!stage) {
+        std::fprintf(stderr, "Couldn't open %s\n", options.stage.c_str());
+        return 1;
+    }
+
+    const SdfPath cameraPath = _FindCamera(stage, options.camera);
+    if (cameraPath.IsEmpty()) {
+        std::fprintf(stderr, "%s has no camera\n", options.stage.c_str());
+        return 1;
+    }
+
+    HdRendererPluginRegistry& registry
+        = HdRendererPluginRegistry::GetInstance();
+    HdRendererPlugin* plugin = registry.GetRendererPlugin(
+        TfToken("HdCyclesRendererPlugin"));
+    if (!plugin) {
+        std::fprintf(stderr, "Couldn't load HdCyclesRendererPlugin, check "
+                             "PXR_PLUGINPATH_NAME\n");
+        return 1;
+    }
+
+    TfStopwatch total;
+    total.Start();
+
+    HdRenderDelegate* renderDelegate = plugin->CreateRenderDelegate();
+    int result                       = 0;
+    {
+        std::unique_ptr<HdRenderIndex> renderIndex(
+#if PXR_VERSION >= 2008
+            HdRenderIndex::New(renderDelegate, HdDriverVector()));
+#else
+            HdRenderIndex::New(renderDelegate));
+#endif
+
+        UsdImagingDelegate sceneDelegate(renderIndex.get(),
+                                         SdfPath::AbsoluteRootPath());
+
+        TfStopwatch populate;
+        populate.Start();
+        sceneDelegate.Populate(stage->GetPseudoRoot());
+        sceneDelegate.SetTime(UsdTimeCode::EarliestTime());
+        populate.Stop();
+
+        const SdfPath cameraId = sceneDelegate.ConvertCachePathToIndexPath(
+            cameraPath);
+        const HdCamera* camera = dynamic_cast<const HdCamera*>(
+            renderIndex->GetSprim(HdPrimTypeTokens->camera, cameraId));
+
+        const SdfPath colorId("/hdCyclesStageBenchmark/color");
+        HdRenderBuffer* color = dynamic_cast<HdRenderBuffer*>(
+            renderDelegate->CreateBprim(HdPrimTypeTokens->renderBuffer,
+                                        colorId));
+
+        if (!camera || !color) {
+            std::fprintf(stderr, "Couldn't set up camera %s\n",
+                         cameraPath.GetText());
+            result = 1;
+        } else {
+            color->Allocate(GfVec3i(options.width, options.height, 1),
+                            HdFormatFloat32Vec4, false);
+
+            HdRenderPassAovBinding binding;
+            binding.aovName        = HdAovTokens->color;
+            binding.renderBuffer   = color;
+            binding.renderBufferId = colorId;
+            binding.clearValue     = VtValue(GfVec4f(0.0f));
+
+            HdRenderPassStateSharedPtr renderPassState
+                = std::make_shared<HdRenderPassState>();
+            renderPassState->SetCameraAndViewport(
+                camera, GfVec4d(0.0, 0.0, options.width, options.height));
+            renderPassState->SetAovBindings({ binding });
+
+            HdRprimCollection collection(HdTokens->geometry,
+                                         HdReprSelector(
+                                             HdReprTokens->smoothHull));
+            HdRenderPassSharedPtr renderPass
+                = renderDelegate->CreateRenderPass(renderIndex.get(),
+                                                   collection);
+            HdTaskSharedPtrVector tasks = { std::make_shared<_RenderTask>(
+                renderPass, renderPassState) };
+
+            HdEngine engine;
+
+            TfStopwatch firstSync;
+            firstSync.Start();
+            engine.Execute(renderIndex.get(), &tasks);
+            firstSync.Stop();
+
+            // Polled like a viewer would until the samples are done
+            TfStopwatch render;
+            render.Start();
+            while (!renderPass->IsConverged()) {
+                render.Stop();
+                if (options.timeout > 0.0
+                    && render.GetSeconds() >= options.timeout) {
+                    std::fprintf(stderr, "Timed out after %g s\n",
+                                 options.timeout);
+                    result = 2;
+                    break;
+                }
+                render.Start();
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                engine.Execute(renderIndex.get(), &tasks);
+            }
+            render.Stop();
+
+            const VtDictionary stats = renderDelegate->GetRenderStats();
+            const double samples     = _GetStat(stats,
+                                            "hdcycles:render:current_sample");
+            const double renderTime  = _GetStat(stats, "hdcycles:render:time");
+
+            std::printf("Stage:          %s\n", options.stage.c_str());
+            std::printf("Camera:         %s\n", cameraPath.GetText());
+            std::printf("Open:           %10.4f s\n", open.GetSeconds());
+            std::printf("Populate:       %10.4f s\n", populate.GetSeconds());
+            std::printf("First Execute:  %10.4f s\n", firstSync.GetSeconds());
+            std::printf("First sync:     %10.4f s\n",
+                        _GetStat(stats, "hdcycles:time:first_sync"));
+            std::printf("First pixel:    %10.4f s\n",
+                        _GetStat(stats, "hdcycles:time:first_pixel"));
+            std::printf("Kernel load:    %10.4f s\n",
+                        _GetStat(stats, "hdcycles:time:kernel_load"));
+            std::printf("BVH and upload: %10.4f s\n",
+                        _GetStat(stats, "hdcycles:time:scene_update"));
+            std::printf("Render:         %10.4f s, %.0f samples\n",
+                        render.GetSeconds(), samples);
+            std::printf("Samples/s:      %10.4f\n",
+                        renderTime > 0.0 ? samples / renderTime : 0.0);
+            std::printf("Pixel samples/s:%10.0f\n",
+                        _GetStat(stats,
+                                 "hdcycles:render:pixel_samples_per_second"));
+            std::printf("Peak RSS:       %10.1f MB\n",
+                        _GetStat(stats, "hdcycles:memory:process_peak")
+                            / (1024.0 * 1024.0));
+        }
+
+        // The session stops drawing into the color buffer before it goes,
+        // as when a viewer tears down its render index
+        if (color) {
+            renderDelegate->Pause();
+            renderDelegate->DestroyBprim(color);
+        }
+    }
+
+    // Writes the stats and trace files
+    plugin->DeleteRenderDelegate(renderDelegate);
+    registry.ReleasePlugin(plugin);
+
+    total.Stop();
+    std::printf("Total:          %10.4f s\n", total.GetSeconds());
+
+    return result;
+}